@@ -0,0 +1,78 @@
+#ifndef ACCESS_FORMULA_H
+#define ACCESS_FORMULA_H
+
+#include "SymEngine/CompiledExpression.h"
+#include "SymEngine/HardwareConfig.h"
+#include "SymEngine/SubscriptCompiler.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace SymEngine {
+
+class NDRangeSpace;
+class ThreadPool;
+
+// Trip count of the loops whose trip count cannot be resolved.
+const int DEFAULT_LOOP_TRIP_COUNT = 1024;
+
+// -----------------------------------------------------------------------------
+// Memory access of a kernel compiled with the integer kernel arguments left
+// symbolic. The expressions are bound neither to the arguments nor to the
+// NDRange, so the access can be counted for any of them without LLVM.
+struct AccessFormula {
+  bool isLoad;
+  // Local accesses count bank conflicts, the others transactions.
+  bool isLocal;
+  CompiledExpression subscript;
+  std::vector<CompiledCondition> blockConditions;
+  // Multiplier of the count: the trip count of the enclosing loop, 1 outside
+  // loops.
+  CompiledExpression tripCount;
+};
+
+struct KernelFormulas {
+  std::string kernelName;
+  // In the order of the instructions of the kernel.
+  std::vector<AccessFormula> accesses;
+};
+
+// Counters of the memory operations of a kernel, 1 entry per operation in
+// the order of the visit.
+struct KernelResults {
+  std::vector<int> loadTransactions;
+  std::vector<int> storeTransactions;
+
+  std::vector<int> loadBankConflicts;
+  std::vector<int> storeBankConflicts;
+
+  // When sampling the NDRange, half widths of the 95% confidence intervals of
+  // the results above.
+  bool sampling;
+  std::vector<int> loadTransactionsError;
+  std::vector<int> storeTransactionsError;
+  std::vector<int> loadBankConflictsError;
+  std::vector<int> storeBankConflictsError;
+};
+
+// Count the transactions or the bank conflicts of the access over the whole
+// NDRange, for the given values of the integer kernel arguments. Returns -1
+// if the subscript cannot be computed.
+int evaluateAccessFormula(const AccessFormula &formula,
+                          const std::vector<int64_t> &arguments,
+                          const NDRangeSpace *ndrSpace,
+                          const HardwareConfig &hwConfig,
+                          ThreadPool &threadPool);
+
+// Counters of all the accesses of the kernel, as computed by
+// evaluateAccessFormula(). Accesses that cannot be computed count -1.
+KernelResults evaluateKernelFormulas(const KernelFormulas &kernel,
+                                     const std::vector<int64_t> &arguments,
+                                     const NDRangeSpace *ndrSpace,
+                                     const HardwareConfig &hwConfig,
+                                     ThreadPool &threadPool);
+
+}
+
+#endif
@@ -1,6 +1,8 @@
 #ifndef BLOCK_MASK_H
 #define BLOCK_MASK_H
 
+#include "SymEngine/Utils.h"
+
 #include "llvm/Analysis/ScalarEvolution.h"
 
 #include "llvm/IR/Instructions.h"
@@ -98,7 +100,7 @@ public:
     case llvm::CmpInst::ICMP_SGT:
       return se->isKnownPositive(scev);
     case llvm::CmpInst::ICMP_SGE:
-      return se->isKnownPositive(scev);
+      return se->isKnownNonNegative(scev);
     case llvm::CmpInst::ICMP_SLT:
       return se->isKnownNegative(scev);
     case llvm::CmpInst::ICMP_SLE:
@@ -109,6 +111,71 @@ public:
     return false;
   }
 
+  // Same as above for a condition that has been already evaluated to an
+  // integer.
+  static bool getBooleanValue(int64_t value,
+                              llvm::CmpInst::Predicate predicate) {
+    switch (predicate) {
+    case llvm::CmpInst::FCMP_FALSE:
+      return false;
+    case llvm::CmpInst::FCMP_OEQ:
+      return value == 0;
+    case llvm::CmpInst::FCMP_OGT:
+      return value > 0;
+    case llvm::CmpInst::FCMP_OGE:
+      return value >= 0;
+    case llvm::CmpInst::FCMP_OLT:
+      return value < 0;
+    case llvm::CmpInst::FCMP_OLE:
+      return value <= 0;
+    case llvm::CmpInst::FCMP_ONE:
+      return value != 0;
+    case llvm::CmpInst::FCMP_ORD:
+      return false;
+    case llvm::CmpInst::FCMP_UNO:
+      return false;
+    case llvm::CmpInst::FCMP_UEQ:
+      return value == 0;
+    case llvm::CmpInst::FCMP_UGT:
+      return value > 0;
+    case llvm::CmpInst::FCMP_UGE:
+      return value >= 0;
+    case llvm::CmpInst::FCMP_ULT:
+      return value < 0;
+    case llvm::CmpInst::FCMP_ULE:
+      return value <= 0;
+    case llvm::CmpInst::FCMP_UNE:
+      return value != 0;
+    case llvm::CmpInst::FCMP_TRUE:
+      return true;
+    case llvm::CmpInst::BAD_FCMP_PREDICATE:
+      return false;
+    case llvm::CmpInst::ICMP_EQ:
+      return value == 0;
+    case llvm::CmpInst::ICMP_NE:
+      return value != 0;
+    // The difference of the operands does not decide unsigned comparisons:
+    // BlockMask turns them into equalities, and any other one cannot be
+    // computed, hence false.
+    case llvm::CmpInst::ICMP_UGT:
+    case llvm::CmpInst::ICMP_UGE:
+    case llvm::CmpInst::ICMP_ULT:
+    case llvm::CmpInst::ICMP_ULE:
+      return false;
+    case llvm::CmpInst::ICMP_SGT:
+      return value > 0;
+    case llvm::CmpInst::ICMP_SGE:
+      return value >= 0;
+    case llvm::CmpInst::ICMP_SLT:
+      return value < 0;
+    case llvm::CmpInst::ICMP_SLE:
+      return value <= 0;
+    case llvm::CmpInst::BAD_ICMP_PREDICATE:
+      return false;
+    };
+    return false;
+  }
+
 private:
   const llvm::SCEV *scev;
   llvm::CmpInst::Predicate predicate;
@@ -127,6 +194,10 @@ public:
   void createMasks();
   void dump();
   std::vector<BlockCondition> getConditions(llvm::BasicBlock *block);
+  // All the blocks whose branch controls block, directly or transitively,
+  // with the successor leading to block: true if it is the one taken when
+  // the branch condition holds.
+  std::vector<BlockBranchPair> getControllers(llvm::BasicBlock *block);
 
 public:
   static bool getBooleanValue(llvm::CmpInst::Predicate predicate);
@@ -139,6 +210,7 @@ private:
   ControlDependenceAnalysis *cdGraph;
   llvm::ScalarEvolution *scalarEvolution;
   std::map<llvm::BasicBlock *, std::vector<BlockCondition>> blocksMask;
+  std::map<llvm::BasicBlock *, std::vector<BlockBranchPair>> blocksControllers;
 };
 }
 
@@ -0,0 +1,154 @@
+#ifndef COMPILED_EXPRESSION_H
+#define COMPILED_EXPRESSION_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace SymEngine {
+
+class NDRangePoint;
+class NDRangeSpace;
+
+// -----------------------------------------------------------------------------
+// Affine function of the coordinates of a work-item:
+// constant + sum(coefficients[i] * coordinate[i]).
+// Coordinates are indexed as CompiledExpression::getCoordinateIndex().
+struct AffineForm {
+  static constexpr int COORDINATE_NUMBER = 9;
+
+  AffineForm();
+  explicit AffineForm(int64_t constant);
+
+  bool isConstant() const;
+  int64_t evaluate(const NDRangePoint &point) const;
+
+  int64_t constant;
+  int64_t coefficients[COORDINATE_NUMBER];
+};
+
+// -----------------------------------------------------------------------------
+// Integer expression over the coordinates of a work-item and the sizes of the
+// NDRange. It is built once from a SCEV by SubscriptCompiler and then
+// evaluated for every work-item with plain integer arithmetic.
+// The expression is stored in postfix order.
+class CompiledExpression {
+public:
+  enum OpCode {
+    CONSTANT,
+    // Coordinates. The node value is the direction.
+    LOCAL_ID,
+    GLOBAL_ID,
+    GROUP_ID,
+    // Sizes. The node value is the direction.
+    LOCAL_SIZE,
+    GLOBAL_SIZE,
+    GROUPS_NUMBER,
+    // Integer kernel argument left symbolic. The node value is the index of
+    // the argument among the integer arguments of the kernel.
+    ARGUMENT,
+    // Operations. The node value is the number of operands.
+    ADD,
+    MUL,
+    // Divisions and remainders follow the LLVM instructions: UDIV and UREM
+    // take their operands as unsigned, SDIV rounds towards zero.
+    UDIV,
+    SDIV,
+    UREM,
+    SMAX,
+    UMAX
+  };
+
+  struct Node {
+    OpCode opCode;
+    int64_t value;
+  };
+
+  // How the value of an expression changes across the work-items.
+  enum Uniformity {
+    // Same value for all the work-items.
+    UNIFORM,
+    // Depends only on the group: same value for all the lanes of a group.
+    GROUP_UNIFORM,
+    // Depends on the local or global id of the work-item.
+    VARYING
+  };
+
+public:
+  CompiledExpression();
+  static CompiledExpression createConstant(int64_t value);
+  static CompiledExpression createUnknown();
+
+public:
+  void appendConstant(int64_t value);
+  void appendCoordinate(OpCode opCode, int direction);
+  void appendSize(OpCode opCode, int direction);
+  void appendOperation(OpCode opCode, int operandNumber);
+  void appendArgument(int argumentIndex);
+  // Append all the nodes of expression, as a single operand.
+  void appendExpression(const CompiledExpression &expression);
+  void setUnknown();
+
+  // An expression is not computable if any of its leaves could not be
+  // resolved to a coordinate, a size, a kernel argument or a constant.
+  bool isComputable() const;
+  bool isAffine() const;
+  const AffineForm &getAffineForm() const;
+  const std::vector<Node> &getNodes() const;
+  Uniformity getUniformity() const;
+
+  // Replace the symbolic kernel arguments with their values. The result is
+  // unknown if an argument has no value.
+  CompiledExpression bindArguments(const std::vector<int64_t> &arguments) const;
+
+  // Replace the sizes with the values in ndrSpace, fold constants and compute
+  // the affine form of the expression, when it exists. Expressions with
+  // symbolic kernel arguments must be bound to the arguments first, otherwise
+  // the result is unknown.
+  CompiledExpression bind(const NDRangeSpace &ndrSpace) const;
+
+  // Specialize the expression to the work-items of the given group: group ids
+  // become constants and global ids become local ids plus a constant offset.
+  // The group-uniform parts of the expression are folded, so that only the
+  // parts depending on the local id are left to evaluate for every lane.
+  CompiledExpression specialize(const NDRangeSpace &ndrSpace, int groupX,
+                                int groupY, int groupZ) const;
+
+  // Evaluate the bound expression for the given work-item. Returns false if
+  // the expression is not computable or a division by zero happens.
+  bool evaluate(const NDRangePoint &point, int64_t &result) const;
+
+  void dump() const;
+
+  // Textual form of the expression, one token per node in postfix order:
+  // integer constants, coordinates and sizes as lid0, gid0, grp0, lsz0, gsz0,
+  // ngr0, kernel arguments as arg0 and operations as add2, mul2, udiv2,
+  // sdiv2, urem2, smax2, umax2, where the number is the direction, the argument
+  // index or the number of operands. Unknown expressions are "unknown".
+  std::string toString() const;
+  // Parse the textual form of an expression. Returns false if text is
+  // malformed.
+  static bool parse(const std::string &text, CompiledExpression &result);
+
+public:
+  static int getCoordinateIndex(OpCode opCode, int direction);
+  static bool isCoordinate(OpCode opCode);
+  static bool isSize(OpCode opCode);
+  static bool isOperation(OpCode opCode);
+  static bool isCommutative(OpCode opCode);
+  static bool applyOperation(OpCode opCode, const int64_t *operands,
+                             int operandNumber, int64_t &result);
+
+private:
+  void computeAffineForm();
+
+private:
+  std::vector<Node> nodes;
+  bool computable;
+  bool affine;
+  AffineForm affineForm;
+};
+
+}
+
+#endif
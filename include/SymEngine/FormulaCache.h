@@ -0,0 +1,74 @@
+#ifndef FORMULA_CACHE_H
+#define FORMULA_CACHE_H
+
+#include "SymEngine/AccessFormula.h"
+
+#include "llvm/Support/TimeValue.h"
+
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace SymEngine {
+
+// -----------------------------------------------------------------------------
+// Access formulas of the kernels of the modules analyzed so far, kept in
+// memory so that the kernels can be evaluated for any NDRange, arguments and
+// hardware without running LLVM again. A module is compiled the first time
+// it is requested and again when its file changes; the LLVM module itself is
+// released once compiled.
+// All the methods can be called concurrently. Modules are compiled without
+// holding the lock of the cache: a compilation only delays the requests for
+// the same module, which wait for its result. The formulas returned are
+// immutable and stay valid even if the module is compiled again.
+class FormulaCache {
+public:
+  explicit FormulaCache(unsigned int inlineThreshold);
+
+public:
+  // Formulas of kernelName in the module in fileName, or, if fileName is
+  // empty, in the module loaded last among those defining it whose
+  // compilation is over. Returns null and sets error if the module cannot be
+  // read or has no such kernel.
+  std::shared_ptr<const KernelFormulas>
+  getKernel(const std::string &fileName, const std::string &kernelName,
+            std::string &error);
+
+private:
+  typedef std::vector<KernelFormulas> ModuleFormulas;
+
+  // Result of the compilation of a module: null kernels and an error if it
+  // cannot be read. Errors are kept until the file changes.
+  struct CompiledModule {
+    std::shared_ptr<const ModuleFormulas> kernels;
+    std::string error;
+  };
+
+  struct Entry {
+    llvm::sys::TimeValue modificationTime;
+    // Ready once the compilation is over.
+    std::shared_future<CompiledModule> compilation;
+    // Position of the module in the order of the loads.
+    unsigned int loadIndex;
+  };
+
+private:
+  std::shared_ptr<const ModuleFormulas> getModule(const std::string &fileName,
+                                                  std::string &error);
+  // Called with the mutex locked.
+  std::shared_ptr<const ModuleFormulas>
+  findLastModule(const std::string &kernelName) const;
+
+private:
+  unsigned int inlineThreshold;
+  std::mutex mutex;
+  std::map<std::string, Entry> modules;
+  unsigned int loadNumber;
+};
+
+}
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef GROUP_REGIONS_H
+#define GROUP_REGIONS_H
+
+#include <cstdint>
+#include <vector>
+
+namespace SymEngine {
+
+class CompiledExpression;
+class NDRangeSpace;
+struct CompiledCondition;
+
+// -----------------------------------------------------------------------------
+// Box of groups of the NDRange: begin[direction] <= group < end[direction].
+// Groups of the region at a multiple of period[direction] from each other
+// along every direction have the same count.
+struct GroupRegion {
+  int begin[3];
+  int end[3];
+  int period[3];
+
+  long getGroupNumber() const;
+  // Groups that have to be simulated: the first period[direction] groups of
+  // the region along every direction.
+  long getRepresentativeNumber() const;
+  // Number of groups of the region with the same count as the group at the
+  // given offsets from begin, all smaller than the period.
+  long getMultiplicity(const int *offsets) const;
+};
+
+// -----------------------------------------------------------------------------
+// Partition the group grid in regions whose groups have periodic counts of
+// transactions or bank conflicts for an access, so that only the groups of
+// one period of each region have to be simulated. This counts the groups of
+// each region by the residue class of their addresses (see
+// getTranslationPeriod()), instead of enumerating them.
+// A region is periodic when, along each direction it spans:
+// - every block condition either does not depend on the group or has the
+//   same value for all the work-items of the region;
+// - the subscript either does not depend on the group, or it is affine and
+//   non negative over the whole region. If it moves by c from one group to
+//   the next, the period along the direction is period / gcd(c, period).
+// Regions are found by splitting the grid in halves until they are periodic,
+// down to single groups: accesses that are not affine are enumerated.
+std::vector<GroupRegion>
+findPeriodicRegions(const CompiledExpression &subscript,
+                     const std::vector<CompiledCondition> &blockConditions,
+                     const NDRangeSpace &ndrSpace, int64_t period);
+
+}
+
+#endif
@@ -0,0 +1,76 @@
+#ifndef GROUP_SAMPLER_H
+#define GROUP_SAMPLER_H
+
+#include <functional>
+#include <vector>
+
+namespace SymEngine {
+
+class NDRangeSpace;
+
+// -----------------------------------------------------------------------------
+// A warp of the NDRange, picked by the sampler.
+struct SamplingUnit {
+  int groupX;
+  int groupY;
+  int groupZ;
+  int warpIndex;
+};
+
+// -----------------------------------------------------------------------------
+// Estimated total with the half width of its confidence interval.
+struct SampledEstimate {
+  double total;
+  double halfWidth;
+  long sampledUnits;
+  long populationSize;
+};
+
+// -----------------------------------------------------------------------------
+// Estimate totals over all the warps of the NDRange by stratified random
+// sampling. Groups are split in three strata: interior groups, groups on an
+// edge of the group grid and groups on a corner. Warps are sampled without
+// replacement in rounds, until the confidence interval of the estimate is
+// within the requested relative error.
+class GroupSampler {
+public:
+  enum Stratum { INTERIOR, EDGE, CORNER, STRATA_NUMBER };
+
+  // Confidence level of the intervals: 95%.
+  static constexpr double CONFIDENCE_Z = 1.96;
+  // Minimum number of warps sampled from each non-empty stratum, needed to
+  // estimate its variance.
+  static constexpr long MIN_STRATUM_SAMPLE = 2;
+  // Number of warps sampled in the first round.
+  static constexpr long INITIAL_SAMPLE = 64;
+
+  // Fill values with the value of each unit.
+  typedef std::function<void(const std::vector<SamplingUnit> &units,
+                             std::vector<int> &values)> UnitEvaluator;
+
+public:
+  GroupSampler(const NDRangeSpace *ndrSpace, int warpsPerGroup,
+               double relativeError, unsigned int seed);
+
+public:
+  SampledEstimate estimateTotal(const UnitEvaluator &evaluator) const;
+  long getStratumSize(Stratum stratum) const;
+
+  static Stratum getStratum(const NDRangeSpace *ndrSpace, int groupX,
+                            int groupY, int groupZ);
+
+private:
+  SamplingUnit getUnit(Stratum stratum, long index) const;
+
+private:
+  const NDRangeSpace *ndrSpace;
+  int warpsPerGroup;
+  double relativeError;
+  unsigned int seed;
+  // Linear indices of the groups in each stratum.
+  std::vector<int> strata[STRATA_NUMBER];
+};
+
+}
+
+#endif
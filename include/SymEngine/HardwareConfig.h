@@ -1,6 +1,8 @@
 #ifndef HARDWARE_CONFIG_H
 #define HARDWARE_CONFIG_H
 
+#include <string>
+
 namespace SymEngine {
 
 struct HardwareConfig {
@@ -10,6 +12,12 @@ struct HardwareConfig {
   int cacheLineSize;
 };
 
+// Hardware configuration named in the output, when several are compared.
+struct HardwareProfile {
+  std::string name;
+  HardwareConfig config;
+};
+
 }
 
 #endif
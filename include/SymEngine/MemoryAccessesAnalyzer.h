@@ -3,24 +3,70 @@
 
 #include "llvm/Analysis/ScalarEvolution.h"
 
+#include <cstdint>
 #include <vector>
 
 namespace SymEngine {
 
 struct HardwareConfig;
 
+// Largest number of banks handled by the fixed-size bank histogram. Larger
+// configurations use a slower path.
+const int MAX_BANKS_NUMBER = 64;
+
 int computeTransactionNumberImpl(const std::vector<int> indices,
                                  const SymEngine::HardwareConfig &hwConfig);
+// Same as above, for a flat buffer of at most
+// LaneCoordinates::MAX_LANE_NUMBER addresses.
+int computeTransactionNumberImpl(const int64_t *addresses, int addressNumber,
+                                 const SymEngine::HardwareConfig &hwConfig);
+// Compute the transactions of warpNumber warps in one call, with the same
+// buffer layout as computeBankConflictNumbers().
+void computeTransactionNumbers(const int64_t *addresses,
+                               const uint64_t *activeMasks, int laneNumber,
+                               int warpNumber,
+                               const SymEngine::HardwareConfig &hwConfig,
+                               int *results);
 int computeTransactionNumber(const std::vector<const llvm::SCEV *> &scevs,
                              const SymEngine::HardwareConfig &hwConfig,
                              llvm::ScalarEvolution *se);
 
 int computeBankConflictNumberImpl(const std::vector<int> indices,
                                   const SymEngine::HardwareConfig &hwConfig);
+int computeBankConflictNumberImpl(const int64_t *addresses, int addressNumber,
+                                  const SymEngine::HardwareConfig &hwConfig);
+// Compute the bank conflicts of warpNumber warps in one call.
+// addresses[warp * laneNumber + lane] is the address of a lane and only the
+// lanes in activeMasks[warp] are considered. The result for each warp is
+// written in results[warp].
+void computeBankConflictNumbers(const int64_t *addresses,
+                                const uint64_t *activeMasks, int laneNumber,
+                                int warpNumber,
+                                const SymEngine::HardwareConfig &hwConfig,
+                                int *results);
 int computeBankConflictNumber(const std::vector<const llvm::SCEV *> &scevs,
                               const SymEngine::HardwareConfig &hwConfig,
                               llvm::ScalarEvolution *se);
 
+// Same results as the Impl functions for the addresses base + stride * lane of
+// the lanes in activeMask. When the active lanes are contiguous and all the
+// addresses are non negative the counts are computed analytically: O(1) for
+// transactions and O(banksNumber) for bank conflicts. Otherwise the addresses
+// are enumerated.
+int computeStridedTransactionNumber(int64_t base, int64_t stride,
+                                    int laneNumber, uint64_t activeMask,
+                                    const SymEngine::HardwareConfig &hwConfig);
+int computeStridedBankConflictNumber(int64_t base, int64_t stride,
+                                     int laneNumber, uint64_t activeMask,
+                                     const SymEngine::HardwareConfig &hwConfig);
+
+// Shifting non negative addresses by a multiple of the period changes neither
+// their transactions nor their bank conflicts: cache lines, bank rows and
+// bank columns are all shifted together.
+int64_t getTranslationPeriod(const SymEngine::HardwareConfig &hwConfig);
+
+int64_t greatestCommonDivisor(int64_t first, int64_t second);
+
 }
 
 #endif
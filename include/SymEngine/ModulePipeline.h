@@ -0,0 +1,51 @@
+#ifndef MODULE_PIPELINE_H
+#define MODULE_PIPELINE_H
+
+#include "SymEngine/AccessFormula.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace llvm {
+class LLVMContext;
+class Module;
+class Pass;
+}
+
+namespace SymEngine {
+
+// Inline threshold of scripts/symEngine.sh: all the calls of the kernels are
+// inlined.
+const unsigned int DEFAULT_INLINE_THRESHOLD = 10000;
+
+// -----------------------------------------------------------------------------
+// In-process version of the opt pipeline of scripts/symEngine.sh, for the
+// executables linking the passes. initializePipeline() must be called once
+// before any other function.
+void initializePipeline();
+
+// Parse the LLVM IR or bitcode in fileName. Returns null and sets error if it
+// cannot be read.
+std::unique_ptr<llvm::Module> loadModule(const std::string &fileName,
+                                         llvm::LLVMContext &context,
+                                         std::string &error);
+// Same as above for IR or bitcode held in memory.
+std::unique_ptr<llvm::Module> parseModule(const std::string &text,
+                                          llvm::LLVMContext &context,
+                                          std::string &error);
+
+// Run mem2reg, inline and instnamer on module, then pass, which is owned by
+// the pipeline.
+void runPipeline(llvm::Module &module, llvm::Pass *pass,
+                 unsigned int inlineThreshold = DEFAULT_INLINE_THRESHOLD);
+
+// Access formulas of all the kernels of module, in the order of the module.
+// The module goes through the pipeline above; no config file is read.
+std::vector<KernelFormulas>
+compileModuleFormulas(llvm::Module &module,
+                      unsigned int inlineThreshold = DEFAULT_INLINE_THRESHOLD);
+
+}
+
+#endif
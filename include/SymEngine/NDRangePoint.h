@@ -1,8 +1,8 @@
 #ifndef NDRANGE_POINT_H
 #define NDRANGE_POINT_H
 
+#include <array>
 #include <string>
-#include <vector>
 
 namespace SymEngine {
 
@@ -35,9 +35,10 @@ public:
   std::string toString() const;
 
 private:
-  std::vector<int> local;
-  std::vector<int> global;
-  std::vector<int> group;
+  // Fixed storage: points are trivially copyable and never allocate.
+  std::array<int, 3> local;
+  std::array<int, 3> global;
+  std::array<int, 3> group;
 };
 
 }
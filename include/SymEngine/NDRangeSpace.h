@@ -25,6 +25,7 @@ public:
   int getNumberOfGroupsZ() const;
 
   int getGroupSize() const;
+  int getTotalNumberOfGroups() const;
 
   int getLocalSize(int direction) const;
   int getGlobalSize(int direction) const;
@@ -0,0 +1,74 @@
+#ifndef NDRANGE_SWEEP_H
+#define NDRANGE_SWEEP_H
+
+#include "SymEngine/AccessFormula.h"
+#include "SymEngine/HardwareConfig.h"
+#include "SymEngine/NDRangeSpace.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace llvm {
+class raw_ostream;
+}
+
+namespace SymEngine {
+
+class ThreadPool;
+
+// Values of a size in one direction: the list values, or, if it is empty,
+// the powers of two from min to max.
+struct SweepDimension {
+  std::vector<int> values;
+  int min;
+  int max;
+
+  std::vector<int> getValues() const;
+};
+
+// -----------------------------------------------------------------------------
+// NDRanges to compare, as read from the sweep file: every combination of the
+// local sizes of the three directions, with either a fixed global size or
+// every combination of the numbers of groups. Directions left empty have size
+// 1.
+struct SweepConfig {
+  SweepDimension localSize[3];
+  // The number of groups is the global size over the local size: local sizes
+  // not dividing it are skipped.
+  std::vector<int> globalSize;
+  SweepDimension numberOfGroups[3];
+  // Groups with more work-items are skipped, 0 means no limit.
+  int maxGroupSize;
+};
+
+struct SweepCandidate {
+  NDRangeSpace ndrSpace;
+  KernelResults results;
+  // Sums over the accesses of the kernel whose subscript is known.
+  int64_t transactions;
+  int64_t bankConflicts;
+  int unknownAccesses;
+};
+
+// NDRanges of config, in the order of the file.
+std::vector<SweepCandidate> createSweepCandidates(const SweepConfig &config);
+
+// Evaluate the compiled kernel for all the candidates in parallel, then sort
+// them from the best to the worst: fewest transactions first, then fewest
+// bank conflicts. Candidates with unknown accesses are last. Candidates whose
+// group size is not a multiple of the warp size cannot be simulated and are
+// removed.
+void evaluateSweep(const KernelFormulas &kernel,
+                   const std::vector<int64_t> &arguments,
+                   const HardwareConfig &hwConfig, ThreadPool &threadPool,
+                   std::vector<SweepCandidate> &candidates);
+
+// One line per candidate, in the order of the vector.
+void printSweepTable(const std::string &kernelName,
+                     const std::vector<SweepCandidate> &candidates,
+                     llvm::raw_ostream &out);
+
+}
+
+#endif
@@ -15,10 +15,18 @@ class Value;
 
 namespace SymEngine {
 
+class GroupSampler;
 class NDRange;
 class NDRangeSpace;
 class Warp;
+class WarpFactory;
 
+// -----------------------------------------------------------------------------
+// Configuration of the kernel execution: hardware, NDRange, kernel arguments
+// and warps to simulate. It is immutable once constructed, so a single
+// instance can be shared by all the analyses and worker threads through a
+// std::shared_ptr<const OCLEnv>; all the accessors return references to the
+// shared data instead of copies.
 class OCLEnv {
 
 public:
@@ -32,17 +40,40 @@ public:
   OCLEnv(llvm::Function &function, const NDRange *ndRange);
   OCLEnv(llvm::Function &function, const NDRange *ndRange,
          SymEngine::HardwareConfig hwConfig);
-  OCLEnv(OCLEnv &&oclEnv);
+  // Environment given by the caller instead of the config files and the
+  // command line: the integer kernel arguments are symbolic and the whole
+  // NDRange is simulated on one thread. Used to compile access formulas.
+  OCLEnv(llvm::Function &function, const NDRange *ndRange,
+         const NDRangeSpace &ndrSpace, SymEngine::HardwareConfig hwConfig);
 
 public:
   const NDRange *getNDRange() const;
   const NDRangeSpace *getNDRangeSpace() const;
   int resolveValue(llvm::Value *) const;
+  // True if the integer kernel arguments are left symbolic: their values are
+  // not read and subscripts refer to them by index.
+  bool hasSymbolicArguments() const;
+  // Index of the integer kernel argument among the integer arguments of the
+  // kernel, -1 if value is not one of them.
+  int getArgumentIndex(llvm::Value *value) const;
 
-  const SymEngine::HardwareConfig getHWConfig() const;
-  void setHWConfig(SymEngine::HardwareConfig hwConfig);
+  const SymEngine::HardwareConfig &getHWConfig() const;
 
-  std::vector<Warp> getWarps() const;
+  const std::vector<Warp> &getWarps() const;
+  WarpFactory getWarpFactory() const;
+  // True if all the groups of the NDRange have to be simulated. In this case
+  // getWarps() is empty and the warps are created with getWarpFactory().
+  bool isNDRangeSimulation() const;
+  // True if the NDRange totals have to be estimated by sampling the warps with
+  // getGroupSampler().
+  bool isNDRangeSampling() const;
+  GroupSampler getGroupSampler() const;
+  // Number of threads for the simulation, 0 means one per hardware thread.
+  unsigned int getThreadNumber() const;
+  // Text identifying the NDRange, the hardware, the warps and the simulation
+  // options: the counts of a kernel depend on nothing else but its IR and
+  // its arguments.
+  std::string getConfigurationKey() const;
     
 private:
   void setupHWConfig();
@@ -53,7 +84,13 @@ private:
   // ndRange is not a owning ptr.
   const NDRange *ndRange;
   std::vector<Warp> warps;
-  std::unique_ptr<NDRangeSpace> ndRangeSpace;
+  // Warps, factories and samplers point to the NDRange space.
+  std::shared_ptr<const NDRangeSpace> ndRangeSpace;
+  bool ndRangeSimulation;
+  bool ndRangeSampling;
+  unsigned int threadNumber;
+  bool symbolicArguments;
+  // Value of each integer argument, or its index if arguments are symbolic.
   std::map<llvm::Value *, int> argumentMap;
 
   SymEngine::HardwareConfig hwConfig; 
@@ -0,0 +1,54 @@
+#ifndef RESULT_CACHE_H
+#define RESULT_CACHE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace SymEngine {
+
+// -----------------------------------------------------------------------------
+// Results of kernel runs stored on disk, so that a kernel analyzed again with
+// the same IR and the same configuration is not simulated again.
+// An entry is a file named after the MD5 hash of its key text, which holds
+// everything the results depend on. It is made of a fixed header followed by
+// the count and the error of each access, as native 32-bit integers, and is
+// read by mapping it in memory.
+// Entries are written to a temporary file renamed into place: processes
+// sharing the directory never read a partial entry, and concurrent writers of
+// the same key leave one of the identical copies. Hits refresh the
+// modification time of the entry; once the entries exceed the maximum size,
+// the least recently used are removed. A reader keeps the mapping of an entry
+// removed in the meantime.
+class ResultCache {
+public:
+  static const uint32_t FORMAT_VERSION;
+
+public:
+  // The directory is created if needed.
+  ResultCache(const std::string &directory, uint64_t maxSize);
+
+public:
+  // Returns false if there is no valid entry for key with accessNumber
+  // accesses.
+  bool lookup(const std::string &key, size_t accessNumber,
+              std::vector<int> &counts, std::vector<int> &errors) const;
+  // Failures to write are reported as warnings: the results are computed
+  // again next time.
+  void store(const std::string &key, const std::vector<int> &counts,
+             const std::vector<int> &errors) const;
+  // Path of the entry of key, whether it exists or not.
+  std::string getEntryPath(const std::string &key) const;
+
+private:
+  // Remove the least recently used entries until the others fit maxSize.
+  void evict() const;
+
+private:
+  std::string directory;
+  uint64_t maxSize;
+};
+
+}
+
+#endif
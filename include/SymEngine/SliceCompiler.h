@@ -0,0 +1,62 @@
+#ifndef SLICE_COMPILER_H
+#define SLICE_COMPILER_H
+
+#include "SymEngine/WarpEvaluator.h"
+
+#include <map>
+#include <memory>
+#include <set>
+#include <vector>
+
+namespace llvm {
+class ExecutionEngine;
+class Instruction;
+class Value;
+}
+
+namespace SymEngine {
+
+class BlockMask;
+class OCLEnv;
+
+// -----------------------------------------------------------------------------
+// Compile the accesses whose subscript or block conditions ScalarEvolution
+// cannot express to native WarpSlices with MCJIT.
+// The backward slice of the pointer and of the branch conditions controlling
+// the block of the access is copied into a new function, which runs it for
+// every lane of a warp: OpenCL coordinates are read from the LaneCoordinates,
+// sizes and integer kernel arguments become the constants given in OCLEnv and
+// the base pointer, a pointer argument or a global array like a __local
+// array, becomes null, so that the address computed is the offset relative to
+// it, as in SubscriptCompiler. Other constants referring to globals of the
+// kernel module are not supported.
+// Only slices made of integer arithmetic, casts, comparisons, selects and
+// GEPs are supported; slices reading memory or crossing phi nodes are not
+// compiled and the access is left to the expression-based simulation.
+// Available only when built with SYM_ENGINE_JIT.
+class SliceCompiler {
+public:
+  SliceCompiler(const OCLEnv &ocl, BlockMask &blockMask);
+  ~SliceCompiler();
+
+public:
+  // Returns nullptr if the slice of the access of inst to pointer cannot be
+  // compiled. The slice lives as long as the compiler.
+  WarpSlice compile(llvm::Instruction *inst, llvm::Value *pointer);
+
+private:
+  // Append to slice the instructions value depends on, operands first.
+  // Returns false if any of them is not supported.
+  bool collectSlice(llvm::Value *value, std::set<llvm::Value *> &visited,
+                    std::vector<llvm::Instruction *> &slice) const;
+
+private:
+  const OCLEnv &ocl;
+  BlockMask &blockMask;
+  int sliceNumber;
+  std::vector<std::unique_ptr<llvm::ExecutionEngine>> engines;
+};
+
+}
+
+#endif
@@ -1,73 +1,105 @@
 #ifndef SUBSCRIPT_ANALYSIS_H
 #define SUBSCRIPT_ANALYSIS_H
 
+#include "SymEngine/AccessFormula.h"
 #include "SymEngine/BlockMask.h"
 #include "SymEngine/OCLEnv.h"
+#include "SymEngine/SubscriptCompiler.h"
 #include "SymEngine/Utils.h"
+#include "SymEngine/WarpSimulator.h"
+
+#ifdef SYM_ENGINE_JIT
+#include "SymEngine/SliceCompiler.h"
+#endif
 
 #include "llvm/Analysis/ScalarEvolution.h"
 #include "llvm/Analysis/ScalarEvolutionExpressions.h"
 
+#include <cstdint>
+#include <memory>
+
 namespace SymEngine {
 
 class NDRangePoint;
 class OCLEnv;
+class ThreadPool;
 
+// Warps are analyzed in parallel on threadPool.
+// Subscripts, block conditions and trip counts are compiled with the kernel
+// arguments and the NDRange of oclEnv, once: setHardware() changes only the
+// hardware and the warps the accesses are counted on.
+// ScalarEvolution is not thread safe: prepareAccess() does all the work that
+// needs it. Once all the accesses have been prepared, the counts of accesses
+// in different blocks can be computed concurrently.
 class SubscriptAnalysis {
 public:
-  SubscriptAnalysis(llvm::ScalarEvolution *se, OCLEnv &&ocl, BlockMask &&blockMask);
+  SubscriptAnalysis(llvm::ScalarEvolution *se,
+                    std::shared_ptr<const OCLEnv> oclEnv,
+                    BlockMask &&blockMask, ThreadPool &threadPool);
+  ~SubscriptAnalysis();
 
 public:
+  // Count the accesses on the hardware and the warps of oclEnv, whose kernel
+  // arguments and NDRange are those of the environment given to the
+  // constructor. The active masks of the warps are computed again.
+  void setHardware(std::shared_ptr<const OCLEnv> oclEnv);
+  // Compile the subscript of the access of inst to value, the conditions of
+  // its block and the trip count of its loop, if not null.
+  void prepareAccess(llvm::Instruction *inst, llvm::Value *value,
+                     const llvm::SCEV *tripCount);
   int getBankConflictNumber(llvm::Instruction *inst, llvm::Value *value);
   int getBankConflictNumberInLoop(llvm::Instruction *inst, llvm::Value *value,
                                   const llvm::SCEV *tripCount);
   int getTransactionNumber(llvm::Instruction *inst, llvm::Value *value);
   int getTransactionNumberInLoop(llvm::Instruction *inst, llvm::Value *value,
                                  const llvm::SCEV *tripCount);
+  // Formula of the access of inst to value, whose subscript, block conditions
+  // and trip count are bound neither to the NDRange nor to the kernel
+  // arguments. Only the compiled expressions are filled.
+  AccessFormula getAccessFormula(llvm::Instruction *inst, llvm::Value *value,
+                                 const llvm::SCEV *tripCount);
+  // Half width of the 95% confidence interval of the last count computed for
+  // inst when sampling the NDRange, 0 if the count is exact.
+  int getConfidenceInterval(llvm::Instruction *inst) const;
+  // Number of subscripts, block conditions and trip counts compiled so far.
+  int getCompilationNumber() const;
 
 private:
   llvm::ScalarEvolution *scalarEvolution;
-  const OCLEnv ocl;
+  std::shared_ptr<const OCLEnv> oclEnv;
+  const OCLEnv &ocl;
   BlockMask blockMask;
-  typedef std::map<const llvm::SCEV *, const llvm::SCEV *> SCEVMap;
+  SubscriptCompiler compiler;
+  // Subscripts and block conditions are compiled once and bound to the
+  // NDRange.
+  std::map<llvm::Value *, CompiledExpression> subscripts;
+  std::map<llvm::BasicBlock *, std::vector<CompiledCondition>> conditions;
+  std::map<const llvm::SCEV *, int> tripCounts;
+  int compilationNumber;
+  std::map<llvm::Instruction *, int> confidenceIntervals;
+  // Environment the accesses are counted in.
+  std::shared_ptr<const OCLEnv> hardwareEnv;
+  ThreadPool &threadPool;
+  std::unique_ptr<WarpSimulator> simulator;
+  std::map<llvm::BasicBlock *, WarpSimulator::ActiveMasks> activeMasks;
+#ifdef SYM_ENGINE_JIT
+  // Native slices of the accesses that the compiled expressions do not
+  // describe exactly, null if the slice is not supported.
+  SliceCompiler sliceCompiler;
+  std::map<llvm::Instruction *, WarpSlice> slices;
+#endif
 
 private:
-  std::vector<const llvm::SCEV *> analyzeSubscript(llvm::Instruction *inst,
-                                                   const llvm::SCEV *scev,
-                                                   Warp &warp);
-
-  // Thread-dependet replacing methods.
-  const llvm::SCEV *replaceInExpr(const llvm::SCEV *expr,
-                                  const NDRangePoint &point,
-                                  SCEVMap &processed);
-  const llvm::SCEV *replaceInExpr(const llvm::SCEVAddRecExpr *expr,
-                                  const NDRangePoint &point,
-                                  SCEVMap &processed);
-  const llvm::SCEV *replaceInExpr(const llvm::SCEVCommutativeExpr *expr,
-                                  const NDRangePoint &point,
-                                  SCEVMap &processed);
-  const llvm::SCEV *replaceInExpr(const llvm::SCEVConstant *expr,
-                                  const NDRangePoint &point,
-                                  SCEVMap &processed);
-  const llvm::SCEV *replaceInExpr(const llvm::SCEVUnknown *expr,
-                                  const NDRangePoint &point,
-                                  SCEVMap &processed);
-  const llvm::SCEV *replaceInExpr(const llvm::SCEVUDivExpr *expr,
-                                  const NDRangePoint &point,
-                                  SCEVMap &processed);
-  const llvm::SCEV *replaceInExpr(const llvm::SCEVCastExpr *expr,
-                                  const NDRangePoint &point,
-                                  SCEVMap &processed);
-  const llvm::SCEV *replaceInPhi(llvm::PHINode *Phi, const NDRangePoint &point,
-                                 SCEVMap &processed);
-
-  const llvm::SCEV *resolveInstruction(llvm::Instruction *instruction,
-                                       const NDRangePoint &point);
-
+  int countAccesses(llvm::Instruction *inst, llvm::Value *value,
+                    WarpSimulator::AccessCounter counter);
+  void scaleConfidenceInterval(llvm::Instruction *inst, int factor);
+  const CompiledExpression &getSubscript(llvm::Value *value);
+  const std::vector<CompiledCondition> &getConditions(llvm::BasicBlock *block);
+  WarpSimulator::ActiveMasks &getActiveMasks(llvm::BasicBlock *block);
   int resolveTripCount(const llvm::SCEV *tripCount);
-  
-  bool isOperationExecuted(const NDRangePoint &point, llvm::Instruction *inst);
-
+#ifdef SYM_ENGINE_JIT
+  bool needsSlice(llvm::Instruction *inst, llvm::Value *value);
+#endif
 };
 
 }
@@ -0,0 +1,71 @@
+#ifndef SUBSCRIPT_COMPILER_H
+#define SUBSCRIPT_COMPILER_H
+
+#include "SymEngine/BlockMask.h"
+#include "SymEngine/CompiledExpression.h"
+
+#include "llvm/Analysis/ScalarEvolution.h"
+#include "llvm/Analysis/ScalarEvolutionExpressions.h"
+
+#include <map>
+#include <set>
+
+namespace SymEngine {
+
+class OCLEnv;
+
+// -----------------------------------------------------------------------------
+// A block condition whose SCEV has been compiled.
+struct CompiledCondition {
+  CompiledExpression expression;
+  llvm::CmpInst::Predicate predicate;
+};
+
+// -----------------------------------------------------------------------------
+// Translate SCEV expressions into CompiledExpressions.
+// Calls to OpenCL coordinate and size functions become variables, integer
+// kernel arguments are replaced with the values given in OCLEnv.
+// The base pointer of a memory access is dropped, so that the compiled
+// subscript computes the offset relative to it.
+// Integer subexpressions are translated only once: ScalarEvolution uniques
+// SCEVs, so the subexpressions shared by subscripts and block conditions are
+// the same SCEV and reuse the same translation.
+class SubscriptCompiler {
+public:
+  SubscriptCompiler(llvm::ScalarEvolution *se, const OCLEnv &ocl);
+
+public:
+  CompiledExpression compile(const llvm::SCEV *scev);
+  CompiledCondition compile(const BlockCondition &condition);
+
+private:
+  void compileExpr(const llvm::SCEV *expr, CompiledExpression &result);
+  void translateExpr(const llvm::SCEV *expr, CompiledExpression &result);
+  void compileExpr(const llvm::SCEVAddRecExpr *expr,
+                   CompiledExpression &result);
+  void compileExpr(const llvm::SCEVCommutativeExpr *expr,
+                   CompiledExpression &result);
+  void compileExpr(const llvm::SCEVConstant *expr, CompiledExpression &result);
+  void compileExpr(const llvm::SCEVUnknown *expr, CompiledExpression &result);
+  void compileExpr(const llvm::SCEVUDivExpr *expr, CompiledExpression &result);
+  void compileExpr(const llvm::SCEVCastExpr *expr, CompiledExpression &result);
+  void compileBinaryOperator(llvm::BinaryOperator *binOp,
+                             CompiledExpression &result);
+  void compilePhi(llvm::PHINode *phi, CompiledExpression &result);
+  void compileInstruction(llvm::Instruction *instruction,
+                          CompiledExpression &result);
+
+private:
+  llvm::ScalarEvolution *scalarEvolution;
+  const OCLEnv &ocl;
+  // Base pointer of the expression being compiled.
+  llvm::Value *basePointer;
+  // Phi nodes being compiled, used to break cycles.
+  std::set<llvm::PHINode *> visitingPhis;
+  // Translations of the integer subexpressions compiled so far.
+  std::map<const llvm::SCEV *, CompiledExpression> translations;
+};
+
+}
+
+#endif
@@ -0,0 +1,108 @@
+#ifndef SYM_ENGINE_C_H
+#define SYM_ENGINE_C_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* -----------------------------------------------------------------------------
+ * C interface to evaluate the memory accesses of OpenCL kernels from a host
+ * program, without config files and without the opt plugin.
+ * A module is analyzed once, when it is loaded: the access formulas of all
+ * its kernels are compiled with the integer kernel arguments left symbolic,
+ * then the LLVM module is released. Kernels are then evaluated for any
+ * NDRange, arguments and hardware without running LLVM again.
+ * Errors are returned as status codes: no function terminates the process
+ * on invalid input.
+ * Loading modules can be done from any thread, but loads are serialized.
+ * Kernel handles are immutable: SymEngineEvaluate() can be called
+ * concurrently on the same or on different kernels, and the evaluations of
+ * the kernels of a module share the threads of the module. */
+
+typedef enum SymEngineStatus {
+  SYM_ENGINE_SUCCESS = 0,
+  /* A null pointer, a non-positive size or a missing argument. */
+  SYM_ENGINE_INVALID_ARGUMENT,
+  /* The IR or bitcode cannot be read or parsed. */
+  SYM_ENGINE_INVALID_MODULE,
+  SYM_ENGINE_KERNEL_NOT_FOUND,
+  /* The warp size is larger than the lanes supported by the simulator. */
+  SYM_ENGINE_UNSUPPORTED_WARP_SIZE
+} SymEngineStatus;
+
+typedef struct SymEngineOpaqueModule *SymEngineModuleRef;
+typedef const struct SymEngineOpaqueKernel *SymEngineKernelRef;
+
+/* Same content as the ndRange entry of opencl_config.yaml. */
+typedef struct SymEngineNDRange {
+  int localSize[3];
+  int numberOfGroups[3];
+} SymEngineNDRange;
+
+/* Same content as hardware_config.yaml. */
+typedef struct SymEngineHardware {
+  int banksNumber;
+  int bankWidth;
+  int warpSize;
+  int cacheLineSize;
+} SymEngineHardware;
+
+/* Counter of a memory instruction over the whole NDRange: transactions for
+ * global accesses, bank conflicts for local ones. count is -1 if the
+ * subscript cannot be computed. */
+typedef struct SymEngineAccessCount {
+  int isLoad;
+  int isLocal;
+  int count;
+} SymEngineAccessCount;
+
+/* Description of status, never null. */
+const char *SymEngineGetStatusString(SymEngineStatus status);
+
+/* Load the LLVM IR or bitcode in fileName, or in the size bytes at data, and
+ * compile the formulas of its kernels. The evaluations use threadNumber
+ * threads, 0 means one per hardware thread. */
+SymEngineStatus SymEngineLoadModule(const char *fileName,
+                                    unsigned int threadNumber,
+                                    SymEngineModuleRef *module);
+SymEngineStatus SymEngineParseModule(const char *data, size_t size,
+                                     unsigned int threadNumber,
+                                     SymEngineModuleRef *module);
+/* Invalidates the handles of the kernels of module. No evaluation of them can
+ * be running. */
+void SymEngineDisposeModule(SymEngineModuleRef module);
+
+/* Kernels of module, in the order of the module. */
+size_t SymEngineGetKernelNumber(SymEngineModuleRef module);
+SymEngineKernelRef SymEngineGetKernelAt(SymEngineModuleRef module,
+                                        size_t index);
+SymEngineStatus SymEngineGetKernel(SymEngineModuleRef module,
+                                   const char *kernelName,
+                                   SymEngineKernelRef *kernel);
+
+/* The name is owned by the kernel. */
+const char *SymEngineGetKernelName(SymEngineKernelRef kernel);
+/* Number of memory instructions of kernel: the size of the counts of
+ * SymEngineEvaluate(). */
+size_t SymEngineGetAccessNumber(SymEngineKernelRef kernel);
+
+/* Count the memory accesses of kernel for the given NDRange, integer kernel
+ * arguments (in the order of the kernel signature, skipping the other
+ * arguments) and hardware. counts must have SymEngineGetAccessNumber(kernel)
+ * entries, filled in the order of the instructions of the kernel. Accesses
+ * depending on an argument beyond argumentNumber have a count of -1. */
+SymEngineStatus SymEngineEvaluate(SymEngineKernelRef kernel,
+                                  const SymEngineNDRange *ndRange,
+                                  const int64_t *arguments,
+                                  size_t argumentNumber,
+                                  const SymEngineHardware *hardware,
+                                  SymEngineAccessCount *counts);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -1,6 +1,7 @@
 #ifndef SYMBOLIC_EXECUTION_H
 #define SYMBOLIC_EXECUTION_H
 
+#include "SymEngine/AccessFormula.h"
 #include "SymEngine/NDRangeSpace.h"
 
 #include "llvm/Pass.h"
@@ -16,21 +17,44 @@
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/raw_ostream.h"
 
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
 namespace llvm {
 class Function;
+class Module;
 class StoreInst;
 class LoadInst;
 }
 
 namespace SymEngine {
+class BlockMask;
 class NDRange;
 class OCLEnv;
 class SubscriptAnalysis;
 class ControlDependenceAnalysis;
+class ThreadPool;
 }
 
-/// Collect information about the kernel function.
 namespace SymEngine {
+
+// Results of a kernel for each hardware profile, keyed by profile name in the
+// output.
+struct ProfileResults {
+  std::vector<std::pair<std::string, KernelResults>> profiles;
+};
+
+// Results of all the kernels of a module, in the order of the module, keyed
+// by kernel name in the output. Only one of the vectors is filled.
+struct ModuleResults {
+  std::vector<std::pair<std::string, KernelResults>> kernels;
+  std::vector<KernelFormulas> formulas;
+  std::vector<std::pair<std::string, ProfileResults>> profiles;
+};
+
+/// Collect information about the kernel function.
 class SymbolicExecution : public llvm::FunctionPass,
                           public llvm::InstVisitor<SymbolicExecution> {
 
@@ -39,45 +63,86 @@ class SymbolicExecution : public llvm::FunctionPass,
 public:
   static char ID;
   SymbolicExecution();
+  // Compile the access formulas of all the kernels of the module into
+  // formulasOutput, with symbolic kernel arguments: no config file is read
+  // and nothing is dumped.
+  explicit SymbolicExecution(SymEngine::ModuleResults *formulasOutput);
   ~SymbolicExecution();
 
   virtual bool runOnFunction(llvm::Function &F);
+  virtual bool doFinalization(llvm::Module &M);
   virtual void getAnalysisUsage(llvm::AnalysisUsage &AU) const;
 
+  // Number of subscripts, block conditions and trip counts compiled for the
+  // kernel analyzed last, whatever the number of hardware profiles.
+  int getCompilationNumber() const;
+
 public:
-  // These result vectors will contain 1 entry per memory operation.
-  std::vector<int> loadTransactions;
-  std::vector<int> storeTransactions;
+  // Counters of the kernel analyzed last.
+  SymEngine::KernelResults results;
+
+  // When the integer kernel arguments are symbolic, formulas of the memory
+  // operations, dumped instead of the results above.
+  bool symbolicArguments;
+  SymEngine::KernelFormulas formulas;
 
-  std::vector<int> loadBankConflicts;
-  std::vector<int> storeBankConflicts;
+  // When hardware_config.yaml holds a list of profiles, counters of the
+  // kernel analyzed last for each of them, dumped instead of the results.
+  SymEngine::ProfileResults profileResults;
+
+  // When all the kernels of the module are analyzed, results and formulas of
+  // each kernel, dumped together once the module is done.
+  SymEngine::ModuleResults moduleResults;
+
+private:
+  // Load or store through a getelementptr, in the order of the visit.
+  struct MemoryAccess {
+    llvm::Instruction *inst;
+    llvm::Value *pointer;
+    bool isLoad;
+    bool isLocal;
+    // Backedge taken count of the enclosing loop when the result is scaled
+    // by the trip count, null otherwise.
+    const llvm::SCEV *tripCount;
+  };
 
 private:
   void memoryAccessAnalysis(llvm::BasicBlock &block,
                             std::vector<int> &loadTrans,
                             std::vector<int> &storeTrans);
+  bool isSelected(llvm::Function &function) const;
   void init();
   void initBuffers();
+  void initResults();
+  // Visit the kernel and count its accesses in the given environment.
+  void analyzeKernel(llvm::Function &function,
+                     std::shared_ptr<const SymEngine::OCLEnv> ocl,
+                     const SymEngine::BlockMask &blockMask);
+  // Count the accesses of the kernel visited last in another environment of
+  // the same arguments and NDRange.
+  void analyzeHardware(llvm::Function &function,
+                       std::shared_ptr<const SymEngine::OCLEnv> ocl);
   void initOCLSpace();
   void visitLoadInst(llvm::LoadInst &loadInst);
   void visitStoreInst(llvm::StoreInst &storeInst);
-  int visitMemoryInst(llvm::Instruction *inst, llvm::Value *pointer,
-                      std::vector<int> &resultVector);
-  int visitMemoryInstInLoop(llvm::Instruction *inst, llvm::Value *pointer,
-                            std::vector<int> &resultVector, llvm::Loop *loop);
-  int visitLocalMemoryInst(llvm::Instruction *inst, llvm::Value *pointer,
-                           std::vector<int> &resultVector);
-  int visitLocalMemoryInstInLoop(llvm::Instruction *inst, llvm::Value *pointer,
-                                 std::vector<int> &resultVector,
-                                 llvm::Loop *loop);
   void visitPointer(llvm::Instruction *inst, llvm::Value *pointer,
-                    std::vector<int> &bankConflicts,
-                    std::vector<int> &transactions);
+                    bool isLoad);
+  void analyzeAccesses(llvm::Function &function, const SymEngine::OCLEnv &ocl);
+  // Count and error of each access, in the order of the visit.
+  void countAccesses(std::vector<int> &counts, std::vector<int> &errors);
+  void recordResults(const std::vector<int> &counts,
+                     const std::vector<int> &errors);
+  int countAccess(const MemoryAccess &access);
+  void sweep(const std::vector<int64_t> &arguments,
+             const SymEngine::HardwareConfig &hwConfig);
   void dump();
 
 private:
+  SymEngine::ModuleResults *formulasOutput;
   llvm::ScalarEvolution *scalarEvolution;
   SymEngine::SubscriptAnalysis *subscriptAnalysis;
+  std::unique_ptr<SymEngine::ThreadPool> threadPool;
+  std::vector<MemoryAccess> accesses;
   SymEngine::NDRange *ndr;
   SymEngine::ControlDependenceAnalysis *cdGraph;
   llvm::LoopInfo *loopInfo;
@@ -0,0 +1,82 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace SymEngine {
+
+// -----------------------------------------------------------------------------
+// Fixed set of worker threads executing parallel loops with work stealing.
+// Every thread has a queue of ranges of iterations. A thread runs the ranges
+// of its own queue, splitting them in halves, and steals from the other
+// queues when its own is empty.
+// The thread calling parallelFor takes part in the loop, and parallelFor can
+// be called from the body of another loop: while waiting, the caller runs the
+// iterations of any loop.
+class ThreadPool {
+  void operator=(const ThreadPool &);
+  ThreadPool(const ThreadPool &);
+
+public:
+  // threadNumber == 0 uses one thread per hardware thread.
+  explicit ThreadPool(unsigned int threadNumber);
+  ~ThreadPool();
+
+public:
+  unsigned int getThreadNumber() const;
+  // Call body(index) for all index in [0, count) and wait for all the calls
+  // to finish. Calls can be executed in any order and by any thread.
+  void parallelFor(size_t count, const std::function<void(size_t)> &body);
+
+private:
+  struct Loop {
+    const std::function<void(size_t)> *body;
+    // Ranges shorter than grain are not split.
+    size_t grain;
+    std::atomic<size_t> remaining;
+  };
+
+  struct Range {
+    Loop *loop;
+    size_t begin;
+    size_t end;
+  };
+
+  struct Queue {
+    std::mutex mutex;
+    std::deque<Range> ranges;
+  };
+
+private:
+  void workerLoop(unsigned int queueIndex);
+  void push(unsigned int queueIndex, const Range &range);
+  bool pop(unsigned int queueIndex, Range &range);
+  bool steal(unsigned int queueIndex, Range &range);
+  // Run one range taken from the queues, return false if there is none.
+  bool runRange(unsigned int queueIndex);
+  unsigned int getQueueIndex() const;
+
+private:
+  std::vector<std::thread> workers;
+  // One queue per thread, the first one is used by the threads that are not
+  // workers of the pool.
+  std::vector<std::unique_ptr<Queue>> queues;
+  std::atomic<size_t> queuedRanges;
+
+  // Idle workers sleep until ranges are queued.
+  std::mutex mutex;
+  std::condition_variable wakeUp;
+  std::atomic<unsigned int> sleepingWorkers;
+  bool stopping;
+};
+
+}
+
+#endif
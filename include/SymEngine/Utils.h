@@ -30,6 +30,10 @@ llvm::Function *getOpenCLFunctionByName(std::string calleeName,
 
 bool isOpenCLIntCast(llvm::Instruction *inst);
 
+// True if function is an OpenCL kernel: it is listed in the opencl.kernels
+// metadata of its module or it has the SPIR kernel calling convention.
+bool isKernel(const llvm::Function &function);
+
 std::string readFile(const std::string &filePath);
 
 #endif
@@ -4,13 +4,17 @@
 #include "SymEngine/NDRangeSpace.h"
 #include "SymEngine/NDRangePoint.h"
 
-#include <memory>
+#include <iterator>
+#include <vector>
 
 namespace SymEngine {
 
 class NDRangeSpace;
 
 //------------------------------------------------------------------------------
+// A warp is a range of consecutive work-items of a group. It only stores its
+// position in the NDRange: the coordinates of its lanes are computed on
+// demand, so warps are cheap to copy and iterating them does not allocate.
 class Warp {
 public:
   Warp();
@@ -21,8 +25,25 @@ public:
   Warp(int groupX, int groupY, int groupZ, int warpIndex,
        const NDRangeSpace *ndrSpace, int warpSize);
 
+public:
+  int getGroupX() const;
+  int getGroupY() const;
+  int getGroupZ() const;
+  int getWarpIndex() const;
+  int getLaneNumber() const;
+  // Warps with the same shape, in any group, have the same local coordinates
+  // relative to their first lane: the coordinates of their lanes differ by the
+  // same shift. Used to group warps whose accesses are translations of each
+  // other.
+  int getShape() const;
+  // Coordinates of the work-item running in the given lane.
+  NDRangePoint getPoint(int lane) const;
+
 private:
-  std::vector<NDRangePoint> points;
+  int group[3];
+  int warpIndex;
+  const NDRangeSpace *ndrSpace;
+  int warpSize;
 
 //------------------------------------------------------------------------------
 public:
@@ -30,12 +51,11 @@ public:
       : public std::iterator<std::forward_iterator_tag, NDRangePoint> {
   public:
     iterator();
-    iterator(const Warp *warp);
-    iterator(const iterator &original);
+    iterator(const Warp *warp, int lane);
 
   private:
-    std::vector<NDRangePoint> points;
-    size_t currentPoint;
+    const Warp *warp;
+    int lane;
 
   public:
     // Pre-increment.
@@ -45,11 +65,6 @@ public:
     NDRangePoint operator*() const;
     bool operator!=(const iterator &iter) const;
     bool operator==(const iterator &iter) const;
-
-    static iterator end();
-
-  private:
-    void toNext();
   };
 
 public:
@@ -67,6 +82,7 @@ public:
                                    int warpIndex) const;
   std::vector<Warp>
   createAllWarpsInGroup(int groupX, int groupY, int groupZ) const;
+  int getWarpsInGroup() const;
 
 private:
   const NDRangeSpace *ndrSpace;
@@ -0,0 +1,58 @@
+#ifndef WARP_EVALUATOR_H
+#define WARP_EVALUATOR_H
+
+#include "SymEngine/CompiledExpression.h"
+
+#include <cstdint>
+
+namespace SymEngine {
+
+class Warp;
+
+// -----------------------------------------------------------------------------
+// Coordinates of the work-items of a warp in structure-of-arrays form.
+// values[index][lane] holds the coordinate with the given
+// CompiledExpression::getCoordinateIndex() for the given lane.
+struct LaneCoordinates {
+  static constexpr int MAX_LANE_NUMBER = 64;
+
+  LaneCoordinates();
+  explicit LaneCoordinates(const Warp &warp);
+
+  int laneNumber;
+  alignas(32) int32_t values[AffineForm::COORDINATE_NUMBER][MAX_LANE_NUMBER];
+  // uniform[index] is true if the coordinate is the same for all the lanes,
+  // like the group ids or the local id in y of a warp within a row.
+  bool uniform[AffineForm::COORDINATE_NUMBER];
+  // linear[index] is true if the coordinate is
+  // values[index][0] + steps[index] * lane for all the lanes, like the local id
+  // in x of a warp within a row. Uniform coordinates have step 0.
+  bool linear[AffineForm::COORDINATE_NUMBER];
+  int32_t steps[AffineForm::COORDINATE_NUMBER];
+};
+
+// -----------------------------------------------------------------------------
+// Native evaluator of a memory access for all the lanes of a warp: writes the
+// address of each lane in addresses and the lanes executing the access in
+// activeMask. See SliceCompiler.
+typedef void (*WarpSlice)(const LaneCoordinates *lanes, int64_t *addresses,
+                          uint64_t *activeMask);
+
+// -----------------------------------------------------------------------------
+// Evaluate a bound expression for all the lanes of a warp in one pass.
+// results and valid must hold lanes.laneNumber elements. valid[lane] is false
+// if the expression cannot be computed for that lane.
+// Returns true if the expression is valid for all the lanes.
+bool evaluateForWarp(const CompiledExpression &expression,
+                     const LaneCoordinates &lanes, int64_t *results,
+                     bool *valid);
+
+// Returns true if the bound expression is base + stride * lane for all the
+// lanes of the warp, setting base and stride.
+bool getLaneStride(const CompiledExpression &expression,
+                   const LaneCoordinates &lanes, int64_t &base,
+                   int64_t &stride);
+
+}
+
+#endif
@@ -0,0 +1,172 @@
+#ifndef WARP_SIMULATOR_H
+#define WARP_SIMULATOR_H
+
+#include "SymEngine/CompiledExpression.h"
+#include "SymEngine/GroupSampler.h"
+#include "SymEngine/HardwareConfig.h"
+#include "SymEngine/SubscriptCompiler.h"
+#include "SymEngine/Warp.h"
+#include "SymEngine/WarpEvaluator.h"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace SymEngine {
+
+class NDRangeSpace;
+class ThreadPool;
+
+// -----------------------------------------------------------------------------
+// Count the transactions or the bank conflicts of the warps executing a
+// memory access, from its bound subscript and block conditions. It does not
+// need ScalarEvolution, so accesses compiled once can be counted for any
+// NDRange. Warps are analyzed in parallel on threadPool.
+class WarpSimulator {
+public:
+  // Count the transactions or the bank conflicts of warps: in batches from
+  // the addresses of the lanes and the active masks or, when the subscript is
+  // strided across the lanes, from its base and stride.
+  struct AccessCounter {
+    void (*countBatch)(const int64_t *addresses, const uint64_t *activeMasks,
+                       int laneNumber, int warpNumber,
+                       const HardwareConfig &hwConfig, int *results);
+    int (*countStrided)(int64_t base, int64_t stride, int laneNumber,
+                        uint64_t activeMask, const HardwareConfig &hwConfig);
+  };
+  static const AccessCounter TRANSACTIONS;
+  static const AccessCounter BANK_CONFLICTS;
+
+  // Maximum number of warps analyzed at once.
+  static const int WARP_BATCH_SIZE = 16;
+
+  // Lanes of every warp executing a block, one bit per lane. Masks are
+  // computed the first time an instruction of the block is analyzed and
+  // reused by all the other instructions of the block.
+  // Warps are identified by their position in the vector given to
+  // countAccesses(), or by group * warps per group + warp index when
+  // simulating or sampling the whole NDRange. Only the warps analyzed have a
+  // slot: the slots are added before the warps are analyzed in parallel, then
+  // every warp only writes its own slot.
+  struct ActiveMasks {
+    struct Mask {
+      uint64_t lanes;
+      bool computed;
+    };
+    std::unordered_map<int, Mask> masks;
+
+    void reset();
+    // Add the slot of the warp if it has none.
+    void addWarp(int warpId);
+  };
+
+public:
+  WarpSimulator(const NDRangeSpace *ndrSpace, const HardwareConfig &hwConfig,
+                ThreadPool &threadPool);
+
+public:
+  int getWarpsPerGroup() const;
+  // Total count of the given warps.
+  int countAccesses(const std::vector<Warp> &warps,
+                    const CompiledExpression &subscript,
+                    const std::vector<CompiledCondition> &blockConditions,
+                    ActiveMasks &masks, AccessCounter counter) const;
+  // Total count of all the warps of the NDRange, clamped to the largest int.
+  int countAccessesInNDRange(
+      const CompiledExpression &subscript,
+      const std::vector<CompiledCondition> &blockConditions,
+      ActiveMasks &masks, AccessCounter counter) const;
+  // Same as above with the addresses and the active masks computed by a
+  // native slice, for the accesses whose subscript or block conditions cannot
+  // be compiled to expressions. Every warp is evaluated.
+  int countSliceAccesses(const std::vector<Warp> &warps, WarpSlice slice,
+                         AccessCounter counter) const;
+  int countSliceAccessesInNDRange(WarpSlice slice,
+                                  AccessCounter counter) const;
+  // Estimate of the total count of the NDRange from a sample of its warps.
+  SampledEstimate
+  estimateAccesses(const CompiledExpression &subscript,
+                   const std::vector<CompiledCondition> &blockConditions,
+                   ActiveMasks &masks, AccessCounter counter,
+                   const GroupSampler &sampler) const;
+
+private:
+  // Counts of the warps already analyzed for an instruction, by equivalence
+  // class. Warps with the same shape and active mask whose affine subscripts
+  // have the same base address modulo the translation period access the same
+  // addresses shifted by a multiple of the period, so they have the same
+  // count as long as all the addresses are non negative. Only one warp of
+  // each class is analyzed.
+  struct WarpClasses {
+    struct Class {
+      int shape;
+      uint64_t activeMask;
+      int64_t baseResidue;
+      // Smallest offset of an active lane from the base address.
+      int64_t minOffset;
+      int count;
+    };
+
+    explicit WarpClasses(int64_t period);
+    // Index of the class of the warp, -1 if there is none.
+    int find(int shape, uint64_t activeMask, int64_t base) const;
+    // Returns -1 if the addresses of the warp cannot represent a class.
+    int add(int shape, uint64_t activeMask, int64_t base, int64_t minOffset);
+
+    int64_t period;
+    std::vector<Class> classes;
+  };
+
+  // Subscript and block conditions of an instruction specialized to the
+  // work-items of a group.
+  struct GroupAccess {
+    CompiledExpression subscript;
+    std::vector<CompiledCondition> blockConditions;
+  };
+
+private:
+  int countAccessesInGroup(
+      const CompiledExpression &subscript,
+      const std::vector<CompiledCondition> &blockConditions,
+      ActiveMasks &masks, AccessCounter counter, int groupX, int groupY,
+      int groupZ) const;
+  // Identifier of the warp in ActiveMasks when simulating or sampling the
+  // whole NDRange.
+  int getWarpId(int groupX, int groupY, int groupZ, int warpIndex) const;
+  GroupAccess
+  specializeForGroup(const CompiledExpression &subscript,
+                     const std::vector<CompiledCondition> &blockConditions,
+                     int groupX, int groupY, int groupZ) const;
+  // Write in results the count of each of the warpNumber warps, at most
+  // WARP_BATCH_SIZE. warpIds are the indices of the warps in masks. Warps of
+  // the classes already analyzed are not evaluated, the new classes are added
+  // to classes.
+  void
+  countAccessesInWarps(const CompiledExpression &subscript,
+                       const std::vector<CompiledCondition> &blockConditions,
+                       const Warp *warps, const int *warpIds, int warpNumber,
+                       ActiveMasks &masks, AccessCounter counter,
+                       WarpClasses &classes, int *results) const;
+  // Total count of the warpNumber warps, at most WARP_BATCH_SIZE.
+  int countSliceAccessesInWarps(const Warp *warps, int warpNumber,
+                                WarpSlice slice, AccessCounter counter) const;
+  // Write in addresses the offsets accessed by all the lanes of the warp.
+  // Returns the mask of the lanes whose offset could be evaluated: the others
+  // divide by zero, and must not be counted.
+  uint64_t evaluateAddresses(const CompiledExpression &subscript,
+                             const LaneCoordinates &lanes,
+                             int64_t *addresses) const;
+  uint64_t
+  computeActiveMask(const std::vector<CompiledCondition> &blockConditions,
+                    const LaneCoordinates &lanes) const;
+
+private:
+  const NDRangeSpace *ndrSpace;
+  HardwareConfig hwConfig;
+  WarpFactory warpFactory;
+  ThreadPool &threadPool;
+};
+
+}
+
+#endif
@@ -1,12 +1,16 @@
 #ifndef YAML_READER_H
 #define YAML_READER_H
 
+#include "SymEngine/AccessFormula.h"
 #include "SymEngine/HardwareConfig.h"
+#include "SymEngine/NDRangeSweep.h"
 
 #include "llvm/Support/YAMLTraits.h"
 
 using namespace llvm;
 using yaml::MappingTraits;
+using yaml::ScalarEnumerationTraits;
+using yaml::ScalarTraits;
 using yaml::SequenceTraits;
 
 // -----------------------------------------------------------------------------
@@ -20,9 +24,19 @@ struct KernelArguments {
 
 typedef std::vector<SymEngine::KernelArguments> KernelArgumentsVector;
 
+// Content of hardware_config.yaml: either a single configuration or a list of
+// named profiles.
+struct HardwareConfigFile {
+  HardwareConfig config;
+  std::vector<HardwareProfile> profiles;
+};
+
 }
 
 LLVM_YAML_IS_SEQUENCE_VECTOR(SymEngine::KernelArguments)
+LLVM_YAML_IS_SEQUENCE_VECTOR(SymEngine::HardwareProfile)
+LLVM_YAML_IS_SEQUENCE_VECTOR(SymEngine::CompiledCondition)
+LLVM_YAML_IS_SEQUENCE_VECTOR(SymEngine::AccessFormula)
 
 // -----------------------------------------------------------------------------
 
@@ -64,6 +78,21 @@ template <> struct MappingTraits<SymEngine::HardwareConfig> {
   }
 };
 
+template <> struct MappingTraits<SymEngine::HardwareProfile> {
+  static void mapping(yaml::IO &io, SymEngine::HardwareProfile &profile) {
+    io.mapRequired("name", profile.name);
+    MappingTraits<SymEngine::HardwareConfig>::mapping(io, profile.config);
+  }
+};
+
+template <> struct MappingTraits<SymEngine::HardwareConfigFile> {
+  static void mapping(yaml::IO &io, SymEngine::HardwareConfigFile &file) {
+    io.mapOptional("profiles", file.profiles);
+    if (file.profiles.empty())
+      MappingTraits<SymEngine::HardwareConfig>::mapping(io, file.config);
+  }
+};
+
 template <> struct MappingTraits<SymEngine::NDRangeStruct> {
   static void mapping(yaml::IO &io, SymEngine::NDRangeStruct &ndRange) {
     io.mapRequired("localSize", ndRange.localSize);
@@ -85,6 +114,122 @@ template <> struct MappingTraits<SymEngine::OpenCLConfig> {
   }
 };
 
+// Expressions are written in their textual form.
+template <> struct ScalarTraits<SymEngine::CompiledExpression> {
+  static void output(const SymEngine::CompiledExpression &expression, void *,
+                     raw_ostream &out) {
+    out << expression.toString();
+  }
+  static StringRef input(StringRef scalar, void *,
+                         SymEngine::CompiledExpression &expression) {
+    if (!SymEngine::CompiledExpression::parse(scalar.str(), expression))
+      return "malformed expression";
+    return StringRef();
+  }
+  static bool mustQuote(StringRef) { return false; }
+};
+
+// Predicates are written with the names of the LLVM assembly, so that the
+// files do not depend on the values of the enumeration. The floating point
+// predicates, other than the constant ones, are prefixed with fcmp_.
+template <> struct ScalarEnumerationTraits<CmpInst::Predicate> {
+  static void enumeration(yaml::IO &io, CmpInst::Predicate &predicate) {
+    io.enumCase(predicate, "false", CmpInst::FCMP_FALSE);
+    io.enumCase(predicate, "fcmp_oeq", CmpInst::FCMP_OEQ);
+    io.enumCase(predicate, "fcmp_ogt", CmpInst::FCMP_OGT);
+    io.enumCase(predicate, "fcmp_oge", CmpInst::FCMP_OGE);
+    io.enumCase(predicate, "fcmp_olt", CmpInst::FCMP_OLT);
+    io.enumCase(predicate, "fcmp_ole", CmpInst::FCMP_OLE);
+    io.enumCase(predicate, "fcmp_one", CmpInst::FCMP_ONE);
+    io.enumCase(predicate, "fcmp_ord", CmpInst::FCMP_ORD);
+    io.enumCase(predicate, "fcmp_uno", CmpInst::FCMP_UNO);
+    io.enumCase(predicate, "fcmp_ueq", CmpInst::FCMP_UEQ);
+    io.enumCase(predicate, "fcmp_ugt", CmpInst::FCMP_UGT);
+    io.enumCase(predicate, "fcmp_uge", CmpInst::FCMP_UGE);
+    io.enumCase(predicate, "fcmp_ult", CmpInst::FCMP_ULT);
+    io.enumCase(predicate, "fcmp_ule", CmpInst::FCMP_ULE);
+    io.enumCase(predicate, "fcmp_une", CmpInst::FCMP_UNE);
+    io.enumCase(predicate, "true", CmpInst::FCMP_TRUE);
+    io.enumCase(predicate, "eq", CmpInst::ICMP_EQ);
+    io.enumCase(predicate, "ne", CmpInst::ICMP_NE);
+    io.enumCase(predicate, "ugt", CmpInst::ICMP_UGT);
+    io.enumCase(predicate, "uge", CmpInst::ICMP_UGE);
+    io.enumCase(predicate, "ult", CmpInst::ICMP_ULT);
+    io.enumCase(predicate, "ule", CmpInst::ICMP_ULE);
+    io.enumCase(predicate, "sgt", CmpInst::ICMP_SGT);
+    io.enumCase(predicate, "sge", CmpInst::ICMP_SGE);
+    io.enumCase(predicate, "slt", CmpInst::ICMP_SLT);
+    io.enumCase(predicate, "sle", CmpInst::ICMP_SLE);
+    io.enumCase(predicate, "bad", CmpInst::BAD_ICMP_PREDICATE);
+  }
+};
+
+template <> struct MappingTraits<SymEngine::CompiledCondition> {
+  static void mapping(yaml::IO &io, SymEngine::CompiledCondition &condition) {
+    io.mapRequired("predicate", condition.predicate);
+    io.mapRequired("expression", condition.expression);
+  }
+};
+
+template <> struct MappingTraits<SymEngine::AccessFormula> {
+  static void mapping(yaml::IO &io, SymEngine::AccessFormula &formula) {
+    io.mapRequired("load", formula.isLoad);
+    io.mapRequired("local", formula.isLocal);
+    io.mapRequired("subscript", formula.subscript);
+    io.mapRequired("conditions", formula.blockConditions);
+    io.mapRequired("trip_count", formula.tripCount);
+  }
+};
+
+template <> struct MappingTraits<SymEngine::KernelFormulas> {
+  static void mapping(yaml::IO &io, SymEngine::KernelFormulas &formulas) {
+    io.mapRequired("kernelName", formulas.kernelName);
+    io.mapRequired("accesses", formulas.accesses);
+  }
+};
+
+template <> struct MappingTraits<SymEngine::KernelResults> {
+  static void mapping(yaml::IO &io, SymEngine::KernelResults &results) {
+    io.mapRequired("load_transactions", results.loadTransactions);
+    io.mapRequired("store_transactions", results.storeTransactions);
+
+    io.mapRequired("load_bank_conflicts", results.loadBankConflicts);
+    io.mapRequired("store_bank_conflicts", results.storeBankConflicts);
+
+    if (results.sampling) {
+      io.mapRequired("load_transactions_error", results.loadTransactionsError);
+      io.mapRequired("store_transactions_error",
+                     results.storeTransactionsError);
+
+      io.mapRequired("load_bank_conflicts_error",
+                     results.loadBankConflictsError);
+      io.mapRequired("store_bank_conflicts_error",
+                     results.storeBankConflictsError);
+    }
+  }
+};
+
+template <> struct MappingTraits<SymEngine::SweepDimension> {
+  static void mapping(yaml::IO &io, SymEngine::SweepDimension &dimension) {
+    io.mapOptional("values", dimension.values);
+    io.mapOptional("min", dimension.min);
+    io.mapOptional("max", dimension.max);
+  }
+};
+
+template <> struct MappingTraits<SymEngine::SweepConfig> {
+  static void mapping(yaml::IO &io, SymEngine::SweepConfig &config) {
+    io.mapOptional("localSizeX", config.localSize[0]);
+    io.mapOptional("localSizeY", config.localSize[1]);
+    io.mapOptional("localSizeZ", config.localSize[2]);
+    io.mapOptional("globalSize", config.globalSize);
+    io.mapOptional("numberOfGroupsX", config.numberOfGroups[0]);
+    io.mapOptional("numberOfGroupsY", config.numberOfGroups[1]);
+    io.mapOptional("numberOfGroupsZ", config.numberOfGroups[2]);
+    io.mapOptional("maxGroupSize", config.maxGroupSize);
+  }
+};
+
 // Sequence of ints.
 template <> struct SequenceTraits<std::vector<int>> {
   static size_t size(yaml::IO &, std::vector<int> &seq) { return seq.size(); }
@@ -99,8 +244,14 @@ template <> struct SequenceTraits<std::vector<int>> {
 }
 }
 
+// The first profile if the file holds a list.
 SymEngine::HardwareConfig readHardwareConfig(const std::string &fileName);
+// Empty if the file holds a single configuration.
+std::vector<SymEngine::HardwareProfile>
+readHardwareProfiles(const std::string &fileName);
 SymEngine::KernelArgumentsVector readKernelArguments(const std::string &fileName);
 SymEngine::OpenCLConfig readOpenCLConfig(const std::string &fileName);
+SymEngine::KernelFormulas readKernelFormulas(const std::string &fileName);
+SymEngine::SweepConfig readSweepConfig(const std::string &fileName);
 
 #endif
@@ -0,0 +1,68 @@
+#include "SymEngine/AccessFormula.h"
+
+#include "SymEngine/NDRangePoint.h"
+#include "SymEngine/NDRangeSpace.h"
+#include "SymEngine/WarpSimulator.h"
+
+#include "llvm/Support/raw_ostream.h"
+
+using namespace llvm;
+using namespace SymEngine;
+
+//------------------------------------------------------------------------------
+int SymEngine::evaluateAccessFormula(const AccessFormula &formula,
+                                     const std::vector<int64_t> &arguments,
+                                     const NDRangeSpace *ndrSpace,
+                                     const HardwareConfig &hwConfig,
+                                     ThreadPool &threadPool) {
+  CompiledExpression subscript =
+      formula.subscript.bindArguments(arguments).bind(*ndrSpace);
+  if (!subscript.isComputable())
+    return -1;
+
+  std::vector<CompiledCondition> blockConditions;
+  for (const CompiledCondition &condition : formula.blockConditions) {
+    CompiledCondition bound = condition;
+    bound.expression =
+        condition.expression.bindArguments(arguments).bind(*ndrSpace);
+    blockConditions.push_back(bound);
+  }
+
+  WarpSimulator simulator(ndrSpace, hwConfig, threadPool);
+  WarpSimulator::ActiveMasks masks;
+  int result = simulator.countAccessesInNDRange(
+      subscript, blockConditions, masks,
+      formula.isLocal ? WarpSimulator::BANK_CONFLICTS
+                      : WarpSimulator::TRANSACTIONS);
+
+  // Trip counts do not depend on the work-item.
+  NDRangePoint pointZero;
+  int64_t tripCount = 0;
+  if (!formula.tripCount.bindArguments(arguments).bind(*ndrSpace).evaluate(
+          pointZero, tripCount)) {
+    errs() << "WARNING: loop trip count cannot be resolved, defaulting to "
+           << DEFAULT_LOOP_TRIP_COUNT << "\n";
+    tripCount = DEFAULT_LOOP_TRIP_COUNT;
+  }
+  return result * tripCount;
+}
+
+//------------------------------------------------------------------------------
+KernelResults SymEngine::evaluateKernelFormulas(
+    const KernelFormulas &kernel, const std::vector<int64_t> &arguments,
+    const NDRangeSpace *ndrSpace, const HardwareConfig &hwConfig,
+    ThreadPool &threadPool) {
+  KernelResults results;
+  results.sampling = false;
+  for (const AccessFormula &formula : kernel.accesses) {
+    int count = evaluateAccessFormula(formula, arguments, ndrSpace, hwConfig,
+                                      threadPool);
+    if (formula.isLocal)
+      (formula.isLoad ? results.loadBankConflicts : results.storeBankConflicts)
+          .push_back(count);
+    else
+      (formula.isLoad ? results.loadTransactions : results.storeTransactions)
+          .push_back(count);
+  }
+  return results;
+}
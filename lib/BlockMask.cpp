@@ -26,6 +26,7 @@ void BlockMask::createMasks() {
        ++iter) {
     BasicBlock *block = iter;
     auto &conditions = blocksMask[block];
+    auto &blockControllers = blocksControllers[block];
 
     // Perform an up-ward traversal of cd graph to determine the masks of the
     // controllers.
@@ -44,6 +45,7 @@ void BlockMask::createMasks() {
         condition.invertPredicate();
       
       conditions.push_back(condition);
+      blockControllers.push_back(controllerPair);
 
       controllers = cdGraph->getControllers(controller);
       toVisit.insert(controllers.begin(), controllers.end()); 
@@ -87,9 +89,37 @@ BlockCondition BlockMask::getBranchCondition(llvm::BasicBlock *block) {
     const SCEV *firstSCEV = scalarEvolution->getSCEV(firstOperand);
     const SCEV *secondSCEV = scalarEvolution->getSCEV(secondOperand);
 
+    // The sign of the difference only decides signed comparisons. An unsigned
+    // comparison checks instead which operand is the unsigned maximum.
+    CmpInst::Predicate predicate = cmpInst->getPredicate();
+    if (firstSCEV->getType()->isIntegerTy()) {
+      const SCEV *maximum =
+          scalarEvolution->getUMaxExpr(firstSCEV, secondSCEV);
+      switch (predicate) {
+      case CmpInst::ICMP_UGT:
+        return BlockCondition::createCondition(
+            scalarEvolution->getMinusSCEV(maximum, secondSCEV),
+            CmpInst::ICMP_NE);
+      case CmpInst::ICMP_UGE:
+        return BlockCondition::createCondition(
+            scalarEvolution->getMinusSCEV(maximum, firstSCEV),
+            CmpInst::ICMP_EQ);
+      case CmpInst::ICMP_ULT:
+        return BlockCondition::createCondition(
+            scalarEvolution->getMinusSCEV(maximum, firstSCEV),
+            CmpInst::ICMP_NE);
+      case CmpInst::ICMP_ULE:
+        return BlockCondition::createCondition(
+            scalarEvolution->getMinusSCEV(maximum, secondSCEV),
+            CmpInst::ICMP_EQ);
+      default:
+        break;
+      }
+    }
+
     const SCEV *diff = scalarEvolution->getMinusSCEV(firstSCEV, secondSCEV);
 
-    return BlockCondition::createCondition(diff, cmpInst->getPredicate());
+    return BlockCondition::createCondition(diff, predicate);
 
   } else {
     return BlockCondition::createTrueCondition();
@@ -101,3 +131,9 @@ std::vector<BlockCondition> BlockMask::getConditions(llvm::BasicBlock *block) {
   return blocksMask[block];
 }
 
+
+// -----------------------------------------------------------------------------
+std::vector<BlockBranchPair>
+BlockMask::getControllers(llvm::BasicBlock *block) {
+  return blocksControllers[block];
+}
@@ -0,0 +1,591 @@
+#include "SymEngine/CompiledExpression.h"
+
+#include "SymEngine/NDRangePoint.h"
+#include "SymEngine/NDRangeSpace.h"
+
+#include "llvm/ADT/SmallVector.h"
+
+#include "llvm/Support/raw_ostream.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cctype>
+#include <cstdlib>
+#include <sstream>
+
+using namespace llvm;
+using namespace SymEngine;
+
+//------------------------------------------------------------------------------
+AffineForm::AffineForm() : AffineForm(0) {}
+
+AffineForm::AffineForm(int64_t constant) : constant(constant) {
+  std::fill(coefficients, coefficients + COORDINATE_NUMBER, 0);
+}
+
+bool AffineForm::isConstant() const {
+  return std::all_of(coefficients, coefficients + COORDINATE_NUMBER,
+                     [](int64_t coefficient) { return coefficient == 0; });
+}
+
+int64_t AffineForm::evaluate(const NDRangePoint &point) const {
+  int64_t result = constant;
+  for (int direction = 0; direction < 3; ++direction) {
+    result += coefficients[direction] * point.getLocal(direction);
+    result += coefficients[3 + direction] * point.getGlobal(direction);
+    result += coefficients[6 + direction] * point.getGroup(direction);
+  }
+  return result;
+}
+
+//------------------------------------------------------------------------------
+CompiledExpression::CompiledExpression() : computable(true), affine(false) {}
+
+CompiledExpression CompiledExpression::createConstant(int64_t value) {
+  CompiledExpression result;
+  result.appendConstant(value);
+  return result;
+}
+
+CompiledExpression CompiledExpression::createUnknown() {
+  CompiledExpression result;
+  result.setUnknown();
+  return result;
+}
+
+//------------------------------------------------------------------------------
+void CompiledExpression::appendConstant(int64_t value) {
+  if (!computable)
+    return;
+  nodes.push_back({CONSTANT, value});
+}
+
+void CompiledExpression::appendCoordinate(OpCode opCode, int direction) {
+  assert(isCoordinate(opCode) && "Not a coordinate");
+  if (!computable)
+    return;
+  nodes.push_back({opCode, direction});
+}
+
+void CompiledExpression::appendSize(OpCode opCode, int direction) {
+  assert(isSize(opCode) && "Not a size");
+  if (!computable)
+    return;
+  nodes.push_back({opCode, direction});
+}
+
+void CompiledExpression::appendOperation(OpCode opCode, int operandNumber) {
+  assert(isOperation(opCode) && "Not an operation");
+  if (!computable)
+    return;
+  nodes.push_back({opCode, operandNumber});
+}
+
+void CompiledExpression::appendArgument(int argumentIndex) {
+  if (!computable)
+    return;
+  nodes.push_back({ARGUMENT, argumentIndex});
+}
+
+void CompiledExpression::appendExpression(
+    const CompiledExpression &expression) {
+  if (!expression.computable)
+    return setUnknown();
+  if (!computable)
+    return;
+  nodes.insert(nodes.end(), expression.nodes.begin(), expression.nodes.end());
+}
+
+void CompiledExpression::setUnknown() {
+  nodes.clear();
+  computable = false;
+  affine = false;
+}
+
+bool CompiledExpression::isComputable() const { return computable; }
+
+bool CompiledExpression::isAffine() const { return affine; }
+
+const AffineForm &CompiledExpression::getAffineForm() const {
+  return affineForm;
+}
+
+const std::vector<CompiledExpression::Node> &
+CompiledExpression::getNodes() const {
+  return nodes;
+}
+
+CompiledExpression::Uniformity CompiledExpression::getUniformity() const {
+  if (!computable)
+    return VARYING;
+
+  Uniformity result = UNIFORM;
+  for (const Node &node : nodes) {
+    if (node.opCode == LOCAL_ID || node.opCode == GLOBAL_ID)
+      return VARYING;
+    if (node.opCode == GROUP_ID)
+      result = GROUP_UNIFORM;
+  }
+  return result;
+}
+
+//------------------------------------------------------------------------------
+int CompiledExpression::getCoordinateIndex(OpCode opCode, int direction) {
+  switch (opCode) {
+  case LOCAL_ID:
+    return direction;
+  case GLOBAL_ID:
+    return 3 + direction;
+  case GROUP_ID:
+    return 6 + direction;
+  default:
+    return -1;
+  }
+}
+
+bool CompiledExpression::isCoordinate(OpCode opCode) {
+  return opCode == LOCAL_ID || opCode == GLOBAL_ID || opCode == GROUP_ID;
+}
+
+bool CompiledExpression::isSize(OpCode opCode) {
+  return opCode == LOCAL_SIZE || opCode == GLOBAL_SIZE ||
+         opCode == GROUPS_NUMBER;
+}
+
+bool CompiledExpression::isOperation(OpCode opCode) { return opCode >= ADD; }
+
+bool CompiledExpression::isCommutative(OpCode opCode) {
+  return opCode == ADD || opCode == MUL || opCode == SMAX || opCode == UMAX;
+}
+
+//------------------------------------------------------------------------------
+bool CompiledExpression::applyOperation(OpCode opCode, const int64_t *operands,
+                                        int operandNumber, int64_t &result) {
+  result = operands[0];
+  switch (opCode) {
+  case ADD:
+    for (int index = 1; index < operandNumber; ++index)
+      result += operands[index];
+    return true;
+  case MUL:
+    for (int index = 1; index < operandNumber; ++index)
+      result *= operands[index];
+    return true;
+  case SMAX:
+    for (int index = 1; index < operandNumber; ++index)
+      result = std::max(result, operands[index]);
+    return true;
+  case UMAX:
+    for (int index = 1; index < operandNumber; ++index)
+      if (static_cast<uint64_t>(operands[index]) >
+          static_cast<uint64_t>(result))
+        result = operands[index];
+    return true;
+  case UDIV:
+    assert(operandNumber == 2 && "Division must have two operands");
+    if (operands[1] == 0)
+      return false;
+    result = static_cast<uint64_t>(operands[0]) /
+             static_cast<uint64_t>(operands[1]);
+    return true;
+  case SDIV:
+    assert(operandNumber == 2 && "Division must have two operands");
+    // The only signed division that overflows is undefined in LLVM too.
+    if (operands[1] == 0 ||
+        (operands[0] == INT64_MIN && operands[1] == -1))
+      return false;
+    result = operands[0] / operands[1];
+    return true;
+  case UREM:
+    assert(operandNumber == 2 && "Remainder must have two operands");
+    if (operands[1] == 0)
+      return false;
+    result = static_cast<uint64_t>(operands[0]) %
+             static_cast<uint64_t>(operands[1]);
+    return true;
+  default:
+    return false;
+  }
+}
+
+//------------------------------------------------------------------------------
+CompiledExpression CompiledExpression::bindArguments(
+    const std::vector<int64_t> &arguments) const {
+  if (!computable)
+    return createUnknown();
+
+  CompiledExpression result;
+  for (const Node &node : nodes) {
+    if (node.opCode != ARGUMENT) {
+      result.nodes.push_back(node);
+      continue;
+    }
+    if (node.value < 0 || node.value >= static_cast<int64_t>(arguments.size()))
+      return createUnknown();
+    result.appendConstant(arguments[node.value]);
+  }
+  return result;
+}
+
+//------------------------------------------------------------------------------
+CompiledExpression
+CompiledExpression::bind(const NDRangeSpace &ndrSpace) const {
+  if (!computable)
+    return createUnknown();
+
+  // For each operand on the stack keep where its nodes start in the result and
+  // whether it folded to a constant.
+  struct Operand {
+    size_t start;
+    bool isConstant;
+    int64_t value;
+  };
+
+  CompiledExpression result;
+  SmallVector<Operand, 16> stack;
+  SmallVector<int64_t, 8> values;
+
+  for (const Node &node : nodes) {
+    size_t start = result.nodes.size();
+
+    if (node.opCode == CONSTANT) {
+      result.appendConstant(node.value);
+      stack.push_back({start, true, node.value});
+      continue;
+    }
+
+    // Arguments must have been bound with bindArguments().
+    if (node.opCode == ARGUMENT)
+      return createUnknown();
+
+    if (isCoordinate(node.opCode)) {
+      result.nodes.push_back(node);
+      stack.push_back({start, false, 0});
+      continue;
+    }
+
+    if (isSize(node.opCode)) {
+      int direction = node.value;
+      int64_t size = 0;
+      if (node.opCode == LOCAL_SIZE)
+        size = ndrSpace.getLocalSize(direction);
+      if (node.opCode == GLOBAL_SIZE)
+        size = ndrSpace.getGlobalSize(direction);
+      if (node.opCode == GROUPS_NUMBER)
+        size = ndrSpace.getNumberOfGroups(direction);
+      result.appendConstant(size);
+      stack.push_back({start, true, size});
+      continue;
+    }
+
+    int operandNumber = node.value;
+    assert(stack.size() >= static_cast<size_t>(operandNumber) &&
+           "Malformed expression");
+    auto first = stack.end() - operandNumber;
+    size_t operationStart = first->start;
+
+    values.clear();
+    for (auto iter = first; iter != stack.end(); ++iter)
+      if (iter->isConstant)
+        values.push_back(iter->value);
+    int constantNumber = values.size();
+
+    if (constantNumber == operandNumber) {
+      int64_t value = 0;
+      if (!applyOperation(node.opCode, values.data(), operandNumber, value))
+        return createUnknown();
+      stack.erase(first, stack.end());
+      result.nodes.resize(operationStart);
+      result.appendConstant(value);
+      stack.push_back({operationStart, true, value});
+      continue;
+    }
+
+    if (constantNumber == 0 || !isCommutative(node.opCode)) {
+      stack.erase(first, stack.end());
+      result.nodes.push_back(node);
+      stack.push_back({operationStart, false, 0});
+      continue;
+    }
+
+    // Commutative operation with some constant operands: fold them into a
+    // single constant, placed after the other operands.
+    int64_t folded = 0;
+    applyOperation(node.opCode, values.data(), constantNumber, folded);
+
+    if (node.opCode == MUL && folded == 0) {
+      stack.erase(first, stack.end());
+      result.nodes.resize(operationStart);
+      result.appendConstant(0);
+      stack.push_back({operationStart, true, 0});
+      continue;
+    }
+
+    SmallVector<Node, 16> variables;
+    int variableNumber = 0;
+    for (auto iter = first; iter != stack.end(); ++iter) {
+      if (iter->isConstant)
+        continue;
+      size_t end =
+          (iter + 1 == stack.end()) ? result.nodes.size() : (iter + 1)->start;
+      variables.append(result.nodes.begin() + iter->start,
+                       result.nodes.begin() + end);
+      ++variableNumber;
+    }
+
+    stack.erase(first, stack.end());
+    result.nodes.resize(operationStart);
+    result.nodes.insert(result.nodes.end(), variables.begin(), variables.end());
+
+    // Adding 0 or multiplying by 1 does not change the result.
+    bool isIdentity = (node.opCode == ADD && folded == 0) ||
+                      (node.opCode == MUL && folded == 1);
+    if (!isIdentity) {
+      result.appendConstant(folded);
+      ++variableNumber;
+    }
+    if (variableNumber > 1)
+      result.appendOperation(node.opCode, variableNumber);
+    stack.push_back({operationStart, false, 0});
+  }
+
+  assert(stack.size() == 1 && "Malformed expression");
+  result.computeAffineForm();
+  return result;
+}
+
+//------------------------------------------------------------------------------
+CompiledExpression CompiledExpression::specialize(const NDRangeSpace &ndrSpace,
+                                                  int groupX, int groupY,
+                                                  int groupZ) const {
+  if (!computable)
+    return createUnknown();
+
+  int group[] = {groupX, groupY, groupZ};
+  CompiledExpression result;
+  for (const Node &node : nodes) {
+    int direction = node.value;
+    if (node.opCode == GROUP_ID) {
+      result.appendConstant(group[direction]);
+    } else if (node.opCode == GLOBAL_ID) {
+      result.appendCoordinate(LOCAL_ID, direction);
+      result.appendConstant(static_cast<int64_t>(group[direction]) *
+                            ndrSpace.getLocalSize(direction));
+      result.appendOperation(ADD, 2);
+    } else {
+      result.nodes.push_back(node);
+    }
+  }
+
+  return result.bind(ndrSpace);
+}
+
+//------------------------------------------------------------------------------
+void CompiledExpression::computeAffineForm() {
+  affine = false;
+  SmallVector<AffineForm, 16> stack;
+
+  for (const Node &node : nodes) {
+    if (node.opCode == CONSTANT) {
+      stack.push_back(AffineForm(node.value));
+      continue;
+    }
+
+    if (isCoordinate(node.opCode)) {
+      AffineForm form;
+      form.coefficients[getCoordinateIndex(node.opCode, node.value)] = 1;
+      stack.push_back(form);
+      continue;
+    }
+
+    // Sizes and arguments must have been bound.
+    if (isSize(node.opCode) || node.opCode == ARGUMENT)
+      return;
+
+    int operandNumber = node.value;
+    auto first = stack.end() - operandNumber;
+    AffineForm form;
+
+    if (node.opCode == ADD) {
+      for (auto iter = first; iter != stack.end(); ++iter) {
+        form.constant += iter->constant;
+        for (int index = 0; index < AffineForm::COORDINATE_NUMBER; ++index)
+          form.coefficients[index] += iter->coefficients[index];
+      }
+    } else if (node.opCode == MUL) {
+      // The product is affine only if at most one factor is not constant.
+      auto variable = std::find_if(
+          first, stack.end(),
+          [](const AffineForm &operand) { return !operand.isConstant(); });
+      if (variable != stack.end() &&
+          std::find_if(variable + 1, stack.end(),
+                       [](const AffineForm &operand) {
+                         return !operand.isConstant();
+                       }) != stack.end())
+        return;
+
+      int64_t factor = 1;
+      for (auto iter = first; iter != stack.end(); ++iter)
+        if (iter != variable)
+          factor *= iter->constant;
+
+      form = (variable != stack.end()) ? *variable : AffineForm(1);
+      form.constant *= factor;
+      for (int index = 0; index < AffineForm::COORDINATE_NUMBER; ++index)
+        form.coefficients[index] *= factor;
+    } else {
+      // Division, remainder and max are affine only on constants, which have
+      // already been folded by bind().
+      return;
+    }
+
+    stack.erase(first, stack.end());
+    stack.push_back(form);
+  }
+
+  assert(stack.size() == 1 && "Malformed expression");
+  affineForm = stack.back();
+  affine = true;
+}
+
+//------------------------------------------------------------------------------
+bool CompiledExpression::evaluate(const NDRangePoint &point,
+                                  int64_t &result) const {
+  if (!computable)
+    return false;
+
+  if (affine) {
+    result = affineForm.evaluate(point);
+    return true;
+  }
+
+  SmallVector<int64_t, 16> stack;
+  for (const Node &node : nodes) {
+    switch (node.opCode) {
+    case CONSTANT:
+      stack.push_back(node.value);
+      break;
+    case LOCAL_ID:
+      stack.push_back(point.getLocal(node.value));
+      break;
+    case GLOBAL_ID:
+      stack.push_back(point.getGlobal(node.value));
+      break;
+    case GROUP_ID:
+      stack.push_back(point.getGroup(node.value));
+      break;
+    case LOCAL_SIZE:
+    case GLOBAL_SIZE:
+    case GROUPS_NUMBER:
+    case ARGUMENT:
+      assert(false && "Evaluating an expression that has not been bound");
+      return false;
+    default: {
+      int operandNumber = node.value;
+      int64_t value = 0;
+      if (!applyOperation(node.opCode, stack.end() - operandNumber,
+                          operandNumber, value))
+        return false;
+      stack.resize(stack.size() - operandNumber);
+      stack.push_back(value);
+    }
+    }
+  }
+
+  assert(stack.size() == 1 && "Malformed expression");
+  result = stack.back();
+  return true;
+}
+
+//------------------------------------------------------------------------------
+void CompiledExpression::dump() const {
+  static const char *names[] = {"const",  "local_id",   "global_id",
+                                "group_id", "local_size", "global_size",
+                                "num_groups", "arg", "add", "mul", "udiv",
+                                "sdiv", "urem", "smax", "umax"};
+  if (!computable) {
+    errs() << "Compiled expression: unknown\n";
+    return;
+  }
+
+  errs() << "Compiled expression:";
+  for (const Node &node : nodes)
+    errs() << " " << names[node.opCode] << "(" << node.value << ")";
+  errs() << (affine ? " [affine]\n" : "\n");
+}
+
+//------------------------------------------------------------------------------
+// Tokens of the textual form, indexed by opcode. Constants have no token.
+static const char *TOKEN_NAMES[] = {"",     "lid",  "gid",  "grp",  "lsz",
+                                    "gsz",  "ngr",  "arg",  "add",  "mul",
+                                    "udiv", "sdiv", "urem", "smax", "umax"};
+
+//------------------------------------------------------------------------------
+std::string CompiledExpression::toString() const {
+  if (!computable)
+    return "unknown";
+
+  std::ostringstream stream;
+  for (size_t index = 0; index < nodes.size(); ++index) {
+    if (index != 0)
+      stream << " ";
+    if (nodes[index].opCode != CONSTANT)
+      stream << TOKEN_NAMES[nodes[index].opCode];
+    stream << nodes[index].value;
+  }
+  return stream.str();
+}
+
+//------------------------------------------------------------------------------
+bool CompiledExpression::parse(const std::string &text,
+                               CompiledExpression &result) {
+  result = CompiledExpression();
+  if (text == "unknown") {
+    result.setUnknown();
+    return true;
+  }
+
+  // Number of operands on the stack, to reject malformed expressions.
+  int64_t depth = 0;
+  std::istringstream stream(text);
+  std::string token;
+  while (stream >> token) {
+    size_t nameLength = 0;
+    while (nameLength < token.size() && std::isalpha(token[nameLength]))
+      ++nameLength;
+
+    char *end = nullptr;
+    const char *number = token.c_str() + nameLength;
+    int64_t value = std::strtoll(number, &end, 10);
+    if (*number == '\0' || *end != '\0')
+      return false;
+
+    if (nameLength == 0) {
+      result.appendConstant(value);
+      ++depth;
+      continue;
+    }
+
+    std::string name = token.substr(0, nameLength);
+    auto nameEnd = TOKEN_NAMES + UMAX + 1;
+    auto iter = std::find_if(TOKEN_NAMES + 1, nameEnd, [&](const char *other) {
+      return name == other;
+    });
+    if (iter == nameEnd)
+      return false;
+
+    OpCode opCode = static_cast<OpCode>(iter - TOKEN_NAMES);
+    if (isOperation(opCode)) {
+      if (value < 1 || value > depth)
+        return false;
+      depth -= value - 1;
+    } else {
+      if (value < 0 || (opCode != ARGUMENT && value > 2))
+        return false;
+      ++depth;
+    }
+    result.nodes.push_back({opCode, value});
+  }
+
+  return depth == 1;
+}
@@ -0,0 +1,118 @@
+#include "SymEngine/FormulaCache.h"
+
+#include "SymEngine/ModulePipeline.h"
+
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+
+#include "llvm/Support/FileSystem.h"
+
+#include <chrono>
+
+using namespace llvm;
+using namespace SymEngine;
+
+//------------------------------------------------------------------------------
+FormulaCache::FormulaCache(unsigned int inlineThreshold)
+    : inlineThreshold(inlineThreshold), loadNumber(0) {}
+
+//------------------------------------------------------------------------------
+// The first request for a version of the file compiles it, the following ones
+// wait for its compilation.
+std::shared_ptr<const FormulaCache::ModuleFormulas>
+FormulaCache::getModule(const std::string &fileName, std::string &error) {
+  sys::fs::file_status status;
+  if (sys::fs::status(fileName, status)) {
+    error = "cannot read module " + fileName;
+    return nullptr;
+  }
+
+  std::promise<CompiledModule> promise;
+  std::shared_future<CompiledModule> compilation;
+  bool compiles = false;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto iter = modules.find(fileName);
+    if (iter != modules.end() &&
+        iter->second.modificationTime == status.getLastModificationTime()) {
+      compilation = iter->second.compilation;
+    } else {
+      Entry &entry = modules[fileName];
+      entry.modificationTime = status.getLastModificationTime();
+      entry.compilation = promise.get_future().share();
+      entry.loadIndex = loadNumber++;
+      compilation = entry.compilation;
+      compiles = true;
+    }
+  }
+
+  if (compiles) {
+    CompiledModule result;
+    LLVMContext context;
+    std::unique_ptr<Module> module = loadModule(fileName, context, result.error);
+    if (module)
+      result.kernels = std::make_shared<const ModuleFormulas>(
+          compileModuleFormulas(*module, inlineThreshold));
+    promise.set_value(result);
+  }
+
+  const CompiledModule &result = compilation.get();
+  if (result.kernels == nullptr)
+    error = result.error;
+  return result.kernels;
+}
+
+//------------------------------------------------------------------------------
+static const KernelFormulas *
+findKernel(const std::vector<KernelFormulas> &kernels,
+           const std::string &kernelName) {
+  for (const KernelFormulas &kernel : kernels)
+    if (kernel.kernelName == kernelName)
+      return &kernel;
+  return nullptr;
+}
+
+//------------------------------------------------------------------------------
+// Modules being compiled are skipped rather than waited for.
+std::shared_ptr<const FormulaCache::ModuleFormulas>
+FormulaCache::findLastModule(const std::string &kernelName) const {
+  std::shared_ptr<const ModuleFormulas> kernels;
+  unsigned int loadIndex = 0;
+  for (auto &module : modules) {
+    const Entry &entry = module.second;
+    if ((kernels != nullptr && entry.loadIndex < loadIndex) ||
+        entry.compilation.wait_for(std::chrono::seconds(0)) !=
+            std::future_status::ready)
+      continue;
+    const CompiledModule &compiled = entry.compilation.get();
+    if (compiled.kernels != nullptr &&
+        findKernel(*compiled.kernels, kernelName) != nullptr) {
+      kernels = compiled.kernels;
+      loadIndex = entry.loadIndex;
+    }
+  }
+  return kernels;
+}
+
+//------------------------------------------------------------------------------
+std::shared_ptr<const KernelFormulas>
+FormulaCache::getKernel(const std::string &fileName,
+                        const std::string &kernelName, std::string &error) {
+  std::shared_ptr<const ModuleFormulas> kernels;
+  if (fileName.empty()) {
+    std::lock_guard<std::mutex> lock(mutex);
+    kernels = findLastModule(kernelName);
+  } else if ((kernels = getModule(fileName, error)) == nullptr) {
+    return nullptr;
+  }
+
+  const KernelFormulas *kernel =
+      kernels == nullptr ? nullptr : findKernel(*kernels, kernelName);
+  if (kernel == nullptr) {
+    error = "kernel " + kernelName + " not found";
+    return nullptr;
+  }
+
+  // The kernel shares the ownership of the formulas of its module.
+  return std::shared_ptr<const KernelFormulas>(kernels, kernel);
+}
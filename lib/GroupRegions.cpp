@@ -0,0 +1,244 @@
+#include "SymEngine/GroupRegions.h"
+
+#include "SymEngine/CompiledExpression.h"
+#include "SymEngine/MemoryAccessesAnalyzer.h"
+#include "SymEngine/NDRange.h"
+#include "SymEngine/NDRangeSpace.h"
+#include "SymEngine/SubscriptCompiler.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+using namespace SymEngine;
+
+//------------------------------------------------------------------------------
+long GroupRegion::getGroupNumber() const {
+  long result = 1;
+  for (int direction = 0; direction < NDRange::DIRECTION_NUMBER; ++direction)
+    result *= end[direction] - begin[direction];
+  return result;
+}
+
+//------------------------------------------------------------------------------
+long GroupRegion::getRepresentativeNumber() const {
+  long result = 1;
+  for (int direction = 0; direction < NDRange::DIRECTION_NUMBER; ++direction)
+    result *= std::min(end[direction] - begin[direction], period[direction]);
+  return result;
+}
+
+//------------------------------------------------------------------------------
+long GroupRegion::getMultiplicity(const int *offsets) const {
+  long result = 1;
+  for (int direction = 0; direction < NDRange::DIRECTION_NUMBER; ++direction)
+    result *= (end[direction] - begin[direction] - 1 - offsets[direction]) /
+                  period[direction] +
+              1;
+  return result;
+}
+
+//------------------------------------------------------------------------------
+// Whether the expression reads the group id of the work-items, directly or
+// through the global id, along a direction spanned by the region.
+static bool dependsOnGroup(const CompiledExpression &expression,
+                           const bool *spanned) {
+  for (const CompiledExpression::Node &node : expression.getNodes())
+    if ((node.opCode == CompiledExpression::GROUP_ID ||
+         node.opCode == CompiledExpression::GLOBAL_ID) &&
+        spanned[node.value])
+      return true;
+  return false;
+}
+
+//------------------------------------------------------------------------------
+// Write the coefficients of the affine form in terms of independent variables:
+// the local id and the group id. global id = group id * local size + local id.
+static void getIndependentCoefficients(const AffineForm &form,
+                                       const NDRangeSpace &ndrSpace,
+                                       int64_t *localCoefficients,
+                                       int64_t *groupCoefficients) {
+  for (int direction = 0; direction < NDRange::DIRECTION_NUMBER; ++direction) {
+    int64_t global = form.coefficients[3 + direction];
+    localCoefficients[direction] = form.coefficients[direction] + global;
+    groupCoefficients[direction] =
+        form.coefficients[6 + direction] +
+        global * ndrSpace.getLocalSize(direction);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Smallest and largest value of the affine form over the work-items of the
+// region.
+static void getBounds(const AffineForm &form, const GroupRegion &region,
+                      const NDRangeSpace &ndrSpace, int64_t &minimum,
+                      int64_t &maximum) {
+  int64_t localCoefficients[3];
+  int64_t groupCoefficients[3];
+  getIndependentCoefficients(form, ndrSpace, localCoefficients,
+                             groupCoefficients);
+
+  minimum = maximum = form.constant;
+  for (int direction = 0; direction < NDRange::DIRECTION_NUMBER; ++direction) {
+    int64_t lastLocal = ndrSpace.getLocalSize(direction) - 1;
+    int64_t terms[] = {0, localCoefficients[direction] * lastLocal,
+                       groupCoefficients[direction] * region.begin[direction],
+                       groupCoefficients[direction] *
+                           (region.end[direction] - 1)};
+    minimum += std::min(terms[0], terms[1]) + std::min(terms[2], terms[3]);
+    maximum += std::max(terms[0], terms[1]) + std::max(terms[2], terms[3]);
+  }
+}
+
+//------------------------------------------------------------------------------
+static bool isConditionInvariant(const CompiledCondition &condition,
+                                 const GroupRegion &region,
+                                 const NDRangeSpace &ndrSpace,
+                                 const bool *spanned) {
+  // Conditions that cannot be computed are false for all the work-items.
+  const CompiledExpression &expression = condition.expression;
+  if (!expression.isComputable() || !dependsOnGroup(expression, spanned))
+    return true;
+  if (!expression.isAffine())
+    return false;
+
+  int64_t localCoefficients[3];
+  int64_t groupCoefficients[3];
+  getIndependentCoefficients(expression.getAffineForm(), ndrSpace,
+                             localCoefficients, groupCoefficients);
+  bool groupInvariant = true;
+  for (int direction = 0; direction < NDRange::DIRECTION_NUMBER; ++direction)
+    groupInvariant &= !spanned[direction] || groupCoefficients[direction] == 0;
+  if (groupInvariant)
+    return true;
+
+  // The value of a condition only depends on the sign of its expression:
+  // check that it is the same at the ends of the range and at 0.
+  int64_t minimum = 0;
+  int64_t maximum = 0;
+  getBounds(expression.getAffineForm(), region, ndrSpace, minimum, maximum);
+  bool value = BlockCondition::getBooleanValue(minimum, condition.predicate);
+  if (BlockCondition::getBooleanValue(maximum, condition.predicate) != value)
+    return false;
+  return minimum > 0 || maximum < 0 ||
+         BlockCondition::getBooleanValue(0, condition.predicate) == value;
+}
+
+//------------------------------------------------------------------------------
+static bool
+isSubscriptPeriodic(const CompiledExpression &subscript,
+                    const GroupRegion &region, const NDRangeSpace &ndrSpace,
+                    int64_t period, const bool *spanned) {
+  if (!dependsOnGroup(subscript, spanned))
+    return true;
+  if (!subscript.isAffine() || period <= 0)
+    return false;
+
+  // Shifts do not preserve the counts of negative addresses.
+  int64_t minimum = 0;
+  int64_t maximum = 0;
+  getBounds(subscript.getAffineForm(), region, ndrSpace, minimum, maximum);
+  return minimum >= 0;
+}
+
+//------------------------------------------------------------------------------
+static bool isPeriodic(const GroupRegion &region,
+                       const CompiledExpression &subscript,
+                       const std::vector<CompiledCondition> &blockConditions,
+                       const NDRangeSpace &ndrSpace, int64_t period,
+                       const bool *spanned) {
+  if (!isSubscriptPeriodic(subscript, region, ndrSpace, period, spanned))
+    return false;
+  for (const CompiledCondition &condition : blockConditions)
+    if (!isConditionInvariant(condition, region, ndrSpace, spanned))
+      return false;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// The address of the work-items of the groups at g * stride along a direction
+// moves by g * stride * c: it comes back to the same residue modulo period
+// when stride * c is a multiple of period.
+static void setPeriods(GroupRegion &region, const CompiledExpression &subscript,
+                       const NDRangeSpace &ndrSpace, int64_t period) {
+  std::fill(region.period, region.period + NDRange::DIRECTION_NUMBER, 1);
+  if (!subscript.isAffine() || period <= 0)
+    return;
+
+  int64_t localCoefficients[3];
+  int64_t groupCoefficients[3];
+  getIndependentCoefficients(subscript.getAffineForm(), ndrSpace,
+                             localCoefficients, groupCoefficients);
+  for (int direction = 0; direction < NDRange::DIRECTION_NUMBER; ++direction)
+    region.period[direction] =
+        period / greatestCommonDivisor(
+                     std::abs(groupCoefficients[direction]) % period, period);
+}
+
+//------------------------------------------------------------------------------
+static void
+partitionRegion(const GroupRegion &region, const CompiledExpression &subscript,
+                const std::vector<CompiledCondition> &blockConditions,
+                const NDRangeSpace &ndrSpace, int64_t period,
+                std::vector<GroupRegion> &regions) {
+  bool spanned[3];
+  for (int direction = 0; direction < NDRange::DIRECTION_NUMBER; ++direction)
+    spanned[direction] = region.end[direction] - region.begin[direction] > 1;
+
+  // Single groups are always periodic.
+  if (isPeriodic(region, subscript, blockConditions, ndrSpace, period,
+                 spanned)) {
+    regions.push_back(region);
+    setPeriods(regions.back(), subscript, ndrSpace, period);
+    return;
+  }
+
+  // Split the longest direction along which the region is not periodic on
+  // its own, or the longest direction if the variance comes from their
+  // combination.
+  int longest = -1;
+  int longestVariant = -1;
+  for (int direction = 0; direction < NDRange::DIRECTION_NUMBER; ++direction) {
+    if (!spanned[direction])
+      continue;
+    int size = region.end[direction] - region.begin[direction];
+    if (longest == -1 || size > region.end[longest] - region.begin[longest])
+      longest = direction;
+
+    bool alone[3] = {false, false, false};
+    alone[direction] = true;
+    if (!isPeriodic(region, subscript, blockConditions, ndrSpace, period,
+                    alone) &&
+        (longestVariant == -1 ||
+         size > region.end[longestVariant] - region.begin[longestVariant]))
+      longestVariant = direction;
+  }
+  int direction = longestVariant != -1 ? longestVariant : longest;
+
+  GroupRegion first = region;
+  GroupRegion second = region;
+  int middle = (region.begin[direction] + region.end[direction]) / 2;
+  first.end[direction] = middle;
+  second.begin[direction] = middle;
+  partitionRegion(first, subscript, blockConditions, ndrSpace, period,
+                  regions);
+  partitionRegion(second, subscript, blockConditions, ndrSpace, period,
+                  regions);
+}
+
+//------------------------------------------------------------------------------
+std::vector<GroupRegion> SymEngine::findPeriodicRegions(
+    const CompiledExpression &subscript,
+    const std::vector<CompiledCondition> &blockConditions,
+    const NDRangeSpace &ndrSpace, int64_t period) {
+  std::vector<GroupRegion> regions;
+  GroupRegion grid = {{0, 0, 0},
+                      {ndrSpace.getNumberOfGroupsX(),
+                       ndrSpace.getNumberOfGroupsY(),
+                       ndrSpace.getNumberOfGroupsZ()},
+                      {1, 1, 1}};
+  if (grid.getGroupNumber() == 0)
+    return regions;
+
+  partitionRegion(grid, subscript, blockConditions, ndrSpace, period, regions);
+  return regions;
+}
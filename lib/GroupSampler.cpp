@@ -0,0 +1,210 @@
+#include "SymEngine/GroupSampler.h"
+
+#include "SymEngine/NDRange.h"
+#include "SymEngine/NDRangeSpace.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <unordered_map>
+
+using namespace SymEngine;
+
+constexpr double GroupSampler::CONFIDENCE_Z;
+constexpr long GroupSampler::MIN_STRATUM_SAMPLE;
+constexpr long GroupSampler::INITIAL_SAMPLE;
+
+//------------------------------------------------------------------------------
+GroupSampler::GroupSampler(const NDRangeSpace *ndrSpace, int warpsPerGroup,
+                           double relativeError, unsigned int seed)
+    : ndrSpace(ndrSpace), warpsPerGroup(warpsPerGroup),
+      relativeError(relativeError), seed(seed) {
+  int groupsX = ndrSpace->getNumberOfGroupsX();
+  int groupsY = ndrSpace->getNumberOfGroupsY();
+  int groupsZ = ndrSpace->getNumberOfGroupsZ();
+
+  // Groups are numbered in row major order.
+  int groupIndex = 0;
+  for (int groupZ = 0; groupZ < groupsZ; ++groupZ)
+    for (int groupY = 0; groupY < groupsY; ++groupY)
+      for (int groupX = 0; groupX < groupsX; ++groupX, ++groupIndex)
+        strata[getStratum(ndrSpace, groupX, groupY, groupZ)].push_back(
+            groupIndex);
+}
+
+//------------------------------------------------------------------------------
+GroupSampler::Stratum GroupSampler::getStratum(const NDRangeSpace *ndrSpace,
+                                               int groupX, int groupY,
+                                               int groupZ) {
+  int group[] = {groupX, groupY, groupZ};
+
+  // Count the directions in which the group lies on the border of the grid.
+  // Directions with a single group do not have a border.
+  int borderDirections = 0;
+  for (int direction = 0; direction < NDRange::DIRECTION_NUMBER; ++direction) {
+    int groupsNumber = ndrSpace->getNumberOfGroups(direction);
+    if (groupsNumber > 1 &&
+        (group[direction] == 0 || group[direction] == groupsNumber - 1))
+      ++borderDirections;
+  }
+
+  if (borderDirections == 0)
+    return INTERIOR;
+  if (borderDirections == 1)
+    return EDGE;
+  return CORNER;
+}
+
+//------------------------------------------------------------------------------
+long GroupSampler::getStratumSize(Stratum stratum) const {
+  return static_cast<long>(strata[stratum].size()) * warpsPerGroup;
+}
+
+//------------------------------------------------------------------------------
+SamplingUnit GroupSampler::getUnit(Stratum stratum, long index) const {
+  int groupIndex = strata[stratum][index / warpsPerGroup];
+  int groupsX = ndrSpace->getNumberOfGroupsX();
+  int groupsY = ndrSpace->getNumberOfGroupsY();
+
+  SamplingUnit unit;
+  unit.groupX = groupIndex % groupsX;
+  unit.groupY = (groupIndex / groupsX) % groupsY;
+  unit.groupZ = groupIndex / (groupsX * groupsY);
+  unit.warpIndex = index % warpsPerGroup;
+  return unit;
+}
+
+//------------------------------------------------------------------------------
+SampledEstimate
+GroupSampler::estimateTotal(const UnitEvaluator &evaluator) const {
+  struct StratumState {
+    long size;
+    long sampled;
+    double sum;
+    double sumOfSquares;
+    // Sparse Fisher-Yates shuffle of the units of the stratum: positions that
+    // have been swapped and the unit they hold.
+    std::unordered_map<long, long> swapped;
+
+    long unitAt(long position) const {
+      auto iter = swapped.find(position);
+      return iter == swapped.end() ? position : iter->second;
+    }
+
+    double getVariance() const {
+      if (sampled < 2)
+        return 0;
+      double mean = sum / sampled;
+      double variance = (sumOfSquares - sampled * mean * mean) / (sampled - 1);
+      return std::max(variance, 0.0);
+    }
+  };
+
+  std::mt19937_64 generator(seed);
+  StratumState states[STRATA_NUMBER];
+  long populationSize = 0;
+  for (int stratum = 0; stratum < STRATA_NUMBER; ++stratum) {
+    states[stratum].size = getStratumSize(static_cast<Stratum>(stratum));
+    states[stratum].sampled = 0;
+    states[stratum].sum = 0;
+    states[stratum].sumOfSquares = 0;
+    populationSize += states[stratum].size;
+  }
+
+  SampledEstimate estimate = {0, 0, 0, populationSize};
+  if (populationSize == 0)
+    return estimate;
+
+  // The first round is allocated proportionally to the size of the strata.
+  long requests[STRATA_NUMBER];
+  for (int stratum = 0; stratum < STRATA_NUMBER; ++stratum) {
+    long size = states[stratum].size;
+    long proportional = std::ceil(static_cast<double>(INITIAL_SAMPLE) * size /
+                                  populationSize);
+    requests[stratum] =
+        std::min(size, std::max(MIN_STRATUM_SAMPLE, proportional));
+  }
+
+  std::vector<SamplingUnit> units;
+  std::vector<Stratum> unitStrata;
+  std::vector<int> values;
+
+  while (true) {
+    // Draw the units of this round without replacement.
+    units.clear();
+    unitStrata.clear();
+    for (int stratum = 0; stratum < STRATA_NUMBER; ++stratum) {
+      StratumState &state = states[stratum];
+      for (long request = 0; request < requests[stratum]; ++request) {
+        std::uniform_int_distribution<long> distribution(state.sampled,
+                                                         state.size - 1);
+        long position = distribution(generator);
+        long unit = state.unitAt(position);
+        state.swapped[position] = state.unitAt(state.sampled);
+        state.swapped.erase(state.sampled);
+        ++state.sampled;
+
+        units.push_back(getUnit(static_cast<Stratum>(stratum), unit));
+        unitStrata.push_back(static_cast<Stratum>(stratum));
+      }
+    }
+
+    values.assign(units.size(), 0);
+    evaluator(units, values);
+
+    for (size_t index = 0; index < units.size(); ++index) {
+      StratumState &state = states[unitStrata[index]];
+      state.sum += values[index];
+      state.sumOfSquares += static_cast<double>(values[index]) * values[index];
+    }
+
+    // Stratified estimator of the total and of its variance, with finite
+    // population correction.
+    double total = 0;
+    double variance = 0;
+    long sampledUnits = 0;
+    bool exhausted = true;
+    for (auto &state : states) {
+      if (state.sampled == 0)
+        continue;
+      double size = state.size;
+      double sampled = state.sampled;
+      total += size * state.sum / sampled;
+      variance += size * size * (1 - sampled / size) * state.getVariance() /
+                  sampled;
+      sampledUnits += state.sampled;
+      exhausted &= state.sampled == state.size;
+    }
+
+    estimate.total = total;
+    estimate.halfWidth = CONFIDENCE_Z * std::sqrt(variance);
+    estimate.sampledUnits = sampledUnits;
+
+    if (exhausted || estimate.halfWidth <= relativeError * std::fabs(total))
+      return estimate;
+
+    // Double the sample, allocating the new units to the strata in proportion
+    // to size * standard deviation (Neyman allocation).
+    double weights[STRATA_NUMBER];
+    double weightSum = 0;
+    for (int stratum = 0; stratum < STRATA_NUMBER; ++stratum) {
+      const StratumState &state = states[stratum];
+      weights[stratum] = state.size * std::sqrt(state.getVariance());
+      weightSum += weights[stratum];
+    }
+
+    long requested = 0;
+    for (int stratum = 0; stratum < STRATA_NUMBER; ++stratum) {
+      const StratumState &state = states[stratum];
+      long share = std::ceil(sampledUnits * weights[stratum] / weightSum);
+      requests[stratum] = std::min(state.size - state.sampled, share);
+      requested += requests[stratum];
+    }
+
+    // Always make progress.
+    if (requested == 0)
+      for (int stratum = 0; stratum < STRATA_NUMBER; ++stratum)
+        requests[stratum] = std::min(
+            states[stratum].size - states[stratum].sampled, sampledUnits);
+  }
+}
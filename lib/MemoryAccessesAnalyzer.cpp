@@ -2,10 +2,15 @@
 
 #include "SymEngine/HardwareConfig.h"
 #include "SymEngine/OCLEnv.h"
+#include "SymEngine/WarpEvaluator.h"
 
 #include "llvm/Analysis/ScalarEvolution.h"
 #include "llvm/Analysis/ScalarEvolutionExpressions.h"
 
+#include "llvm/Support/MathExtras.h"
+
+#include <limits>
+
 using namespace llvm;
 using namespace SymEngine;
 
@@ -104,50 +109,99 @@ std::vector<int> getRelativeAddresses(const std::vector<const SCEV *> &scevs,
 //------------------------------------------------------------------------------
 int SymEngine::computeBankConflictNumberImpl(std::vector<int> indices,
                                   const HardwareConfig &hwConfig) {
+  std::vector<int64_t> addresses(indices.begin(), indices.end());
+  return computeBankConflictNumberImpl(addresses.data(), addresses.size(),
+                                       hwConfig);
+}
 
-  std::vector<int> rows;
-  std::vector<int> columns;
-
-  rows.reserve(indices.size());
-  columns.reserve(indices.size());
-
-  const int banksNumber = hwConfig.banksNumber; 
-
-  std::transform(indices.begin(), indices.end(), std::back_inserter(columns),
-                 [banksNumber](int index) { return index % banksNumber; });
+//------------------------------------------------------------------------------
+int SymEngine::computeBankConflictNumberImpl(const int64_t *addresses,
+                                             int addressNumber,
+                                             const HardwareConfig &hwConfig) {
+  assert(addressNumber <= LaneCoordinates::MAX_LANE_NUMBER &&
+         "Too many addresses");
+  if (addressNumber == 0)
+    return 0;
+
+  const int banksNumber = hwConfig.banksNumber;
   const int LOCAL_MEMORY_WIDTH = hwConfig.banksNumber * hwConfig.bankWidth;
-  std::transform(
-      indices.begin(), indices.end(), std::back_inserter(rows),
-      [LOCAL_MEMORY_WIDTH](int x) { return x / LOCAL_MEMORY_WIDTH; });
-
-  assert(rows.size() == columns.size() && "Rows and Columns don't match");
 
-  std::map<int, std::vector<int>> localMemory;
-
-  for (int index = 0; index < hwConfig.warpSize; ++index) {
-    int row = rows[index];
-    int column = columns[index];
-
-    localMemory[column].push_back(row);
+  // Negative addresses give negative columns: shift them to get an index.
+  int columns[LaneCoordinates::MAX_LANE_NUMBER];
+  int64_t rows[LaneCoordinates::MAX_LANE_NUMBER];
+  int64_t minRow = std::numeric_limits<int64_t>::max();
+  int64_t maxRow = std::numeric_limits<int64_t>::min();
+  for (int index = 0; index < addressNumber; ++index) {
+    rows[index] = addresses[index] / LOCAL_MEMORY_WIDTH;
+    columns[index] = addresses[index] % banksNumber + banksNumber - 1;
+    minRow = std::min(minRow, rows[index]);
+    maxRow = std::max(maxRow, rows[index]);
   }
 
   int conflictNumber = 0;
 
-  for (auto &iter : localMemory) {
-    auto &currentRows = iter.second;
-    std::sort(currentRows.begin(), currentRows.end());
-
-    auto uniqueEnd = std::unique(currentRows.begin(), currentRows.end());
-
-    int uniqueRows = std::distance(currentRows.begin(), uniqueEnd);
-    --uniqueRows;
+  // Usual case: the rows of each bank fit in a 64-bit set.
+  if (banksNumber <= MAX_BANKS_NUMBER && maxRow - minRow < 64) {
+    uint64_t columnRows[2 * MAX_BANKS_NUMBER - 1];
+    for (int index = 0; index < addressNumber; ++index)
+      columnRows[columns[index]] = 0;
+    for (int index = 0; index < addressNumber; ++index)
+      columnRows[columns[index]] |= static_cast<uint64_t>(1)
+                                    << (rows[index] - minRow);
+    for (int index = 0; index < addressNumber; ++index) {
+      int uniqueRows = countPopulation(columnRows[columns[index]]) - 1;
+      conflictNumber = std::max(conflictNumber, uniqueRows);
+    }
+    return conflictNumber;
+  }
 
+  // Rows far apart: sort the (column, row) pairs and count the distinct rows
+  // of each column.
+  std::pair<int, int64_t> accesses[LaneCoordinates::MAX_LANE_NUMBER];
+  for (int index = 0; index < addressNumber; ++index)
+    accesses[index] = std::make_pair(columns[index], rows[index]);
+  std::sort(accesses, accesses + addressNumber);
+
+  int uniqueRows = 0;
+  for (int index = 0; index < addressNumber; ++index) {
+    if (index == 0 || accesses[index].first != accesses[index - 1].first)
+      uniqueRows = 0;
+    else if (accesses[index].second != accesses[index - 1].second)
+      ++uniqueRows;
     conflictNumber = std::max(conflictNumber, uniqueRows);
   }
 
   return conflictNumber;
 }
 
+//------------------------------------------------------------------------------
+// Copy the addresses of the lanes in activeMask to compacted and return their
+// number.
+static int compactAddresses(const int64_t *addresses, uint64_t activeMask,
+                            int laneNumber, int64_t *compacted) {
+  int addressNumber = 0;
+  for (int lane = 0; lane < laneNumber; ++lane)
+    if ((activeMask >> lane) & 1)
+      compacted[addressNumber++] = addresses[lane];
+  return addressNumber;
+}
+
+//------------------------------------------------------------------------------
+void SymEngine::computeBankConflictNumbers(const int64_t *addresses,
+                                           const uint64_t *activeMasks,
+                                           int laneNumber, int warpNumber,
+                                           const HardwareConfig &hwConfig,
+                                           int *results) {
+  int64_t compacted[LaneCoordinates::MAX_LANE_NUMBER];
+  for (int warp = 0; warp < warpNumber; ++warp) {
+    int addressNumber =
+        compactAddresses(addresses + warp * laneNumber, activeMasks[warp],
+                         laneNumber, compacted);
+    results[warp] =
+        computeBankConflictNumberImpl(compacted, addressNumber, hwConfig);
+  }
+}
+
 //------------------------------------------------------------------------------
 int SymEngine::computeBankConflictNumber(const std::vector<const SCEV *> &scevs,
                               const HardwareConfig &hwConfig,
@@ -159,18 +213,82 @@ int SymEngine::computeBankConflictNumber(const std::vector<const SCEV *> &scevs,
 //------------------------------------------------------------------------------
 int SymEngine::computeTransactionNumberImpl(std::vector<int> indices,
                                  const HardwareConfig &hwConfig) {
-  int cacheLineSize = hwConfig.cacheLineSize;
+  std::vector<int64_t> addresses(indices.begin(), indices.end());
+  return computeTransactionNumberImpl(addresses.data(), addresses.size(),
+                                      hwConfig);
+}
+
+//------------------------------------------------------------------------------
+int SymEngine::computeTransactionNumberImpl(const int64_t *addresses,
+                                            int addressNumber,
+                                            const HardwareConfig &hwConfig) {
+  assert(addressNumber <= LaneCoordinates::MAX_LANE_NUMBER &&
+         "Too many addresses");
+  if (addressNumber == 0)
+    return 0;
+
+  int64_t cacheLines[LaneCoordinates::MAX_LANE_NUMBER];
+  int64_t cacheLineSize = hwConfig.cacheLineSize;
+  int64_t minLine = std::numeric_limits<int64_t>::max();
+  int64_t maxLine = std::numeric_limits<int64_t>::min();
+  for (int index = 0; index < addressNumber; ++index) {
+    cacheLines[index] = addresses[index] / cacheLineSize;
+    minLine = std::min(minLine, cacheLines[index]);
+    maxLine = std::max(maxLine, cacheLines[index]);
+  }
 
-  std::transform(indices.begin(), indices.end(), indices.begin(),
-                 [cacheLineSize](int x) { return x / cacheLineSize; });
+  // Usual case: the cache lines fit in a small bitset.
+  const int LINE_SET_WORDS = 4;
+  if (maxLine - minLine < 64 * LINE_SET_WORDS) {
+    uint64_t lineSet[LINE_SET_WORDS] = {0, 0, 0, 0};
+    for (int index = 0; index < addressNumber; ++index) {
+      int64_t offset = cacheLines[index] - minLine;
+      lineSet[offset / 64] |= static_cast<uint64_t>(1) << (offset % 64);
+    }
+    int uniqueCacheLines = 0;
+    for (uint64_t word : lineSet)
+      uniqueCacheLines += countPopulation(word);
+    return uniqueCacheLines;
+  }
 
-  std::sort(indices.begin(), indices.end());
-  auto uniqueEnd = std::unique(indices.begin(), indices.end());
-  int uniqueCacheLines = std::distance(indices.begin(), uniqueEnd);
+  // Scattered lines: insert them in an open-addressing table with twice the
+  // slots of the addresses.
+  const int TABLE_SIZE = 2 * LaneCoordinates::MAX_LANE_NUMBER;
+  int64_t table[TABLE_SIZE];
+  bool used[TABLE_SIZE] = {};
+  int uniqueCacheLines = 0;
+  for (int index = 0; index < addressNumber; ++index) {
+    uint64_t hash = static_cast<uint64_t>(cacheLines[index]) *
+                    0x9e3779b97f4a7c15ull;
+    int slot = hash >> (64 - 7);
+    while (used[slot] && table[slot] != cacheLines[index])
+      slot = (slot + 1) % TABLE_SIZE;
+    if (!used[slot]) {
+      used[slot] = true;
+      table[slot] = cacheLines[index];
+      ++uniqueCacheLines;
+    }
+  }
 
   return uniqueCacheLines;
 }
 
+//------------------------------------------------------------------------------
+void SymEngine::computeTransactionNumbers(const int64_t *addresses,
+                                          const uint64_t *activeMasks,
+                                          int laneNumber, int warpNumber,
+                                          const HardwareConfig &hwConfig,
+                                          int *results) {
+  int64_t compacted[LaneCoordinates::MAX_LANE_NUMBER];
+  for (int warp = 0; warp < warpNumber; ++warp) {
+    int addressNumber =
+        compactAddresses(addresses + warp * laneNumber, activeMasks[warp],
+                         laneNumber, compacted);
+    results[warp] =
+        computeTransactionNumberImpl(compacted, addressNumber, hwConfig);
+  }
+}
+
 //------------------------------------------------------------------------------
 int SymEngine::computeTransactionNumber(const std::vector<const SCEV *> &scevs,
                              const HardwareConfig &hwConfig,
@@ -178,3 +296,137 @@ int SymEngine::computeTransactionNumber(const std::vector<const SCEV *> &scevs,
   auto indices = getRelativeAddresses(scevs, hwConfig, scalarEvolution);
   return SymEngine::computeTransactionNumberImpl(indices, hwConfig);
 }
+
+//------------------------------------------------------------------------------
+// Write in addresses base + stride * lane for the lanes in activeMask and
+// return their number.
+static int expandStrided(int64_t base, int64_t stride, int laneNumber,
+                         uint64_t activeMask, int64_t *addresses) {
+  int addressNumber = 0;
+  for (int lane = 0; lane < laneNumber; ++lane)
+    if ((activeMask >> lane) & 1)
+      addresses[addressNumber++] = base + stride * lane;
+  return addressNumber;
+}
+
+//------------------------------------------------------------------------------
+// Describe the addresses of the active lanes as the progression
+// first, first + step, ..., with count elements, step >= 0 and first >= 0.
+// Returns false if the active lanes are not contiguous or some address is
+// negative.
+static bool getProgression(int64_t base, int64_t stride, int laneNumber,
+                           uint64_t activeMask, int64_t &first, int64_t &step,
+                           int &count) {
+  if (laneNumber < LaneCoordinates::MAX_LANE_NUMBER)
+    activeMask &= (static_cast<uint64_t>(1) << laneNumber) - 1;
+
+  count = countPopulation(activeMask);
+  if (count == 0)
+    return true;
+
+  int firstLane = countTrailingZeros(activeMask);
+  uint64_t lanes = activeMask >> firstLane;
+  if ((lanes & (lanes + 1)) != 0)
+    return false;
+
+  first = base + stride * firstLane;
+  step = stride;
+  if (step < 0) {
+    first += step * (count - 1);
+    step = -step;
+  }
+  return first >= 0;
+}
+
+//------------------------------------------------------------------------------
+// Number of distinct values of x / blockSize for x in the progression
+// first, first + step, ..., with count elements, first >= 0 and step >= 0.
+static int64_t countDistinctBlocks(int64_t first, int64_t step, int64_t count,
+                                   int64_t blockSize) {
+  if (count == 0)
+    return 0;
+  if (step == 0)
+    return 1;
+  // Every element falls in a different block.
+  if (step >= blockSize)
+    return count;
+  // Consecutive elements are in the same or in adjacent blocks.
+  int64_t last = first + step * (count - 1);
+  return last / blockSize - first / blockSize + 1;
+}
+
+//------------------------------------------------------------------------------
+int64_t SymEngine::greatestCommonDivisor(int64_t first, int64_t second) {
+  while (second != 0) {
+    int64_t remainder = first % second;
+    first = second;
+    second = remainder;
+  }
+  return first;
+}
+
+//------------------------------------------------------------------------------
+int SymEngine::computeStridedTransactionNumber(int64_t base, int64_t stride,
+                                               int laneNumber,
+                                               uint64_t activeMask,
+                                               const HardwareConfig &hwConfig) {
+  int64_t first = 0;
+  int64_t step = 0;
+  int count = 0;
+  if (!getProgression(base, stride, laneNumber, activeMask, first, step,
+                      count)) {
+    int64_t addresses[LaneCoordinates::MAX_LANE_NUMBER];
+    int addressNumber =
+        expandStrided(base, stride, laneNumber, activeMask, addresses);
+    return computeTransactionNumberImpl(addresses, addressNumber, hwConfig);
+  }
+
+  return countDistinctBlocks(first, step, count, hwConfig.cacheLineSize);
+}
+
+//------------------------------------------------------------------------------
+int SymEngine::computeStridedBankConflictNumber(int64_t base, int64_t stride,
+                                                int laneNumber,
+                                                uint64_t activeMask,
+                                                const HardwareConfig &hwConfig) {
+  int64_t first = 0;
+  int64_t step = 0;
+  int count = 0;
+  if (!getProgression(base, stride, laneNumber, activeMask, first, step,
+                      count)) {
+    int64_t addresses[LaneCoordinates::MAX_LANE_NUMBER];
+    int addressNumber =
+        expandStrided(base, stride, laneNumber, activeMask, addresses);
+    return computeBankConflictNumberImpl(addresses, addressNumber, hwConfig);
+  }
+
+  const int64_t banksNumber = hwConfig.banksNumber;
+  const int64_t LOCAL_MEMORY_WIDTH = hwConfig.banksNumber * hwConfig.bankWidth;
+
+  // The bank of the element of index i is (first + step * i) % banksNumber,
+  // which has period banksNumber / gcd(step, banksNumber) in i. Each residue
+  // class of i modulo the period is a progression hitting a single bank.
+  int64_t period = banksNumber / greatestCommonDivisor(step % banksNumber,
+                                                       banksNumber);
+  int64_t classNumber = std::min<int64_t>(period, count);
+
+  int64_t conflictNumber = 0;
+  for (int64_t residue = 0; residue < classNumber; ++residue) {
+    int64_t classCount = (count - residue + period - 1) / period;
+    int64_t rows = countDistinctBlocks(first + step * residue, step * period,
+                                       classCount, LOCAL_MEMORY_WIDTH);
+    conflictNumber = std::max(conflictNumber, rows - 1);
+  }
+
+  return conflictNumber;
+}
+
+//------------------------------------------------------------------------------
+int64_t SymEngine::getTranslationPeriod(const HardwareConfig &hwConfig) {
+  // Columns are addresses modulo banksNumber, rows are addresses divided by
+  // banksNumber * bankWidth.
+  int64_t rowWidth = hwConfig.banksNumber * hwConfig.bankWidth;
+  int64_t cacheLineSize = hwConfig.cacheLineSize;
+  return rowWidth / greatestCommonDivisor(rowWidth, cacheLineSize) *
+         cacheLineSize;
+}
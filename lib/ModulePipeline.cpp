@@ -0,0 +1,92 @@
+#include "SymEngine/ModulePipeline.h"
+
+#include "SymEngine/SymbolicExecution.h"
+
+#include "llvm/InitializePasses.h"
+#include "llvm/PassRegistry.h"
+
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/LegacyPassManager.h"
+#include "llvm/IR/Module.h"
+
+#include "llvm/IRReader/IRReader.h"
+
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "llvm/Transforms/IPO.h"
+#include "llvm/Transforms/Scalar.h"
+
+#include <mutex>
+
+using namespace llvm;
+using namespace SymEngine;
+
+//------------------------------------------------------------------------------
+void SymEngine::initializePipeline() {
+  // The analyses required by SymbolicExecution are scheduled by the pass
+  // manager: they must be registered.
+  static std::once_flag initialization;
+  std::call_once(initialization, []() {
+    PassRegistry &registry = *PassRegistry::getPassRegistry();
+    initializeCore(registry);
+    initializeAnalysis(registry);
+    initializeIPA(registry);
+    initializeScalarOpts(registry);
+    initializeIPO(registry);
+    initializeTransformUtils(registry);
+  });
+}
+
+//------------------------------------------------------------------------------
+static std::string getErrorMessage(const SMDiagnostic &diagnostic) {
+  std::string message;
+  raw_string_ostream stream(message);
+  diagnostic.print("symengine", stream, false);
+  return stream.str();
+}
+
+//------------------------------------------------------------------------------
+std::unique_ptr<Module> SymEngine::loadModule(const std::string &fileName,
+                                              LLVMContext &context,
+                                              std::string &error) {
+  SMDiagnostic diagnostic;
+  std::unique_ptr<Module> module = parseIRFile(fileName, diagnostic, context);
+  if (!module)
+    error = getErrorMessage(diagnostic);
+  return module;
+}
+
+//------------------------------------------------------------------------------
+std::unique_ptr<Module> SymEngine::parseModule(const std::string &text,
+                                               LLVMContext &context,
+                                               std::string &error) {
+  SMDiagnostic diagnostic;
+  std::unique_ptr<MemoryBuffer> buffer =
+      MemoryBuffer::getMemBuffer(text, "<request>", false);
+  std::unique_ptr<Module> module =
+      parseIR(buffer->getMemBufferRef(), diagnostic, context);
+  if (!module)
+    error = getErrorMessage(diagnostic);
+  return module;
+}
+
+//------------------------------------------------------------------------------
+void SymEngine::runPipeline(Module &module, Pass *pass,
+                            unsigned int inlineThreshold) {
+  legacy::PassManager passManager;
+  passManager.add(createPromoteMemoryToRegisterPass());
+  passManager.add(createFunctionInliningPass(inlineThreshold));
+  passManager.add(createInstructionNamerPass());
+  passManager.add(pass);
+  passManager.run(module);
+}
+
+//------------------------------------------------------------------------------
+std::vector<KernelFormulas>
+SymEngine::compileModuleFormulas(Module &module, unsigned int inlineThreshold) {
+  ModuleResults results;
+  runPipeline(module, new SymbolicExecution(&results), inlineThreshold);
+  return results.formulas;
+}
@@ -5,21 +5,17 @@
 
 using namespace SymEngine;
 
-NDRangePoint::NDRangePoint() {
-  local.assign(3, 0);
-  group.assign(3, 0);
-  global.assign(3, 0);
-}
+NDRangePoint::NDRangePoint()
+    : local{{0, 0, 0}}, global{{0, 0, 0}}, group{{0, 0, 0}} {}
 
 NDRangePoint::NDRangePoint(int localX, int localY, int localZ, int groupX,
                            int groupY, int groupZ,
-                           const NDRangeSpace *ndRangeSpace) {
-  local = {localX, localY, localZ};
-  group = {groupX, groupY, groupZ};
-  global = {localX + groupX * ndRangeSpace->getLocalSizeX(),
-            localY + groupY * ndRangeSpace->getLocalSizeY(),
-            localZ + groupZ * ndRangeSpace->getLocalSizeZ()};
-}
+                           const NDRangeSpace *ndRangeSpace)
+    : local{{localX, localY, localZ}},
+      global{{localX + groupX * ndRangeSpace->getLocalSizeX(),
+              localY + groupY * ndRangeSpace->getLocalSizeY(),
+              localZ + groupZ * ndRangeSpace->getLocalSizeZ()}},
+      group{{groupX, groupY, groupZ}} {}
 
 int NDRangePoint::getLocalX() const { return local[0]; }
 int NDRangePoint::getLocalY() const { return local[1]; }
@@ -31,6 +31,10 @@ int NDRangeSpace::getGroupSize() const {
   return localSize[0] * localSize[1] * localSize[2];
 }
 
+int NDRangeSpace::getTotalNumberOfGroups() const {
+  return numberOfGroups[0] * numberOfGroups[1] * numberOfGroups[2];
+}
+
 int NDRangeSpace::getLocalSize(int direction) const {
   return localSize[direction];
 }
@@ -0,0 +1,157 @@
+#include "SymEngine/NDRangeSweep.h"
+
+#include "SymEngine/ThreadPool.h"
+
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <algorithm>
+#include <tuple>
+
+using namespace llvm;
+using namespace SymEngine;
+
+//------------------------------------------------------------------------------
+std::vector<int> SweepDimension::getValues() const {
+  if (!values.empty())
+    return values;
+  // Neither a list nor a range: the direction is not swept.
+  if (max <= 0)
+    return std::vector<int>(1, 1);
+  std::vector<int> result;
+  for (int64_t value = std::max(min, 1); value <= max; value *= 2)
+    result.push_back(value);
+  return result;
+}
+
+//------------------------------------------------------------------------------
+std::vector<SweepCandidate>
+SymEngine::createSweepCandidates(const SweepConfig &config) {
+  std::vector<int> localSizes[3];
+  std::vector<int> groupNumbers[3];
+  for (int direction = 0; direction < 3; ++direction) {
+    localSizes[direction] = config.localSize[direction].getValues();
+    groupNumbers[direction] = config.numberOfGroups[direction].getValues();
+  }
+  bool fixedGlobalSize = config.globalSize.size() == 3;
+
+  std::vector<SweepCandidate> candidates;
+  for (int localZ : localSizes[2])
+    for (int localY : localSizes[1])
+      for (int localX : localSizes[0]) {
+        int local[] = {localX, localY, localZ};
+        if (config.maxGroupSize > 0 &&
+            int64_t(localX) * localY * localZ > config.maxGroupSize)
+          continue;
+
+        if (fixedGlobalSize) {
+          int groups[3];
+          bool divides = true;
+          for (int direction = 0; direction < 3; ++direction) {
+            divides &= local[direction] > 0 &&
+                       config.globalSize[direction] % local[direction] == 0;
+            groups[direction] =
+                divides ? config.globalSize[direction] / local[direction] : 0;
+          }
+          if (divides && groups[0] > 0 && groups[1] > 0 && groups[2] > 0)
+            candidates.push_back({NDRangeSpace(localX, localY, localZ,
+                                               groups[0], groups[1], groups[2]),
+                                  KernelResults(), 0, 0, 0});
+          continue;
+        }
+
+        for (int groupsZ : groupNumbers[2])
+          for (int groupsY : groupNumbers[1])
+            for (int groupsX : groupNumbers[0])
+              candidates.push_back({NDRangeSpace(localX, localY, localZ,
+                                                 groupsX, groupsY, groupsZ),
+                                    KernelResults(), 0, 0, 0});
+      }
+  return candidates;
+}
+
+//------------------------------------------------------------------------------
+static int64_t sumCounts(const std::vector<int> &counts,
+                         int &unknownAccesses) {
+  int64_t sum = 0;
+  for (int count : counts) {
+    if (count < 0)
+      ++unknownAccesses;
+    else
+      sum += count;
+  }
+  return sum;
+}
+
+//------------------------------------------------------------------------------
+void SymEngine::evaluateSweep(const KernelFormulas &kernel,
+                              const std::vector<int64_t> &arguments,
+                              const HardwareConfig &hwConfig,
+                              ThreadPool &threadPool,
+                              std::vector<SweepCandidate> &candidates) {
+  // The simulation works on whole warps.
+  auto partialWarps = [&](const SweepCandidate &candidate) {
+    return candidate.ndrSpace.getGroupSize() % hwConfig.warpSize != 0;
+  };
+  candidates.erase(
+      std::remove_if(candidates.begin(), candidates.end(), partialWarps),
+      candidates.end());
+
+  // The simulation of each candidate is itself parallel: small NDRanges do
+  // not leave threads idle while the large ones run.
+  threadPool.parallelFor(candidates.size(), [&](size_t index) {
+    SweepCandidate &candidate = candidates[index];
+    candidate.results = evaluateKernelFormulas(
+        kernel, arguments, &candidate.ndrSpace, hwConfig, threadPool);
+    candidate.unknownAccesses = 0;
+    candidate.transactions =
+        sumCounts(candidate.results.loadTransactions,
+                  candidate.unknownAccesses) +
+        sumCounts(candidate.results.storeTransactions,
+                  candidate.unknownAccesses);
+    candidate.bankConflicts =
+        sumCounts(candidate.results.loadBankConflicts,
+                  candidate.unknownAccesses) +
+        sumCounts(candidate.results.storeBankConflicts,
+                  candidate.unknownAccesses);
+  });
+
+  // Equivalent candidates keep the order of the file.
+  std::stable_sort(candidates.begin(), candidates.end(),
+                   [](const SweepCandidate &first,
+                      const SweepCandidate &second) {
+    return std::make_tuple(first.unknownAccesses > 0, first.transactions,
+                           first.bankConflicts) <
+           std::make_tuple(second.unknownAccesses > 0, second.transactions,
+                           second.bankConflicts);
+  });
+}
+
+//------------------------------------------------------------------------------
+static std::string formatSizes(int x, int y, int z) {
+  return std::to_string(x) + "x" + std::to_string(y) + "x" + std::to_string(z);
+}
+
+//------------------------------------------------------------------------------
+void SymEngine::printSweepTable(const std::string &kernelName,
+                                const std::vector<SweepCandidate> &candidates,
+                                raw_ostream &out) {
+  out << "Kernel " << kernelName << ": " << candidates.size()
+      << " configurations\n";
+  out << "rank  local size      groups            "
+         "    transactions  bank conflicts   unknown\n";
+  int rank = 1;
+  for (const SweepCandidate &candidate : candidates) {
+    const NDRangeSpace &space = candidate.ndrSpace;
+    std::string local = formatSizes(space.getLocalSizeX(),
+                                    space.getLocalSizeY(),
+                                    space.getLocalSizeZ());
+    std::string groups = formatSizes(space.getNumberOfGroupsX(),
+                                     space.getNumberOfGroupsY(),
+                                     space.getNumberOfGroupsZ());
+    out << format("%-6d%-16s%-18s%16lld%16lld%10d\n", rank++, local.c_str(),
+                  groups.c_str(), (long long)candidate.transactions,
+                  (long long)candidate.bankConflicts,
+                  candidate.unknownAccesses);
+  }
+}
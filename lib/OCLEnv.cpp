@@ -1,15 +1,18 @@
 #include "SymEngine/OCLEnv.h"
 
+#include "SymEngine/GroupSampler.h"
 #include "SymEngine/NDRange.h"
 #include "SymEngine/NDRangeSpace.h"
 #include "SymEngine/Utils.h"
 #include "SymEngine/YAMLReader.h"
 #include "SymEngine/Warp.h"
+#include "SymEngine/WarpEvaluator.h"
 
 #include "llvm/IR/Function.h"
 #include "llvm/IR/Type.h"
 
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/raw_ostream.h"
 
 #include <algorithm>
 
@@ -37,6 +40,32 @@ cl::opt<bool> fullSimulation("full-simulation", cl::init(false),
                               cl::Hidden,
                               cl::desc("Enable simulation of all warps"));
 
+cl::opt<bool>
+    simulateNDRange("simulate-ndrange", cl::init(false), cl::Hidden,
+                    cl::desc("Enable simulation of all the work groups"));
+
+cl::opt<bool> sampleNDRange(
+    "sample-ndrange", cl::init(false), cl::Hidden,
+    cl::desc("Estimate the NDRange totals by sampling groups and warps"));
+
+cl::opt<double> samplingRelativeError(
+    "sampling-relative-error", cl::init(0.05), cl::Hidden,
+    cl::desc("Relative half width of the 95% confidence interval at which "
+             "sampling stops"));
+
+cl::opt<unsigned int>
+    samplingSeed("sampling-seed", cl::init(0), cl::Hidden,
+                 cl::desc("Seed of the random generator used for sampling"));
+
+cl::opt<unsigned int> symbolicThreads(
+    "symbolic-threads", cl::init(0), cl::Hidden,
+    cl::desc("Number of threads used for the simulation (0: all cores)"));
+
+cl::opt<bool> leaveArgumentsSymbolic(
+    "symbolic-kernel-arguments", cl::init(false), cl::Hidden,
+    cl::desc("Leave the integer kernel arguments symbolic and dump the access "
+             "formulas instead of the counts"));
+
 // -----------------------------------------------------------------------------
 const std::string OCLEnv::KERNEL_ARGUMENTS_FILE_NAME = "kernel_arg_config.yaml";
 const std::string OCLEnv::HARDWARE_CONFIG_FILE_NAME = "hardware_config.yaml";
@@ -45,7 +74,30 @@ const int OCLEnv::UNKNOWN_MEMORY_LOCATION = -1;
 const unsigned int OCLEnv::LOCAL_AS = 3;
 
 // -----------------------------------------------------------------------------
-OCLEnv::OCLEnv(Function &function, const NDRange *ndRange) : ndRange(ndRange) {
+// The config files are read once per process, so that all the kernels of a
+// module analyzed in the same run share them.
+static const HardwareConfig &getHardwareConfig() {
+  static const HardwareConfig hwConfig =
+      readHardwareConfig(OCLEnv::HARDWARE_CONFIG_FILE_NAME);
+  return hwConfig;
+}
+
+static const KernelArgumentsVector &getKernelArguments() {
+  static const KernelArgumentsVector kernelArgs =
+      readKernelArguments(OCLEnv::KERNEL_ARGUMENTS_FILE_NAME);
+  return kernelArgs;
+}
+
+static const OpenCLConfig &getOpenCLConfig() {
+  static const OpenCLConfig openclConfig =
+      readOpenCLConfig(OCLEnv::OPENCL_CONFIG_FILE_NAME);
+  return openclConfig;
+}
+
+// -----------------------------------------------------------------------------
+OCLEnv::OCLEnv(Function &function, const NDRange *ndRange)
+    : ndRange(ndRange), ndRangeSimulation(false), ndRangeSampling(false),
+      threadNumber(1), symbolicArguments(leaveArgumentsSymbolic) {
   setupHWConfig();
   setupKernelArgs(function);
   setupOpenCLConfig();
@@ -54,29 +106,45 @@ OCLEnv::OCLEnv(Function &function, const NDRange *ndRange) : ndRange(ndRange) {
 // -----------------------------------------------------------------------------
 OCLEnv::OCLEnv(Function &function, const NDRange *ndRange,
                HardwareConfig hwConfig)
-    : ndRange(ndRange), hwConfig(hwConfig) {
+    : ndRange(ndRange), ndRangeSimulation(false), ndRangeSampling(false),
+      threadNumber(1), symbolicArguments(leaveArgumentsSymbolic),
+      hwConfig(hwConfig) {
   setupKernelArgs(function);
   setupOpenCLConfig();
 }
 
 // -----------------------------------------------------------------------------
-OCLEnv::OCLEnv(OCLEnv &&oclEnv) {
-  std::swap(this->ndRange, oclEnv.ndRange);
-  std::swap(this->warps, oclEnv.warps);
-  std::swap(this->ndRangeSpace, oclEnv.ndRangeSpace);
-  std::swap(this->argumentMap, oclEnv.argumentMap);
-  std::swap(this->hwConfig, oclEnv.hwConfig);
+OCLEnv::OCLEnv(Function &function, const NDRange *ndRange,
+               const NDRangeSpace &ndrSpace, HardwareConfig hwConfig)
+    : ndRange(ndRange),
+      ndRangeSpace(std::make_shared<const NDRangeSpace>(ndrSpace)),
+      ndRangeSimulation(true), ndRangeSampling(false), threadNumber(1),
+      symbolicArguments(true), hwConfig(hwConfig) {
+  setupKernelArgs(function);
 }
 
 // -----------------------------------------------------------------------------
 void OCLEnv::setupHWConfig() {
-  hwConfig = readHardwareConfig(HARDWARE_CONFIG_FILE_NAME);
+  hwConfig = getHardwareConfig();
 }
 
 // -----------------------------------------------------------------------------
 void OCLEnv::setupKernelArgs(Function &function) {
-  KernelArgumentsVector kernelArgs =
-      readKernelArguments(KERNEL_ARGUMENTS_FILE_NAME);
+  // Symbolic arguments are numbered in the order of the values of the
+  // arguments file.
+  if (symbolicArguments) {
+    int argCounter = 0;
+    for (Function::arg_iterator iter = function.arg_begin(),
+                                iterEnd = function.arg_end();
+         iter != iterEnd; ++iter) {
+      llvm::Value *argument = iter;
+      if (argument->getType()->isIntegerTy())
+        argumentMap.insert(std::make_pair(argument, argCounter++));
+    }
+    return;
+  }
+
+  const KernelArgumentsVector &kernelArgs = getKernelArguments();
 
   std::string kernelName = function.getName();
 
@@ -108,7 +176,7 @@ void OCLEnv::setupKernelArgs(Function &function) {
 
 // -----------------------------------------------------------------------------
 void OCLEnv::setupOpenCLConfig() {
-  OpenCLConfig openclConfig = readOpenCLConfig(OPENCL_CONFIG_FILE_NAME);
+  const OpenCLConfig &openclConfig = getOpenCLConfig();
 
   // If the user does not specify a size paramter, then use the default from the
   // configuration file.
@@ -126,9 +194,24 @@ void OCLEnv::setupOpenCLConfig() {
   if (numberOfGroupsZ == 0)
     numberOfGroupsZ = openclConfig.ndRange.numberOfGroups[2];
 
-  ndRangeSpace = std::unique_ptr<NDRangeSpace>(
-      new NDRangeSpace(localSizeX, localSizeY, localSizeZ, numberOfGroupsX,
-                       numberOfGroupsY, numberOfGroupsZ));
+  ndRangeSpace = std::make_shared<const NDRangeSpace>(
+      localSizeX, localSizeY, localSizeZ, numberOfGroupsX, numberOfGroupsY,
+      numberOfGroupsZ);
+
+  if (hwConfig.warpSize > LaneCoordinates::MAX_LANE_NUMBER) {
+    errs() << "Warp size larger than " << LaneCoordinates::MAX_LANE_NUMBER
+           << " is not supported\n";
+    exit(1);
+  }
+
+  threadNumber = symbolicThreads;
+
+  // Warps are created on the fly when simulating or sampling the whole
+  // NDRange.
+  ndRangeSimulation = simulateNDRange;
+  ndRangeSampling = sampleNDRange;
+  if (ndRangeSimulation || ndRangeSampling)
+    return;
 
   WarpFactory warpFactory(ndRangeSpace.get(), hwConfig.warpSize);
   if (fullSimulation)
@@ -150,17 +233,70 @@ const NDRangeSpace *OCLEnv::getNDRangeSpace() const {
 }
 
 // -----------------------------------------------------------------------------
-const HardwareConfig OCLEnv::getHWConfig() const {
+const HardwareConfig &OCLEnv::getHWConfig() const {
   return hwConfig;
 }
 
 // -----------------------------------------------------------------------------
-std::vector<Warp> OCLEnv::getWarps() const {
+const std::vector<Warp> &OCLEnv::getWarps() const {
   return warps;
 }
 
+// -----------------------------------------------------------------------------
+WarpFactory OCLEnv::getWarpFactory() const {
+  return WarpFactory(ndRangeSpace.get(), hwConfig.warpSize);
+}
+
+// -----------------------------------------------------------------------------
+bool OCLEnv::isNDRangeSimulation() const { return ndRangeSimulation; }
+
+// -----------------------------------------------------------------------------
+bool OCLEnv::isNDRangeSampling() const { return ndRangeSampling; }
+
+// -----------------------------------------------------------------------------
+GroupSampler OCLEnv::getGroupSampler() const {
+  int warpsPerGroup = ndRangeSpace->getGroupSize() / hwConfig.warpSize;
+  return GroupSampler(ndRangeSpace.get(), warpsPerGroup, samplingRelativeError,
+                      samplingSeed);
+}
+
+// -----------------------------------------------------------------------------
+unsigned int OCLEnv::getThreadNumber() const { return threadNumber; }
+
+// -----------------------------------------------------------------------------
+std::string OCLEnv::getConfigurationKey() const {
+  std::string key;
+  raw_string_ostream stream(key);
+  stream << "ndrange";
+  for (int direction = 0; direction < 3; ++direction)
+    stream << " " << ndRangeSpace->getLocalSize(direction) << " "
+           << ndRangeSpace->getNumberOfGroups(direction);
+  stream << "\nhardware " << hwConfig.banksNumber << " " << hwConfig.bankWidth
+         << " " << hwConfig.warpSize << " " << hwConfig.cacheLineSize;
+  stream << "\nsimulation " << ndRangeSimulation << " " << ndRangeSampling;
+  if (ndRangeSampling)
+    stream << " " << samplingRelativeError << " " << samplingSeed;
+  stream << "\nwarps";
+  for (const Warp &warp : warps)
+    stream << " " << warp.getGroupX() << " " << warp.getGroupY() << " "
+           << warp.getGroupZ() << " " << warp.getWarpIndex();
+  stream << "\n";
+  return stream.str();
+}
+
+// -----------------------------------------------------------------------------
+bool OCLEnv::hasSymbolicArguments() const { return symbolicArguments; }
+
+// -----------------------------------------------------------------------------
+int OCLEnv::getArgumentIndex(llvm::Value *value) const {
+  assert(symbolicArguments && "Kernel arguments are not symbolic");
+  std::map<llvm::Value *, int>::const_iterator iter = argumentMap.find(value);
+  return iter == argumentMap.end() ? -1 : iter->second;
+}
+
 // -----------------------------------------------------------------------------
 int OCLEnv::resolveValue(llvm::Value *value) const {
+  assert(!symbolicArguments && "Kernel arguments are symbolic");
   std::map<llvm::Value *, int>::const_iterator iter = argumentMap.find(value);
   assert(iter != argumentMap.end() && "Argument is not in argument map!");
   return iter->second;
@@ -0,0 +1,191 @@
+#include "SymEngine/ResultCache.h"
+
+#include "llvm/ADT/SmallString.h"
+
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace llvm;
+using namespace SymEngine;
+
+const uint32_t ResultCache::FORMAT_VERSION = 1;
+
+static const char ENTRY_MAGIC[8] = {'S', 'Y', 'M', 'C', 'A', 'C', 'H', 'E'};
+static const char ENTRY_EXTENSION[] = ".symcache";
+
+// Followed by the counts, then by the errors of the accesses.
+struct EntryHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t accessNumber;
+  // Hash of the key, against collisions of the file names.
+  uint8_t digest[16];
+};
+
+//------------------------------------------------------------------------------
+static void hashKey(const std::string &key, uint8_t digest[16]) {
+  MD5 hash;
+  hash.update(key);
+  MD5::MD5Result result;
+  hash.final(result);
+  memcpy(digest, &result, 16);
+}
+
+//------------------------------------------------------------------------------
+ResultCache::ResultCache(const std::string &directory, uint64_t maxSize)
+    : directory(directory), maxSize(maxSize) {
+  if (std::error_code error = sys::fs::create_directories(directory))
+    errs() << "WARNING: cannot create the cache directory " << directory
+           << ": " << error.message() << "\n";
+}
+
+//------------------------------------------------------------------------------
+std::string ResultCache::getEntryPath(const std::string &key) const {
+  static const char hexDigits[] = "0123456789abcdef";
+  uint8_t digest[16];
+  hashKey(key, digest);
+  std::string name;
+  for (uint8_t byte : digest) {
+    name += hexDigits[byte >> 4];
+    name += hexDigits[byte & 15];
+  }
+  return directory + "/" + name + ENTRY_EXTENSION;
+}
+
+//------------------------------------------------------------------------------
+bool ResultCache::lookup(const std::string &key, size_t accessNumber,
+                         std::vector<int> &counts,
+                         std::vector<int> &errors) const {
+  int file = open(getEntryPath(key).c_str(), O_RDONLY);
+  if (file < 0)
+    return false;
+
+  size_t size = sizeof(EntryHeader) + 2 * accessNumber * sizeof(int32_t);
+  struct stat status;
+  if (fstat(file, &status) != 0 ||
+      static_cast<size_t>(status.st_size) != size) {
+    close(file);
+    return false;
+  }
+  void *data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+  if (data == MAP_FAILED) {
+    close(file);
+    return false;
+  }
+
+  const EntryHeader *header = static_cast<const EntryHeader *>(data);
+  uint8_t digest[16];
+  hashKey(key, digest);
+  bool valid = memcmp(header->magic, ENTRY_MAGIC, sizeof(ENTRY_MAGIC)) == 0 &&
+               header->version == FORMAT_VERSION &&
+               header->accessNumber == accessNumber &&
+               memcmp(header->digest, digest, sizeof(digest)) == 0;
+  if (valid) {
+    const int32_t *values = reinterpret_cast<const int32_t *>(header + 1);
+    counts.assign(values, values + accessNumber);
+    errors.assign(values + accessNumber, values + 2 * accessNumber);
+    // The entry is now the most recently used.
+    futimens(file, nullptr);
+  }
+
+  munmap(data, size);
+  close(file);
+  return valid;
+}
+
+//------------------------------------------------------------------------------
+void ResultCache::store(const std::string &key, const std::vector<int> &counts,
+                        const std::vector<int> &errors) const {
+  std::string path = getEntryPath(key);
+  int file = -1;
+  SmallString<128> temporaryPath;
+  if (std::error_code error = sys::fs::createUniqueFile(
+          path + "-%%%%%%%%.tmp", file, temporaryPath)) {
+    errs() << "WARNING: cannot write the cache entry " << path << ": "
+           << error.message() << "\n";
+    return;
+  }
+
+  EntryHeader header;
+  memcpy(header.magic, ENTRY_MAGIC, sizeof(ENTRY_MAGIC));
+  header.version = FORMAT_VERSION;
+  header.accessNumber = counts.size();
+  hashKey(key, header.digest);
+  std::vector<int32_t> values(counts.begin(), counts.end());
+  values.insert(values.end(), errors.begin(), errors.end());
+
+  bool written = false;
+  {
+    raw_fd_ostream stream(file, true);
+    stream.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    stream.write(reinterpret_cast<const char *>(values.data()),
+                 values.size() * sizeof(int32_t));
+    stream.close();
+    written = !stream.has_error();
+    stream.clear_error();
+  }
+
+  // Renaming is atomic: readers see either no entry or a complete one.
+  if (!written || sys::fs::rename(temporaryPath, path)) {
+    errs() << "WARNING: cannot write the cache entry " << path << "\n";
+    sys::fs::remove(temporaryPath);
+    return;
+  }
+
+  evict();
+}
+
+//------------------------------------------------------------------------------
+void ResultCache::evict() const {
+  struct Entry {
+    std::string path;
+    time_t lastUse;
+    uint64_t size;
+  };
+
+  DIR *entriesDirectory = opendir(directory.c_str());
+  if (entriesDirectory == nullptr)
+    return;
+  std::vector<Entry> entries;
+  uint64_t totalSize = 0;
+  const size_t extensionSize = sizeof(ENTRY_EXTENSION) - 1;
+  while (dirent *file = readdir(entriesDirectory)) {
+    std::string name = file->d_name;
+    if (name.size() <= extensionSize ||
+        name.compare(name.size() - extensionSize, extensionSize,
+                     ENTRY_EXTENSION) != 0)
+      continue;
+    std::string path = directory + "/" + name;
+    struct stat status;
+    if (stat(path.c_str(), &status) != 0)
+      continue;
+    entries.push_back({path, status.st_mtime, uint64_t(status.st_size)});
+    totalSize += status.st_size;
+  }
+  closedir(entriesDirectory);
+
+  if (totalSize <= maxSize)
+    return;
+  std::sort(entries.begin(), entries.end(),
+            [](const Entry &first, const Entry &second) {
+    return first.lastUse < second.lastUse;
+  });
+  // Entries removed by another process at the same time count as removed.
+  for (const Entry &entry : entries) {
+    if (totalSize <= maxSize)
+      break;
+    if (unlink(entry.path.c_str()) == 0 || errno == ENOENT)
+      totalSize -= entry.size;
+  }
+}
@@ -0,0 +1,328 @@
+#include "SymEngine/SliceCompiler.h"
+
+#include "SymEngine/BlockMask.h"
+#include "SymEngine/NDRange.h"
+#include "SymEngine/NDRangeSpace.h"
+#include "SymEngine/OCLEnv.h"
+#include "SymEngine/Utils.h"
+
+#include "llvm/ExecutionEngine/ExecutionEngine.h"
+#include "llvm/ExecutionEngine/MCJIT.h"
+
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/Verifier.h"
+
+#include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <cstddef>
+#include <mutex>
+
+using namespace llvm;
+using namespace SymEngine;
+
+//------------------------------------------------------------------------------
+SliceCompiler::SliceCompiler(const OCLEnv &ocl, BlockMask &blockMask)
+    : ocl(ocl), blockMask(blockMask), sliceNumber(0) {
+  static std::once_flag targetInitialization;
+  std::call_once(targetInitialization, []() {
+    InitializeNativeTarget();
+    InitializeNativeTargetAsmPrinter();
+  });
+}
+
+SliceCompiler::~SliceCompiler() {}
+
+//------------------------------------------------------------------------------
+// True if constant is a global array, like a __local array, or a constant
+// GEP or cast over one, like the array after decay. The array is a base
+// pointer.
+static bool isGlobalBase(const Constant *constant) {
+  if (isa<GlobalVariable>(constant))
+    return true;
+  const ConstantExpr *expression = dyn_cast<ConstantExpr>(constant);
+  if (expression == nullptr ||
+      (expression->getOpcode() != Instruction::GetElementPtr &&
+       !expression->isCast()))
+    return false;
+  for (unsigned int index = 1; index < expression->getNumOperands(); ++index)
+    if (!isa<ConstantInt>(expression->getOperand(index)))
+      return false;
+  return isGlobalBase(expression->getOperand(0));
+}
+
+//------------------------------------------------------------------------------
+// True if constant refers to any function or global variable: they live in
+// the kernel module, which the slice module cannot link to.
+static bool refersToGlobal(const Constant *constant) {
+  if (isa<GlobalValue>(constant))
+    return true;
+  for (const Use &operand : constant->operands())
+    if (refersToGlobal(cast<Constant>(operand.get())))
+      return true;
+  return false;
+}
+
+//------------------------------------------------------------------------------
+bool SliceCompiler::collectSlice(Value *value, std::set<Value *> &visited,
+                                 std::vector<Instruction *> &slice) const {
+  if (!visited.insert(value).second)
+    return true;
+
+  if (Constant *constant = dyn_cast<Constant>(value))
+    return isGlobalBase(constant) || !refersToGlobal(constant);
+
+  // Integer arguments are replaced with their values, the base pointer with
+  // null.
+  if (isa<Argument>(value))
+    return value->getType()->isPointerTy() ||
+           (value->getType()->isIntegerTy() && !ocl.hasSymbolicArguments());
+
+  Instruction *inst = dyn_cast<Instruction>(value);
+  if (inst == nullptr)
+    return false;
+
+  if (CallInst *call = dyn_cast<CallInst>(inst)) {
+    if (call->getCalledFunction() == nullptr)
+      return false;
+    const NDRange *ndr = ocl.getNDRange();
+    if (ndr->isCoordinate(inst) || ndr->isSize(inst)) {
+      if (ndr->getDirection(inst) < 0)
+        return false;
+      slice.push_back(inst);
+      return true;
+    }
+    if (!isOpenCLIntCast(inst))
+      return false;
+  } else if (!isa<BinaryOperator>(inst) && !isa<CastInst>(inst) &&
+             !isa<GetElementPtrInst>(inst) && !isa<CmpInst>(inst) &&
+             !isa<SelectInst>(inst)) {
+    return false;
+  }
+
+  for (Value *operand : inst->operands())
+    if (!isa<Function>(operand) && !collectSlice(operand, visited, slice))
+      return false;
+
+  slice.push_back(inst);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Copy of the global base constant with the global array replaced by null,
+// keeping the constant offsets applied to it.
+static Constant *getNullBase(Constant *constant) {
+  if (isa<GlobalVariable>(constant))
+    return ConstantPointerNull::get(cast<PointerType>(constant->getType()));
+
+  ConstantExpr *expression = cast<ConstantExpr>(constant);
+  Constant *base = getNullBase(expression->getOperand(0));
+  if (expression->isCast())
+    return ConstantExpr::getCast(expression->getOpcode(), base,
+                                 expression->getType());
+  std::vector<Constant *> indices;
+  for (unsigned int index = 1; index < expression->getNumOperands(); ++index)
+    indices.push_back(expression->getOperand(index));
+  // Not in bounds of any object, as the GEPs of the slice.
+  return ConstantExpr::getGetElementPtr(base, indices, false);
+}
+
+//------------------------------------------------------------------------------
+// Map value to its copy in the slice function.
+static Value *getSliceValue(Value *value, std::map<Value *, Value *> &values,
+                            const OCLEnv &ocl) {
+  auto iter = values.find(value);
+  if (iter != values.end())
+    return iter->second;
+
+  if (isa<Argument>(value)) {
+    Type *type = value->getType();
+    if (PointerType *pointerType = dyn_cast<PointerType>(type))
+      return values[value] = ConstantPointerNull::get(pointerType);
+    return values[value] = ConstantInt::get(type, ocl.resolveValue(value));
+  }
+
+  // Global arrays are base pointers, like the pointer arguments.
+  Constant *constant = dyn_cast<Constant>(value);
+  if (constant != nullptr && isGlobalBase(constant))
+    return values[value] = getNullBase(constant);
+
+  // Other constants are shared by all the modules of the context.
+  return value;
+}
+
+//------------------------------------------------------------------------------
+// Emit the load of the coordinate of the lane computed by call.
+static Value *emitCoordinate(IRBuilder<> &builder, const NDRange *ndr,
+                             CallInst *call, Value *lanes, Value *lane) {
+  std::string type = ndr->getType(call);
+  CompiledExpression::OpCode opCode = CompiledExpression::LOCAL_ID;
+  if (type == NDRange::GET_GLOBAL_ID)
+    opCode = CompiledExpression::GLOBAL_ID;
+  else if (type == NDRange::GET_GROUP_ID)
+    opCode = CompiledExpression::GROUP_ID;
+  int index = CompiledExpression::getCoordinateIndex(opCode,
+                                                     ndr->getDirection(call));
+
+  Type *int32Type = builder.getInt32Ty();
+  Value *values = builder.CreateBitCast(
+      builder.CreateConstGEP1_32(lanes, offsetof(LaneCoordinates, values)),
+      int32Type->getPointerTo());
+  Value *position = builder.CreateAdd(
+      builder.getInt32(index * LaneCoordinates::MAX_LANE_NUMBER), lane);
+  Value *coordinate = builder.CreateLoad(builder.CreateGEP(values, position));
+  return builder.CreateZExtOrTrunc(coordinate, call->getType());
+}
+
+//------------------------------------------------------------------------------
+WarpSlice SliceCompiler::compile(Instruction *inst, Value *pointer) {
+  std::set<Value *> visited;
+  std::vector<Instruction *> slice;
+  if (!pointer->getType()->isPointerTy() ||
+      !collectSlice(pointer, visited, slice))
+    return nullptr;
+
+  // The access is executed when every controlling branch goes towards it.
+  std::vector<BlockBranchPair> controllers =
+      blockMask.getControllers(inst->getParent());
+  std::vector<std::pair<Value *, bool>> conditions;
+  for (const BlockBranchPair &controller : controllers) {
+    BranchInst *branch =
+        dyn_cast<BranchInst>(controller.first->getTerminator());
+    if (branch == nullptr)
+      return nullptr;
+    if (branch->isUnconditional())
+      continue;
+    if (!collectSlice(branch->getCondition(), visited, slice))
+      return nullptr;
+    conditions.push_back(
+        std::make_pair(branch->getCondition(), controller.second));
+  }
+
+  // void slice(i8 *lanes, i64 *addresses, i64 *activeMask)
+  LLVMContext &context = inst->getContext();
+  std::string name = "slice" + std::to_string(sliceNumber++);
+  std::unique_ptr<Module> module(new Module(name, context));
+  IRBuilder<> builder(context);
+  Type *int64Type = builder.getInt64Ty();
+  Type *argumentTypes[] = {builder.getInt8PtrTy(), int64Type->getPointerTo(),
+                           int64Type->getPointerTo()};
+  FunctionType *functionType =
+      FunctionType::get(builder.getVoidTy(), argumentTypes, false);
+  Function *function = Function::Create(
+      functionType, GlobalValue::ExternalLinkage, name, module.get());
+  Function::arg_iterator arguments = function->arg_begin();
+  Value *lanes = &*arguments;
+  Value *addresses = &*++arguments;
+  Value *activeMask = &*++arguments;
+
+  BasicBlock *entry = BasicBlock::Create(context, "entry", function);
+  BasicBlock *header = BasicBlock::Create(context, "header", function);
+  BasicBlock *body = BasicBlock::Create(context, "body", function);
+  BasicBlock *exit = BasicBlock::Create(context, "exit", function);
+
+  builder.SetInsertPoint(entry);
+  Value *laneNumber = builder.CreateLoad(builder.CreateBitCast(
+      builder.CreateConstGEP1_32(lanes, offsetof(LaneCoordinates, laneNumber)),
+      builder.getInt32Ty()->getPointerTo()));
+  builder.CreateStore(builder.getInt64(0), activeMask);
+  builder.CreateBr(header);
+
+  builder.SetInsertPoint(header);
+  PHINode *lane = builder.CreatePHI(builder.getInt32Ty(), 2);
+  lane->addIncoming(builder.getInt32(0), entry);
+  builder.CreateCondBr(builder.CreateICmpSLT(lane, laneNumber), body, exit);
+
+  builder.SetInsertPoint(body);
+  const NDRange *ndr = ocl.getNDRange();
+  std::map<Value *, Value *> values;
+  for (Instruction *original : slice) {
+    if (ndr->isCoordinate(original)) {
+      values[original] = emitCoordinate(builder, ndr, cast<CallInst>(original),
+                                        lanes, lane);
+      continue;
+    }
+    if (ndr->isSize(original)) {
+      int size = ocl.getNDRangeSpace()->getSize(ndr->getType(original),
+                                                ndr->getDirection(original));
+      values[original] = ConstantInt::get(original->getType(), size);
+      continue;
+    }
+    if (isOpenCLIntCast(original)) {
+      Value *operand = getSliceValue(cast<CallInst>(original)->getArgOperand(0),
+                                     values, ocl);
+      values[original] = builder.CreateBitCast(operand, original->getType());
+      continue;
+    }
+
+    Instruction *copy = original->clone();
+    for (unsigned int index = 0; index < copy->getNumOperands(); ++index)
+      copy->setOperand(index,
+                       getSliceValue(copy->getOperand(index), values, ocl));
+
+    // The base pointer is null: the offsets are not in bounds of any object.
+    if (GetElementPtrInst *gep = dyn_cast<GetElementPtrInst>(copy))
+      gep->setIsInBounds(false);
+
+    // The slice is run for the inactive lanes too: their divisors can be 0.
+    if (copy->getOpcode() == Instruction::UDiv ||
+        copy->getOpcode() == Instruction::SDiv ||
+        copy->getOpcode() == Instruction::URem ||
+        copy->getOpcode() == Instruction::SRem) {
+      Value *divisor = copy->getOperand(1);
+      Value *one = ConstantInt::get(divisor->getType(), 1);
+      copy->setOperand(1, builder.CreateSelect(builder.CreateIsNull(divisor),
+                                               one, divisor));
+    }
+    values[original] = builder.Insert(copy);
+  }
+
+  Value *laneIndex = builder.CreateZExt(lane, int64Type);
+  Value *address =
+      builder.CreatePtrToInt(getSliceValue(pointer, values, ocl), int64Type);
+  builder.CreateStore(address, builder.CreateGEP(addresses, laneIndex));
+
+  Value *active = builder.getTrue();
+  for (auto &condition : conditions) {
+    Value *value = getSliceValue(condition.first, values, ocl);
+    if (!condition.second)
+      value = builder.CreateNot(value);
+    active = builder.CreateAnd(active, value);
+  }
+  Value *laneBit = builder.CreateShl(builder.getInt64(1), laneIndex);
+  Value *mask = builder.CreateOr(
+      builder.CreateLoad(activeMask),
+      builder.CreateSelect(active, laneBit, builder.getInt64(0)));
+  builder.CreateStore(mask, activeMask);
+  lane->addIncoming(builder.CreateAdd(lane, builder.getInt32(1)),
+                    builder.GetInsertBlock());
+  builder.CreateBr(header);
+
+  builder.SetInsertPoint(exit);
+  builder.CreateRetVoid();
+
+  if (verifyFunction(*function, &errs())) {
+    errs() << "WARNING: slice of the access cannot be compiled\n";
+    return nullptr;
+  }
+
+  std::string error;
+  std::unique_ptr<ExecutionEngine> engine(
+      EngineBuilder(std::move(module))
+          .setEngineKind(EngineKind::JIT)
+          .setErrorStr(&error)
+          .create());
+  if (engine == nullptr) {
+    errs() << "WARNING: slice of the access cannot be compiled: " << error
+           << "\n";
+    return nullptr;
+  }
+
+  engine->finalizeObject();
+  WarpSlice result =
+      reinterpret_cast<WarpSlice>(engine->getFunctionAddress(name));
+  engines.push_back(std::move(engine));
+  return result;
+}
@@ -1,18 +1,18 @@
 #include "SymEngine/SubscriptAnalysis.h"
 
-#include "SymEngine/MemoryAccessesAnalyzer.h"
+#include "SymEngine/GroupSampler.h"
 #include "SymEngine/NDRange.h"
 #include "SymEngine/NDRangePoint.h"
+#include "SymEngine/NDRangeSpace.h"
 #include "SymEngine/OCLEnv.h"
-#include "SymEngine/Warp.h"
 
 #include "llvm/IR/Instructions.h"
 
 #include "llvm/Support/raw_ostream.h"
 
 #include <algorithm>
-#include <functional>
-#include <iterator>
+#include <cassert>
+#include <cmath>
 
 using namespace llvm;
 using namespace SymEngine;
@@ -21,9 +21,73 @@ int getTypeWidth(const Type *type);
 
 //------------------------------------------------------------------------------
 SubscriptAnalysis::SubscriptAnalysis(ScalarEvolution *scalarEvolution,
-                                     OCLEnv &&ocl, BlockMask &&blockMask)
-    : scalarEvolution(scalarEvolution), ocl(std::move(ocl)),
-      blockMask(std::move(blockMask)) {}
+                                     std::shared_ptr<const OCLEnv> oclEnv,
+                                     BlockMask &&blockMask,
+                                     ThreadPool &threadPool)
+    : scalarEvolution(scalarEvolution), oclEnv(std::move(oclEnv)),
+      ocl(*this->oclEnv), blockMask(std::move(blockMask)),
+      compiler(scalarEvolution, ocl), compilationNumber(0),
+      threadPool(threadPool)
+#ifdef SYM_ENGINE_JIT
+      , sliceCompiler(ocl, this->blockMask)
+#endif
+{
+  setHardware(this->oclEnv);
+}
+
+SubscriptAnalysis::~SubscriptAnalysis() {}
+
+//------------------------------------------------------------------------------
+// The compiled expressions are bound to the NDRange, the slices take the
+// coordinates of the lanes: only the simulator and the masks depend on the
+// hardware.
+void SubscriptAnalysis::setHardware(std::shared_ptr<const OCLEnv> oclEnv) {
+  hardwareEnv = std::move(oclEnv);
+  simulator.reset(new WarpSimulator(hardwareEnv->getNDRangeSpace(),
+                                    hardwareEnv->getHWConfig(), threadPool));
+  activeMasks.clear();
+  confidenceIntervals.clear();
+}
+
+//------------------------------------------------------------------------------
+void SubscriptAnalysis::prepareAccess(Instruction *inst, Value *value,
+                                      const SCEV *tripCount) {
+  getSubscript(value);
+  getConditions(inst->getParent());
+  getActiveMasks(inst->getParent());
+  if (tripCount != nullptr)
+    resolveTripCount(tripCount);
+  if (hardwareEnv->isNDRangeSampling())
+    confidenceIntervals[inst] = 0;
+#ifdef SYM_ENGINE_JIT
+  if (slices.count(inst) == 0 && needsSlice(inst, value))
+    slices[inst] = sliceCompiler.compile(inst, value);
+#endif
+}
+
+#ifdef SYM_ENGINE_JIT
+//------------------------------------------------------------------------------
+// True if the compiled subscript and block conditions do not describe the
+// access exactly.
+bool SubscriptAnalysis::needsSlice(Instruction *inst, Value *value) {
+  if (!getSubscript(value).isComputable())
+    return true;
+  for (auto &condition : getConditions(inst->getParent()))
+    if (!condition.expression.isComputable())
+      return true;
+
+  // BlockMask takes the branches on values other than comparisons as
+  // always taken.
+  for (auto &controller : blockMask.getControllers(inst->getParent())) {
+    BranchInst *branch =
+        dyn_cast<BranchInst>(controller.first->getTerminator());
+    if (branch != nullptr && branch->isConditional() &&
+        !isa<CmpInst>(branch->getCondition()))
+      return true;
+  }
+  return false;
+}
+#endif
 
 //------------------------------------------------------------------------------
 const SCEV *getSCEV(Value *value, ScalarEvolution *scalarEvolution) {
@@ -40,321 +104,175 @@ const SCEV *getSCEV(Value *value, ScalarEvolution *scalarEvolution) {
 
 //------------------------------------------------------------------------------
 int SubscriptAnalysis::getBankConflictNumber(Instruction *inst, Value *value) {
-  auto scev = getSCEV(value, scalarEvolution);
-  if (scev == nullptr)
-    return -1;
-
-  auto warps = ocl.getWarps();
-  std::vector<int> conflictNumber;
-
-  for (auto currentWarp : warps) {
-    std::vector<const SCEV *> addressesVector =
-        analyzeSubscript(inst, scev, currentWarp);
-    if (addressesVector.empty())
-      continue;
-
-    int currentBankConflicts = computeBankConflictNumber(
-        addressesVector, ocl.getHWConfig(), scalarEvolution);
-    conflictNumber.push_back(currentBankConflicts);
-  }
-
-  int result = std::accumulate(conflictNumber.begin(), conflictNumber.end(), 0,
-                               std::plus<int>());
-  return result;
+  return countAccesses(inst, value, WarpSimulator::BANK_CONFLICTS);
 }
 
 //------------------------------------------------------------------------------
 int SubscriptAnalysis::getBankConflictNumberInLoop(Instruction *inst,
                                                    Value *value,
                                                    const SCEV *tripCount) {
-  return getBankConflictNumber(inst, value) * resolveTripCount(tripCount);
+  int result = getBankConflictNumber(inst, value);
+  int tripCountValue = resolveTripCount(tripCount);
+  scaleConfidenceInterval(inst, tripCountValue);
+  return result * tripCountValue;
 }
 
 //------------------------------------------------------------------------------
 int SubscriptAnalysis::getTransactionNumber(Instruction *inst, Value *value) {
-  auto scev = getSCEV(value, scalarEvolution);
-  if (scev == nullptr)
-    return -1;
-
-  auto warps = ocl.getWarps();
-  std::vector<int> transactionNumber;
-
-  for (auto currentWarp : warps) {
-    std::vector<const SCEV *> addressesVector =
-        analyzeSubscript(inst, scev, currentWarp);
-    if (addressesVector.empty())
-      continue;
-
-    int currentTransactionNumber = computeTransactionNumber(
-        addressesVector, ocl.getHWConfig(), scalarEvolution);
-
-    transactionNumber.push_back(currentTransactionNumber);
-  }
-
-  // Decide how to accumulate the results.
-  int result = std::accumulate(transactionNumber.begin(),
-                               transactionNumber.end(), 0, std::plus<int>());
-  return result;
+  return countAccesses(inst, value, WarpSimulator::TRANSACTIONS);
 }
 
 //------------------------------------------------------------------------------
 int SubscriptAnalysis::getTransactionNumberInLoop(Instruction *inst,
                                                   Value *value,
                                                   const SCEV *tripCount) {
-  return getTransactionNumber(inst, value) * resolveTripCount(tripCount);
+  int result = getTransactionNumber(inst, value);
+  int tripCountValue = resolveTripCount(tripCount);
+  scaleConfidenceInterval(inst, tripCountValue);
+  return result * tripCountValue;
 }
 
 //------------------------------------------------------------------------------
-int SubscriptAnalysis::resolveTripCount(const SCEV *tripCount) {
-  int DEFAULT_LOOP_TRIP_COUNT = 1024;
-  NDRangePoint pointZero;
-  SCEVMap processed;
-  const SCEV *resolvedCount = replaceInExpr(tripCount, pointZero, processed);
-  if (resolvedCount == nullptr) {
-    errs() << "WARNING: loop trip count cannot be resolved, defaulting to "
-           << DEFAULT_LOOP_TRIP_COUNT << "\n";
-    return DEFAULT_LOOP_TRIP_COUNT;
-  }
-
-  if (const SCEVConstant *constSCEV = dyn_cast<SCEVConstant>(resolvedCount)) {
-    const ConstantInt *value = constSCEV->getValue();
-    return value->getValue().roundToDouble();
-  } else {
-    errs() << "WARNING: loop trip count cannot be resolved, defaulting to "
-           << DEFAULT_LOOP_TRIP_COUNT << "\n";
-    return DEFAULT_LOOP_TRIP_COUNT;
-  }
-
-  return 0;
+AccessFormula SubscriptAnalysis::getAccessFormula(Instruction *inst,
+                                                  Value *value,
+                                                  const SCEV *tripCount) {
+  AccessFormula formula;
+  formula.isLoad = false;
+  formula.isLocal = false;
+  if (auto scev = getSCEV(value, scalarEvolution))
+    formula.subscript = compiler.compile(scev);
+  else
+    formula.subscript.setUnknown();
+
+  for (auto &condition : blockMask.getConditions(inst->getParent()))
+    formula.blockConditions.push_back(compiler.compile(condition));
+
+  formula.tripCount = tripCount != nullptr
+                          ? compiler.compile(tripCount)
+                          : CompiledExpression::createConstant(1);
+  return formula;
 }
 
 //------------------------------------------------------------------------------
-std::vector<const SCEV *> SubscriptAnalysis::analyzeSubscript(Instruction *inst,
-                                                              const SCEV *scev,
-                                                              Warp &warp) {
-  std::vector<const SCEV *> resultVector;
-  resultVector.reserve(ocl.getHWConfig().warpSize);
-
-  // Iterate over threads in a warp.
-  for (auto iter = warp.begin(), iterEnd = warp.end(); iter != iterEnd;
-       ++iter) {
-    NDRangePoint point = *iter;
-
-    if (!isOperationExecuted(point, inst))
-      continue;
-
-    SCEVMap processed;
-    const SCEV *expr = replaceInExpr(scev, point, processed);
-    resultVector.push_back(expr);
+int SubscriptAnalysis::countAccesses(Instruction *inst, Value *value,
+                                     WarpSimulator::AccessCounter counter) {
+  const OCLEnv &hardware = *hardwareEnv;
+#ifdef SYM_ENGINE_JIT
+  // Sampled estimates keep using the compiled expressions.
+  auto slice = slices.find(inst);
+  if (slice != slices.end() && slice->second != nullptr &&
+      !hardware.isNDRangeSampling()) {
+    if (hardware.isNDRangeSimulation())
+      return simulator->countSliceAccessesInNDRange(slice->second, counter);
+    return simulator->countSliceAccesses(hardware.getWarps(), slice->second,
+                                         counter);
   }
+#endif
 
-  return resultVector;
-}
+  const CompiledExpression &subscript = getSubscript(value);
+  if (!subscript.isComputable())
+    return -1;
 
-//------------------------------------------------------------------------------
-const SCEV *SubscriptAnalysis::replaceInExpr(const SCEV *expr,
-                                             const NDRangePoint &point,
-                                             SCEVMap &processed) {
-  SCEVMap::iterator iter = processed.find(expr);
-  if (iter != processed.end()) {
-    return processed[expr];
+  BasicBlock *block = inst->getParent();
+  const std::vector<CompiledCondition> &blockConditions = getConditions(block);
+  WarpSimulator::ActiveMasks &masks = getActiveMasks(block);
+
+  if (hardware.isNDRangeSimulation())
+    return simulator->countAccessesInNDRange(subscript, blockConditions,
+                                             masks, counter);
+
+  if (hardware.isNDRangeSampling()) {
+    SampledEstimate estimate = simulator->estimateAccesses(
+        subscript, blockConditions, masks, counter, hardware.getGroupSampler());
+    auto iter = confidenceIntervals.find(inst);
+    assert(iter != confidenceIntervals.end() && "Access not prepared");
+    iter->second = std::ceil(estimate.halfWidth);
+    return std::round(estimate.total);
   }
 
-  const SCEV *result = nullptr;
-
-  // FIXME: This is ugly.
-  if (const SCEVCommutativeExpr *tmp = dyn_cast<SCEVCommutativeExpr>(expr))
-    result = replaceInExpr(tmp, point, processed);
-  if (const SCEVConstant *tmp = dyn_cast<SCEVConstant>(expr))
-    result = replaceInExpr(tmp, point, processed);
-  if (const SCEVUnknown *tmp = dyn_cast<SCEVUnknown>(expr))
-    result = replaceInExpr(tmp, point, processed);
-  if (const SCEVUDivExpr *tmp = dyn_cast<SCEVUDivExpr>(expr))
-    result = replaceInExpr(tmp, point, processed);
-  if (const SCEVAddRecExpr *tmp = dyn_cast<SCEVAddRecExpr>(expr))
-    result = replaceInExpr(tmp, point, processed);
-  if (const SCEVCastExpr *tmp = dyn_cast<SCEVCastExpr>(expr))
-    result = replaceInExpr(tmp, point, processed);
-
-  processed[expr] = result;
-
-  return result;
+  return simulator->countAccesses(hardware.getWarps(), subscript,
+                                  blockConditions, masks, counter);
 }
 
 //------------------------------------------------------------------------------
-const SCEV *SubscriptAnalysis::replaceInExpr(const SCEVAddRecExpr *expr,
-                                             const NDRangePoint &point,
-                                             SCEVMap &processed) {
-  const SCEV *start = expr->getStart();
-  // Check that the step is independent of the TID. TODO.
-  return replaceInExpr(start, point, processed);
+int SubscriptAnalysis::getConfidenceInterval(Instruction *inst) const {
+  auto iter = confidenceIntervals.find(inst);
+  return iter == confidenceIntervals.end() ? 0 : iter->second;
 }
 
 //------------------------------------------------------------------------------
-const SCEV *SubscriptAnalysis::replaceInExpr(const SCEVCommutativeExpr *expr,
-                                             const NDRangePoint &point,
-                                             SCEVMap &processed) {
-  SmallVector<const SCEV *, 8> operands;
-  for (auto iter = expr->op_begin(), iterEnd = expr->op_end(); iter != iterEnd;
-       ++iter) {
-    const SCEV *NewOperand = replaceInExpr(*iter, point, processed);
-    if (isa<SCEVCouldNotCompute>(NewOperand))
-      return scalarEvolution->getCouldNotCompute();
-    operands.push_back(NewOperand);
-  }
-  const SCEV *result = nullptr;
-
-  if (isa<SCEVAddExpr>(expr))
-    result = scalarEvolution->getAddExpr(operands);
-  if (isa<SCEVMulExpr>(expr))
-    result = scalarEvolution->getMulExpr(operands);
-  if (isa<SCEVSMaxExpr>(expr))
-    result = scalarEvolution->getSMaxExpr(operands);
-  if (isa<SCEVUMaxExpr>(expr))
-    result = scalarEvolution->getUMaxExpr(operands);
-
-  return result;
+int SubscriptAnalysis::getCompilationNumber() const {
+  return compilationNumber;
 }
 
 //------------------------------------------------------------------------------
-const SCEV *SubscriptAnalysis::replaceInExpr(const SCEVConstant *expr,
-                                             const NDRangePoint &, SCEVMap &) {
-  return expr;
-}
-
-//------------------------------------------------------------------------------
-const SCEV *SubscriptAnalysis::replaceInExpr(const SCEVUnknown *expr,
-                                             const NDRangePoint &point,
-                                             SCEVMap &processed) {
-  Value *value = expr->getValue();
-  // Implement actual replacement.
-  if (Instruction *instruction = dyn_cast<Instruction>(value)) {
-
-    // Manage binary operations.
-    if (BinaryOperator *BinOp = dyn_cast<BinaryOperator>(instruction)) {
-      // Modulo.
-      if (BinOp->getOpcode() == Instruction::URem) {
-        const SCEV *Arg = scalarEvolution->getSCEV(BinOp->getOperand(0));
-        const SCEV *Modulo = scalarEvolution->getSCEV(BinOp->getOperand(1));
-        const SCEV *Result = scalarEvolution->getMinusSCEV(
-            Arg, scalarEvolution->getMulExpr(
-                     scalarEvolution->getUDivExpr(Arg, Modulo), Modulo));
-        return replaceInExpr(Result, point, processed);
-      }
-
-      // Signed division.
-      if (BinOp->getOpcode() == Instruction::SDiv) {
-        const SCEV *First = scalarEvolution->getSCEV(BinOp->getOperand(0));
-        const SCEV *Second = scalarEvolution->getSCEV(BinOp->getOperand(1));
-        const SCEV *Div = scalarEvolution->getUDivExpr(First, Second);
-        return replaceInExpr(Div, point, processed);
-      }
-
-      // All the rest.
-      return scalarEvolution->getCouldNotCompute();
-    }
-
-    // Manage casts.
-    if (isOpenCLIntCast(instruction)) {
-      CallInst *Call = dyn_cast<CallInst>(instruction);
-      const SCEV *ArgSCEV = scalarEvolution->getSCEV(Call->getArgOperand(0));
-      return replaceInExpr(ArgSCEV, point, processed);
-    }
-
-    // Manage phi nodes.
-    if (PHINode *phi = dyn_cast<PHINode>(value))
-      return replaceInPhi(phi, point, processed);
-
-    return resolveInstruction(instruction, point);
-  }
-
-  // If the value is a function argument query OCL.
-  if (isa<Argument>(value) && value->getType()->isIntegerTy())
-    return scalarEvolution->getConstant(APInt(32, ocl.resolveValue(value)));
-
-  return expr;
+void SubscriptAnalysis::scaleConfidenceInterval(Instruction *inst,
+                                                int factor) {
+  auto iter = confidenceIntervals.find(inst);
+  if (iter != confidenceIntervals.end())
+    iter->second *= factor;
 }
 
 //------------------------------------------------------------------------------
-const SCEV *
-SubscriptAnalysis::resolveInstruction(llvm::Instruction *instruction,
-                                      const NDRangePoint &point) {
-  const NDRange *ndr = ocl.getNDRange();
-  const NDRangeSpace *ndrSpace = ocl.getNDRangeSpace();
-  std::string type = ndr->getType(instruction);
-
-  // Check if the instruction is a coordinate querying the NDRangePoint class.
-  if (ndr->isCoordinate(instruction)) {
-    int direction = ndr->getDirection(instruction);
-    int coordinate = point.getCoordinate(type, direction);
-    return scalarEvolution->getConstant(APInt(32, coordinate));
-  }
+int SubscriptAnalysis::resolveTripCount(const SCEV *tripCount) {
+  auto iter = tripCounts.find(tripCount);
+  if (iter != tripCounts.end())
+    return iter->second;
 
-  // Check if the instruction is a size querying the NDRange class.
-  if (ndr->isSize(instruction)) {
-    int direction = ndr->getDirection(instruction);
-    int size = ndrSpace->getSize(type, direction);
-    return scalarEvolution->getConstant(APInt(32, size));
+  NDRangePoint pointZero;
+  ++compilationNumber;
+  CompiledExpression resolvedCount =
+      compiler.compile(tripCount).bind(*ocl.getNDRangeSpace());
+  int64_t value = 0;
+  if (!resolvedCount.evaluate(pointZero, value)) {
+    errs() << "WARNING: loop trip count cannot be resolved, defaulting to "
+           << DEFAULT_LOOP_TRIP_COUNT << "\n";
+    value = DEFAULT_LOOP_TRIP_COUNT;
   }
 
-  // If the instruction is neither a coordinate nor a size return
-  // CouldNotCompute.
-  return scalarEvolution->getCouldNotCompute();
+  tripCounts[tripCount] = value;
+  return value;
 }
 
 //------------------------------------------------------------------------------
-const SCEV *SubscriptAnalysis::replaceInExpr(const SCEVUDivExpr *expr,
-                                             const NDRangePoint &point,
-                                             SCEVMap &processed) {
-  const SCEV *newLHS = replaceInExpr(expr->getLHS(), point, processed);
-  if (isa<SCEVCouldNotCompute>(newLHS))
-    return scalarEvolution->getCouldNotCompute();
-  const SCEV *newRHS = replaceInExpr(expr->getRHS(), point, processed);
-  if (isa<SCEVCouldNotCompute>(newRHS))
-    return scalarEvolution->getCouldNotCompute();
-
-  return scalarEvolution->getUDivExpr(newLHS, newRHS);
+const CompiledExpression &SubscriptAnalysis::getSubscript(Value *value) {
+  auto iter = subscripts.find(value);
+  if (iter != subscripts.end())
+    return iter->second;
+
+  CompiledExpression subscript;
+  ++compilationNumber;
+  if (auto scev = getSCEV(value, scalarEvolution))
+    subscript = compiler.compile(scev).bind(*ocl.getNDRangeSpace());
+  else
+    subscript.setUnknown();
+  return subscripts.insert(std::make_pair(value, subscript)).first->second;
 }
 
 //------------------------------------------------------------------------------
-const SCEV *SubscriptAnalysis::replaceInExpr(const SCEVCastExpr *expr,
-                                             const NDRangePoint &point,
-                                             SCEVMap &processed) {
-  return replaceInExpr(expr->getOperand(), point, processed);
-}
-
-//------------------------------------------------------------------------------
-const SCEV *SubscriptAnalysis::replaceInPhi(PHINode *Phi,
-                                            const NDRangePoint &point,
-                                            SCEVMap &processed) {
-  // FIXME: Pick the first argument of the phi node.
-  Value *param = Phi->getIncomingValue(0);
-  assert(scalarEvolution->isSCEVable(param->getType()) &&
-         "PhiNode argument non-SCEVable");
-
-  const SCEV *scev = scalarEvolution->getSCEV(param);
-
-  processed[scalarEvolution->getSCEV(Phi)] = scev;
+const std::vector<CompiledCondition> &
+SubscriptAnalysis::getConditions(BasicBlock *block) {
+  auto iter = conditions.find(block);
+  if (iter != conditions.end())
+    return iter->second;
+
+  std::vector<CompiledCondition> blockConditions;
+  for (auto &condition : blockMask.getConditions(block)) {
+    ++compilationNumber;
+    CompiledCondition compiled = compiler.compile(condition);
+    compiled.expression = compiled.expression.bind(*ocl.getNDRangeSpace());
+    blockConditions.push_back(compiled);
+  }
 
-  return replaceInExpr(scev, point, processed);
+  return conditions.insert(std::make_pair(block, blockConditions))
+      .first->second;
 }
 
 //------------------------------------------------------------------------------
-bool SubscriptAnalysis::isOperationExecuted(const NDRangePoint &point,
-                                            Instruction *inst) {
-  BasicBlock *block = inst->getParent();
-  std::vector<BlockCondition> conditions = blockMask.getConditions(block);
-
-  bool result = true;
-  for (auto &condition : conditions) {
-    SCEVMap processed;
-    const SCEV *resolvedCondition =
-        replaceInExpr(condition.getSCEV(), point, processed);
-    bool tmpResult = BlockCondition::getBooleanValue(
-        resolvedCondition, condition.getPredicate(), scalarEvolution);
-    result &= tmpResult;
-  }
-  return result;
+WarpSimulator::ActiveMasks &
+SubscriptAnalysis::getActiveMasks(BasicBlock *block) {
+  // The masks of the warps are added when they are first analyzed.
+  return activeMasks[block];
 }
 
 //------------------------------------------------------------------------------
@@ -0,0 +1,224 @@
+#include "SymEngine/SubscriptCompiler.h"
+
+#include "SymEngine/NDRange.h"
+#include "SymEngine/OCLEnv.h"
+#include "SymEngine/Utils.h"
+
+#include "llvm/IR/Instructions.h"
+
+using namespace llvm;
+using namespace SymEngine;
+
+//------------------------------------------------------------------------------
+SubscriptCompiler::SubscriptCompiler(ScalarEvolution *scalarEvolution,
+                                     const OCLEnv &ocl)
+    : scalarEvolution(scalarEvolution), ocl(ocl), basePointer(nullptr) {}
+
+//------------------------------------------------------------------------------
+CompiledExpression SubscriptCompiler::compile(const SCEV *scev) {
+  CompiledExpression result;
+  basePointer = nullptr;
+  visitingPhis.clear();
+  compileExpr(scev, result);
+  return result;
+}
+
+//------------------------------------------------------------------------------
+CompiledCondition SubscriptCompiler::compile(const BlockCondition &condition) {
+  if (condition.isTrue())
+    return {CompiledExpression::createConstant(0), CmpInst::FCMP_TRUE};
+  if (condition.isFalse())
+    return {CompiledExpression::createConstant(0), CmpInst::FCMP_FALSE};
+
+  return {compile(condition.getSCEV()), condition.getPredicate()};
+}
+
+//------------------------------------------------------------------------------
+void SubscriptCompiler::compileExpr(const SCEV *expr,
+                                    CompiledExpression &result) {
+  if (!result.isComputable())
+    return;
+
+  auto iter = translations.find(expr);
+  if (iter != translations.end())
+    return result.appendExpression(iter->second);
+
+  // Pointer expressions depend on the base pointer of the access, and inside
+  // a phi cycle the translation depends on the phis being visited: do not
+  // reuse them.
+  if (!expr->getType()->isIntegerTy() || !visitingPhis.empty())
+    return translateExpr(expr, result);
+
+  CompiledExpression translation;
+  translateExpr(expr, translation);
+  translations.insert(std::make_pair(expr, translation));
+  result.appendExpression(translation);
+}
+
+//------------------------------------------------------------------------------
+void SubscriptCompiler::translateExpr(const SCEV *expr,
+                                      CompiledExpression &result) {
+  if (!result.isComputable())
+    return;
+
+  if (const SCEVCommutativeExpr *tmp = dyn_cast<SCEVCommutativeExpr>(expr))
+    return compileExpr(tmp, result);
+  if (const SCEVConstant *tmp = dyn_cast<SCEVConstant>(expr))
+    return compileExpr(tmp, result);
+  if (const SCEVUnknown *tmp = dyn_cast<SCEVUnknown>(expr))
+    return compileExpr(tmp, result);
+  if (const SCEVUDivExpr *tmp = dyn_cast<SCEVUDivExpr>(expr))
+    return compileExpr(tmp, result);
+  if (const SCEVAddRecExpr *tmp = dyn_cast<SCEVAddRecExpr>(expr))
+    return compileExpr(tmp, result);
+  if (const SCEVCastExpr *tmp = dyn_cast<SCEVCastExpr>(expr))
+    return compileExpr(tmp, result);
+
+  // SCEVCouldNotCompute.
+  result.setUnknown();
+}
+
+//------------------------------------------------------------------------------
+void SubscriptCompiler::compileExpr(const SCEVAddRecExpr *expr,
+                                    CompiledExpression &result) {
+  // Check that the step is independent of the TID. TODO.
+  compileExpr(expr->getStart(), result);
+}
+
+//------------------------------------------------------------------------------
+void SubscriptCompiler::compileExpr(const SCEVCommutativeExpr *expr,
+                                    CompiledExpression &result) {
+  int operandNumber = 0;
+  for (auto iter = expr->op_begin(), iterEnd = expr->op_end(); iter != iterEnd;
+       ++iter) {
+    compileExpr(*iter, result);
+    ++operandNumber;
+  }
+
+  if (isa<SCEVAddExpr>(expr))
+    result.appendOperation(CompiledExpression::ADD, operandNumber);
+  else if (isa<SCEVMulExpr>(expr))
+    result.appendOperation(CompiledExpression::MUL, operandNumber);
+  else if (isa<SCEVSMaxExpr>(expr))
+    result.appendOperation(CompiledExpression::SMAX, operandNumber);
+  else if (isa<SCEVUMaxExpr>(expr))
+    result.appendOperation(CompiledExpression::UMAX, operandNumber);
+  else
+    result.setUnknown();
+}
+
+//------------------------------------------------------------------------------
+void SubscriptCompiler::compileExpr(const SCEVConstant *expr,
+                                    CompiledExpression &result) {
+  result.appendConstant(expr->getValue()->getSExtValue());
+}
+
+//------------------------------------------------------------------------------
+void SubscriptCompiler::compileExpr(const SCEVUnknown *expr,
+                                    CompiledExpression &result) {
+  Value *value = expr->getValue();
+
+  if (Instruction *instruction = dyn_cast<Instruction>(value)) {
+    // Manage binary operations.
+    if (BinaryOperator *binOp = dyn_cast<BinaryOperator>(instruction))
+      return compileBinaryOperator(binOp, result);
+
+    // Manage casts.
+    if (isOpenCLIntCast(instruction)) {
+      CallInst *call = dyn_cast<CallInst>(instruction);
+      return compileExpr(scalarEvolution->getSCEV(call->getArgOperand(0)),
+                         result);
+    }
+
+    // Manage phi nodes.
+    if (PHINode *phi = dyn_cast<PHINode>(value))
+      return compilePhi(phi, result);
+
+    return compileInstruction(instruction, result);
+  }
+
+  // If the value is a function argument query OCL.
+  if (isa<Argument>(value) && value->getType()->isIntegerTy()) {
+    if (ocl.hasSymbolicArguments())
+      return result.appendArgument(ocl.getArgumentIndex(value));
+    return result.appendConstant(ocl.resolveValue(value));
+  }
+
+  // The base pointer of the access: compute the offset relative to it.
+  // Only one base pointer per expression is supported.
+  if (value->getType()->isPointerTy() &&
+      (basePointer == nullptr || basePointer == value)) {
+    basePointer = value;
+    return result.appendConstant(0);
+  }
+
+  result.setUnknown();
+}
+
+//------------------------------------------------------------------------------
+void SubscriptCompiler::compileBinaryOperator(BinaryOperator *binOp,
+                                              CompiledExpression &result) {
+  const SCEV *first = scalarEvolution->getSCEV(binOp->getOperand(0));
+  const SCEV *second = scalarEvolution->getSCEV(binOp->getOperand(1));
+
+  // Modulo.
+  if (binOp->getOpcode() == Instruction::URem) {
+    compileExpr(first, result);
+    compileExpr(second, result);
+    return result.appendOperation(CompiledExpression::UREM, 2);
+  }
+
+  // Signed division.
+  if (binOp->getOpcode() == Instruction::SDiv) {
+    compileExpr(first, result);
+    compileExpr(second, result);
+    return result.appendOperation(CompiledExpression::SDIV, 2);
+  }
+
+  // All the rest.
+  result.setUnknown();
+}
+
+//------------------------------------------------------------------------------
+void SubscriptCompiler::compilePhi(PHINode *phi, CompiledExpression &result) {
+  // A phi reached while compiling its own incoming value cannot be resolved.
+  if (visitingPhis.count(phi)) {
+    result.setUnknown();
+    return;
+  }
+
+  // FIXME: Pick the first argument of the phi node.
+  Value *param = phi->getIncomingValue(0);
+  assert(scalarEvolution->isSCEVable(param->getType()) &&
+         "PhiNode argument non-SCEVable");
+
+  visitingPhis.insert(phi);
+  compileExpr(scalarEvolution->getSCEV(param), result);
+  visitingPhis.erase(phi);
+}
+
+//------------------------------------------------------------------------------
+void SubscriptCompiler::compileInstruction(Instruction *instruction,
+                                           CompiledExpression &result) {
+  const NDRange *ndr = ocl.getNDRange();
+  std::string type = ndr->getType(instruction);
+  int direction = ndr->getDirection(instruction);
+
+  if (type == NDRange::GET_LOCAL_ID)
+    return result.appendCoordinate(CompiledExpression::LOCAL_ID, direction);
+  if (type == NDRange::GET_GLOBAL_ID)
+    return result.appendCoordinate(CompiledExpression::GLOBAL_ID, direction);
+  if (type == NDRange::GET_GROUP_ID)
+    return result.appendCoordinate(CompiledExpression::GROUP_ID, direction);
+
+  if (type == NDRange::GET_LOCAL_SIZE)
+    return result.appendSize(CompiledExpression::LOCAL_SIZE, direction);
+  if (type == NDRange::GET_GLOBAL_SIZE)
+    return result.appendSize(CompiledExpression::GLOBAL_SIZE, direction);
+  if (type == NDRange::GET_GROUPS_NUMBER)
+    return result.appendSize(CompiledExpression::GROUPS_NUMBER, direction);
+
+  // If the instruction is neither a coordinate nor a size it cannot be
+  // computed.
+  result.setUnknown();
+}
@@ -0,0 +1,185 @@
+#include "SymEngine/SymEngineC.h"
+
+#include "SymEngine/AccessFormula.h"
+#include "SymEngine/HardwareConfig.h"
+#include "SymEngine/ModulePipeline.h"
+#include "SymEngine/NDRangeSpace.h"
+#include "SymEngine/ThreadPool.h"
+#include "SymEngine/WarpEvaluator.h"
+
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace llvm;
+using namespace SymEngine;
+
+struct SymEngineOpaqueKernel {
+  const KernelFormulas *formulas;
+  ThreadPool *threadPool;
+};
+
+struct SymEngineOpaqueModule {
+  explicit SymEngineOpaqueModule(unsigned int threadNumber)
+      : threadPool(threadNumber) {}
+
+  std::vector<KernelFormulas> formulas;
+  std::vector<SymEngineOpaqueKernel> kernels;
+  ThreadPool threadPool;
+};
+
+// Held by the loads of all the modules, whatever their source, so that the
+// host program never runs several pipelines at once.
+static std::mutex compilation;
+
+//------------------------------------------------------------------------------
+// Compile the formulas of the module parsed by parse into a new handle.
+template <typename ParseFunction>
+static SymEngineStatus createModule(unsigned int threadNumber,
+                                    SymEngineModuleRef *module,
+                                    ParseFunction parse) {
+  initializePipeline();
+
+  std::unique_ptr<SymEngineOpaqueModule> result;
+  {
+    std::lock_guard<std::mutex> lock(compilation);
+    LLVMContext context;
+    std::string error;
+    std::unique_ptr<Module> llvmModule = parse(context, error);
+    if (!llvmModule)
+      return SYM_ENGINE_INVALID_MODULE;
+
+    result.reset(new SymEngineOpaqueModule(threadNumber));
+    result->formulas = compileModuleFormulas(*llvmModule);
+  }
+
+  for (const KernelFormulas &kernel : result->formulas)
+    result->kernels.push_back({&kernel, &result->threadPool});
+  *module = result.release();
+  return SYM_ENGINE_SUCCESS;
+}
+
+//------------------------------------------------------------------------------
+const char *SymEngineGetStatusString(SymEngineStatus status) {
+  switch (status) {
+  case SYM_ENGINE_SUCCESS:
+    return "success";
+  case SYM_ENGINE_INVALID_ARGUMENT:
+    return "invalid argument";
+  case SYM_ENGINE_INVALID_MODULE:
+    return "the module cannot be read";
+  case SYM_ENGINE_KERNEL_NOT_FOUND:
+    return "kernel not found";
+  case SYM_ENGINE_UNSUPPORTED_WARP_SIZE:
+    return "unsupported warp size";
+  }
+  return "unknown status";
+}
+
+//------------------------------------------------------------------------------
+SymEngineStatus SymEngineLoadModule(const char *fileName,
+                                    unsigned int threadNumber,
+                                    SymEngineModuleRef *module) {
+  if (fileName == nullptr || module == nullptr)
+    return SYM_ENGINE_INVALID_ARGUMENT;
+  return createModule(threadNumber, module,
+                      [fileName](LLVMContext &context, std::string &error) {
+    return loadModule(fileName, context, error);
+  });
+}
+
+//------------------------------------------------------------------------------
+SymEngineStatus SymEngineParseModule(const char *data, size_t size,
+                                     unsigned int threadNumber,
+                                     SymEngineModuleRef *module) {
+  if (data == nullptr || module == nullptr)
+    return SYM_ENGINE_INVALID_ARGUMENT;
+  return createModule(threadNumber, module,
+                      [data, size](LLVMContext &context, std::string &error) {
+    return parseModule(std::string(data, size), context, error);
+  });
+}
+
+//------------------------------------------------------------------------------
+void SymEngineDisposeModule(SymEngineModuleRef module) { delete module; }
+
+//------------------------------------------------------------------------------
+size_t SymEngineGetKernelNumber(SymEngineModuleRef module) {
+  return module == nullptr ? 0 : module->kernels.size();
+}
+
+//------------------------------------------------------------------------------
+SymEngineKernelRef SymEngineGetKernelAt(SymEngineModuleRef module,
+                                        size_t index) {
+  if (module == nullptr || index >= module->kernels.size())
+    return nullptr;
+  return &module->kernels[index];
+}
+
+//------------------------------------------------------------------------------
+SymEngineStatus SymEngineGetKernel(SymEngineModuleRef module,
+                                   const char *kernelName,
+                                   SymEngineKernelRef *kernel) {
+  if (module == nullptr || kernelName == nullptr || kernel == nullptr)
+    return SYM_ENGINE_INVALID_ARGUMENT;
+  for (const SymEngineOpaqueKernel &candidate : module->kernels)
+    if (candidate.formulas->kernelName == kernelName) {
+      *kernel = &candidate;
+      return SYM_ENGINE_SUCCESS;
+    }
+  return SYM_ENGINE_KERNEL_NOT_FOUND;
+}
+
+//------------------------------------------------------------------------------
+const char *SymEngineGetKernelName(SymEngineKernelRef kernel) {
+  return kernel == nullptr ? nullptr : kernel->formulas->kernelName.c_str();
+}
+
+//------------------------------------------------------------------------------
+size_t SymEngineGetAccessNumber(SymEngineKernelRef kernel) {
+  return kernel == nullptr ? 0 : kernel->formulas->accesses.size();
+}
+
+//------------------------------------------------------------------------------
+SymEngineStatus SymEngineEvaluate(SymEngineKernelRef kernel,
+                                  const SymEngineNDRange *ndRange,
+                                  const int64_t *arguments,
+                                  size_t argumentNumber,
+                                  const SymEngineHardware *hardware,
+                                  SymEngineAccessCount *counts) {
+  if (kernel == nullptr || ndRange == nullptr || hardware == nullptr ||
+      (arguments == nullptr && argumentNumber != 0) ||
+      (counts == nullptr && !kernel->formulas->accesses.empty()))
+    return SYM_ENGINE_INVALID_ARGUMENT;
+  for (int direction = 0; direction < 3; ++direction)
+    if (ndRange->localSize[direction] <= 0 ||
+        ndRange->numberOfGroups[direction] <= 0)
+      return SYM_ENGINE_INVALID_ARGUMENT;
+  if (hardware->banksNumber <= 0 || hardware->bankWidth <= 0 ||
+      hardware->warpSize <= 0 || hardware->cacheLineSize <= 0)
+    return SYM_ENGINE_INVALID_ARGUMENT;
+  if (hardware->warpSize > LaneCoordinates::MAX_LANE_NUMBER)
+    return SYM_ENGINE_UNSUPPORTED_WARP_SIZE;
+
+  NDRangeSpace ndrSpace(ndRange->localSize[0], ndRange->localSize[1],
+                        ndRange->localSize[2], ndRange->numberOfGroups[0],
+                        ndRange->numberOfGroups[1], ndRange->numberOfGroups[2]);
+  HardwareConfig hwConfig = {hardware->banksNumber, hardware->bankWidth,
+                             hardware->warpSize, hardware->cacheLineSize};
+  std::vector<int64_t> argumentValues(arguments, arguments + argumentNumber);
+
+  const std::vector<AccessFormula> &accesses = kernel->formulas->accesses;
+  for (size_t index = 0; index < accesses.size(); ++index) {
+    const AccessFormula &formula = accesses[index];
+    counts[index].isLoad = formula.isLoad;
+    counts[index].isLocal = formula.isLocal;
+    counts[index].count = evaluateAccessFormula(
+        formula, argumentValues, &ndrSpace, hwConfig, *kernel->threadPool);
+  }
+  return SYM_ENGINE_SUCCESS;
+}
@@ -3,21 +3,29 @@
 #include "SymEngine/BlockMask.h"
 #include "SymEngine/ControlDependenceAnalysis.h"
 #include "SymEngine/NDRange.h"
+#include "SymEngine/NDRangeSweep.h"
 #include "SymEngine/OCLEnv.h"
+#include "SymEngine/ResultCache.h"
 #include "SymEngine/SubscriptAnalysis.h"
+#include "SymEngine/ThreadPool.h"
 #include "SymEngine/Utils.h"
 #include "SymEngine/Warp.h"
+#include "SymEngine/WarpEvaluator.h"
+#include "SymEngine/YAMLReader.h"
 
 #include "llvm/Analysis/ScalarEvolution.h"
 
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/MDBuilder.h"
+#include "llvm/IR/Module.h"
 
 #include "llvm/Support/YAMLTraits.h"
 #include "llvm/Support/raw_ostream.h"
 
 #include <cassert>
+#include <map>
+#include <memory>
 
 using namespace llvm;
 using namespace SymEngine;
@@ -26,10 +34,78 @@ static cl::opt<std::string>
     kernelName("symbolic-kernel-name", cl::init(""), cl::Hidden,
                cl::desc("Name of the kernel to analyze"));
 
+static cl::opt<bool> allKernels(
+    "symbolic-all-kernels", cl::init(false), cl::Hidden,
+    cl::desc("Analyze all the kernels of the module and dump their results "
+             "keyed by kernel name (default if no kernel name is given)"));
+
+// True if all the kernels of the module are analyzed.
+static bool isAnalyzingAllKernels() {
+  return allKernels || kernelName.empty();
+}
+
+static cl::opt<std::string> sweepFileName(
+    "symbolic-sweep", cl::init(""), cl::Hidden,
+    cl::desc("Rank the NDRanges of the given sweep file instead of analyzing "
+             "the one of the config file"));
+
+static bool isSweeping() { return !sweepFileName.empty(); }
+
+// The sweep file is read once for all the kernels.
+static const SweepConfig &getSweepConfig() {
+  static const SweepConfig config = readSweepConfig(sweepFileName);
+  return config;
+}
+
+// Profiles of hardware_config.yaml, empty if it holds a single configuration.
+static const std::vector<HardwareProfile> &getHardwareProfiles() {
+  static const std::vector<HardwareProfile> profiles =
+      readHardwareProfiles(OCLEnv::HARDWARE_CONFIG_FILE_NAME);
+  return profiles;
+}
+
 static cl::opt<bool> loopMultiplier(
     "symbolic-loop-multiplier", cl::init(false), cl::Hidden,
     cl::desc("Control whether output is multiplied by loop trip count"));
 
+static cl::opt<std::string> cacheDirectory(
+    "symbolic-cache-dir", cl::init(""), cl::Hidden,
+    cl::desc("Directory of the results cached across runs (no cache if "
+             "empty)"));
+
+static cl::opt<unsigned int>
+    cacheSize("symbolic-cache-size", cl::init(256), cl::Hidden,
+              cl::desc("Maximum size in MB of the results cache"));
+
+static const ResultCache *getResultCache() {
+  if (cacheDirectory.empty())
+    return nullptr;
+  static const ResultCache cache(cacheDirectory, uint64_t(cacheSize) << 20);
+  return &cache;
+}
+
+// Everything the counts of the kernel depend on: its IR after the pipeline,
+// the values of its arguments and the configuration.
+static std::string getCacheKey(Function &function, const OCLEnv &ocl) {
+  std::string key;
+  raw_string_ostream stream(key);
+  stream << "SymEngine " << ResultCache::FORMAT_VERSION << "\n";
+#ifdef SYM_ENGINE_JIT
+  stream << "jit\n";
+#endif
+  stream << "loop multiplier " << loopMultiplier << "\n";
+  stream << ocl.getConfigurationKey();
+  stream << "arguments";
+  for (Argument &argument : function.getArgumentList())
+    if (argument.getType()->isIntegerTy())
+      stream << " " << ocl.resolveValue(&argument);
+  Module *module = function.getParent();
+  stream << "\n" << module->getTargetTriple() << "\n"
+         << module->getDataLayoutStr() << "\n";
+  function.print(stream);
+  return stream.str();
+}
+
 char SymbolicExecution::ID = 0;
 static RegisterPass<SymbolicExecution>
     X("symbolic-execution",
@@ -49,43 +125,57 @@ namespace llvm {
 namespace yaml {
 
 //------------------------------------------------------------------------------
-template <> struct MappingTraits<SymbolicExecution> {
-  static void mapping(IO &io, SymbolicExecution &exe) {
-    io.mapRequired("load_transactions", exe.loadTransactions);
-    io.mapRequired("store_transactions", exe.storeTransactions);
-
-    io.mapRequired("load_bank_conflicts", exe.loadBankConflicts);
-    io.mapRequired("store_bank_conflicts", exe.storeBankConflicts);
+// Output only: the keys are the names of the profiles.
+template <> struct MappingTraits<ProfileResults> {
+  static void mapping(IO &io, ProfileResults &results) {
+    for (auto &profile : results.profiles)
+      io.mapRequired(profile.first.c_str(), profile.second);
   }
 };
 
 //------------------------------------------------------------------------------
-// Sequence of ints.
-template <> struct SequenceTraits<std::vector<int>> {
-  static size_t size(IO &, std::vector<int> &seq) { return seq.size(); }
-  static int &element(IO &, std::vector<int> &seq, size_t index) {
-    if (index >= seq.size())
-      seq.resize(index + 1);
-    return seq[index];
+// Output only: the keys are the names of the kernels.
+template <> struct MappingTraits<ModuleResults> {
+  static void mapping(IO &io, ModuleResults &results) {
+    for (auto &kernel : results.kernels)
+      io.mapRequired(kernel.first.c_str(), kernel.second);
+    for (auto &kernelFormulas : results.formulas)
+      io.mapRequired(kernelFormulas.kernelName.c_str(), kernelFormulas);
+    for (auto &kernel : results.profiles)
+      io.mapRequired(kernel.first.c_str(), kernel.second);
   }
-
-  static const bool flow = true;
 };
 }
 }
 
 // =============================================================================
 SymbolicExecution::SymbolicExecution()
-    : FunctionPass(ID), subscriptAnalysis(nullptr) {}
+    : FunctionPass(ID), symbolicArguments(false), formulasOutput(nullptr),
+      subscriptAnalysis(nullptr) {
+  results.sampling = false;
+}
+
+SymbolicExecution::SymbolicExecution(ModuleResults *formulasOutput)
+    : FunctionPass(ID), symbolicArguments(true),
+      formulasOutput(formulasOutput), subscriptAnalysis(nullptr) {
+  results.sampling = false;
+}
 
 SymbolicExecution::~SymbolicExecution() {
   if (subscriptAnalysis != nullptr)
     delete subscriptAnalysis;
 }
 
+//------------------------------------------------------------------------------
+bool SymbolicExecution::isSelected(Function &function) const {
+  if (formulasOutput != nullptr || isAnalyzingAllKernels())
+    return isKernel(function);
+  return function.getName() == kernelName;
+}
+
 //------------------------------------------------------------------------------
 bool SymbolicExecution::runOnFunction(Function &function) {
-  if (function.getName() != kernelName)
+  if (!isSelected(function))
     return false;
 
   loopInfo = &getAnalysis<LoopInfo>();
@@ -96,24 +186,124 @@ bool SymbolicExecution::runOnFunction(Function &function) {
   BlockMask blockMask(&function, cdGraph, scalarEvolution);
   blockMask.createMasks();
 
-  OCLEnv ocl(function, ndr);
-  subscriptAnalysis = new SubscriptAnalysis(scalarEvolution, std::move(ocl),
-                                            std::move(blockMask));
+  // Formulas are bound to the NDRange and to the hardware only when they are
+  // evaluated: any of them will do.
+  std::shared_ptr<const OCLEnv> ocl;
+  if (formulasOutput != nullptr)
+    ocl = std::make_shared<const OCLEnv>(function, ndr,
+                                         NDRangeSpace(1, 1, 1, 1, 1, 1),
+                                         HardwareConfig{1, 1, 1, 1});
+  else
+    ocl = std::make_shared<const OCLEnv>(function, ndr);
+  results.sampling = ocl->isNDRangeSampling();
+  // The pool is shared by all the kernels of the module.
+  if (threadPool == nullptr)
+    threadPool.reset(new ThreadPool(ocl->getThreadNumber()));
+
+  // Sweeps take the arguments from the config file, then evaluate the
+  // formulas of the kernel, compiled once. Formulas compiled for the caller
+  // are not swept.
+  if (formulasOutput == nullptr && isSweeping() &&
+      ocl->hasSymbolicArguments()) {
+    errs() << "The sweep needs the values of the kernel arguments\n";
+    exit(1);
+  }
+  bool evaluatesFormulas = formulasOutput == nullptr && isSweeping();
+  std::shared_ptr<const OCLEnv> configuration = ocl;
+  std::vector<int64_t> argumentValues;
+  if (evaluatesFormulas) {
+    for (Argument &argument : function.getArgumentList())
+      if (argument.getType()->isIntegerTy())
+        argumentValues.push_back(configuration->resolveValue(&argument));
+    ocl = std::make_shared<const OCLEnv>(function, ndr,
+                                         NDRangeSpace(1, 1, 1, 1, 1, 1),
+                                         configuration->getHWConfig());
+  }
+  symbolicArguments = ocl->hasSymbolicArguments();
+
+  // Each hardware profile is analyzed as the same hardware given alone in
+  // hardware_config.yaml would be: same warps, simulation mode and slices.
+  // The arguments and the NDRange do not change from one profile to the next:
+  // the accesses are compiled for the first profile only.
+  profileResults.profiles.clear();
+  if (formulasOutput == nullptr && !evaluatesFormulas && !symbolicArguments &&
+      !getHardwareProfiles().empty()) {
+    for (const HardwareProfile &profile : getHardwareProfiles()) {
+      if (profile.config.warpSize > LaneCoordinates::MAX_LANE_NUMBER) {
+        errs() << "Warp size of profile " << profile.name << " larger than "
+               << LaneCoordinates::MAX_LANE_NUMBER << " is not supported\n";
+        exit(1);
+      }
+      auto profileOcl =
+          std::make_shared<const OCLEnv>(function, ndr, profile.config);
+      if (profileResults.profiles.empty())
+        analyzeKernel(function, profileOcl, blockMask);
+      else
+        analyzeHardware(function, profileOcl);
+      profileResults.profiles.push_back(std::make_pair(profile.name, results));
+    }
+  } else {
+    analyzeKernel(function, ocl, blockMask);
+  }
 
-  initBuffers();
-  visit(function);
-  dump();
+  if (formulasOutput != nullptr) {
+    formulasOutput->formulas.push_back(formulas);
+  } else if (isSweeping()) {
+    sweep(argumentValues, configuration->getHWConfig());
+  } else if (!profileResults.profiles.empty()) {
+    if (isAnalyzingAllKernels())
+      moduleResults.profiles.push_back(
+          std::make_pair(function.getName().str(), profileResults));
+    else
+      dump();
+  } else if (!isAnalyzingAllKernels()) {
+    dump();
+  } else if (symbolicArguments) {
+    moduleResults.formulas.push_back(formulas);
+  } else {
+    moduleResults.kernels.push_back(
+        std::make_pair(function.getName().str(), results));
+  }
 
   return false;
 }
 
+//------------------------------------------------------------------------------
+bool SymbolicExecution::doFinalization(Module &) {
+  if (formulasOutput == nullptr && !isSweeping() && isAnalyzingAllKernels()) {
+    Output yout(llvm::outs());
+    yout << moduleResults;
+  }
+  return false;
+}
+
+//------------------------------------------------------------------------------
+int SymbolicExecution::getCompilationNumber() const {
+  return subscriptAnalysis != nullptr
+             ? subscriptAnalysis->getCompilationNumber()
+             : 0;
+}
+
 //------------------------------------------------------------------------------
 void SymbolicExecution::initBuffers() {
-  loadTransactions.clear();
-  storeTransactions.clear();
+  initResults();
+  accesses.clear();
+  formulas.accesses.clear();
+}
+
+//------------------------------------------------------------------------------
+void SymbolicExecution::initResults() {
+  results.loadTransactions.clear();
+  results.storeTransactions.clear();
+
+  results.loadBankConflicts.clear();
+  results.storeBankConflicts.clear();
+
+  results.loadTransactionsError.clear();
+  results.storeTransactionsError.clear();
 
-  loadBankConflicts.clear();
-  storeBankConflicts.clear();
+  results.loadBankConflictsError.clear();
+  results.storeBankConflictsError.clear();
 }
 
 //------------------------------------------------------------------------------
@@ -126,99 +316,196 @@ void SymbolicExecution::getAnalysisUsage(AnalysisUsage &au) const {
 }
 
 //------------------------------------------------------------------------------
-int SymbolicExecution::visitLocalMemoryInst(Instruction *inst, Value *pointer,
-                                            std::vector<int> &resultVector) {
-  int transactionNumber =
-      subscriptAnalysis->getBankConflictNumber(inst, pointer);
-  resultVector.push_back(transactionNumber);
-  return transactionNumber;
+// Visit the kernel with a new analysis of its accesses, then count them unless
+// the arguments are symbolic.
+void SymbolicExecution::analyzeKernel(Function &function,
+                                      std::shared_ptr<const OCLEnv> ocl,
+                                      const BlockMask &blockMask) {
+  delete subscriptAnalysis;
+  subscriptAnalysis = new SubscriptAnalysis(scalarEvolution, ocl,
+                                            BlockMask(blockMask), *threadPool);
+
+  initBuffers();
+  formulas.kernelName = function.getName();
+  visit(function);
+  // With symbolic arguments the formulas are dumped instead of the counts.
+  if (!symbolicArguments)
+    analyzeAccesses(function, *ocl);
+}
+
+//------------------------------------------------------------------------------
+// Count the accesses of the kernel visited last on the hardware of ocl,
+// without compiling them again.
+void SymbolicExecution::analyzeHardware(Function &function,
+                                        std::shared_ptr<const OCLEnv> ocl) {
+  subscriptAnalysis->setHardware(ocl);
+  initResults();
+  analyzeAccesses(function, *ocl);
+}
+
+//------------------------------------------------------------------------------
+// Record the access; with symbolic arguments, compile its formula.
+void SymbolicExecution::visitPointer(Instruction *inst, Value *pointer,
+                                     bool isLoad) {
+  const GetElementPtrInst *gep = dyn_cast<GetElementPtrInst>(pointer);
+  if (gep == nullptr)
+    return;
+
+  const SCEV *tripCount = nullptr;
+  if (loopMultiplier)
+    if (Loop *loop = loopInfo->getLoopFor(inst->getParent()))
+      tripCount = scalarEvolution->getBackedgeTakenCount(loop);
+
+  MemoryAccess access = {inst, pointer, isLoad,
+                         gep->getPointerAddressSpace() == OCLEnv::LOCAL_AS,
+                         tripCount};
+  if (symbolicArguments) {
+    AccessFormula formula =
+        subscriptAnalysis->getAccessFormula(inst, pointer, tripCount);
+    formula.isLoad = access.isLoad;
+    formula.isLocal = access.isLocal;
+    formulas.accesses.push_back(formula);
+    return;
+  }
+
+  accesses.push_back(access);
 }
 
 //------------------------------------------------------------------------------
-int
-SymbolicExecution::visitLocalMemoryInstInLoop(Instruction *inst, Value *pointer,
-                                              std::vector<int> &resultVector,
-                                              Loop *loop) {
-  if(!loopMultiplier)
-    return visitLocalMemoryInst(inst, pointer, resultVector);
+int SymbolicExecution::countAccess(const MemoryAccess &access) {
+  if (access.isLocal) {
+    if (access.tripCount != nullptr)
+      return subscriptAnalysis->getBankConflictNumberInLoop(
+          access.inst, access.pointer, access.tripCount);
+    return subscriptAnalysis->getBankConflictNumber(access.inst,
+                                                    access.pointer);
+  }
 
-  const SCEV *tripCount = scalarEvolution->getBackedgeTakenCount(loop);
-  int transactionNumber =
-      subscriptAnalysis->getBankConflictNumberInLoop(inst, pointer, tripCount);
-  resultVector.push_back(transactionNumber);
-  return transactionNumber;
+  if (access.tripCount != nullptr)
+    return subscriptAnalysis->getTransactionNumberInLoop(
+        access.inst, access.pointer, access.tripCount);
+  return subscriptAnalysis->getTransactionNumber(access.inst, access.pointer);
 }
 
 //------------------------------------------------------------------------------
-int SymbolicExecution::visitMemoryInst(Instruction *inst, Value *pointer,
-                                       std::vector<int> &resultVector) {
-  int transactionNumber =
-      subscriptAnalysis->getTransactionNumber(inst, pointer);
-  resultVector.push_back(transactionNumber);
-  return transactionNumber;
+// Kernels cached by a previous run are neither compiled nor simulated.
+void SymbolicExecution::analyzeAccesses(Function &function,
+                                        const OCLEnv &ocl) {
+  const ResultCache *cache = getResultCache();
+  std::string key;
+  std::vector<int> counts;
+  std::vector<int> errors;
+  if (cache != nullptr) {
+    key = getCacheKey(function, ocl);
+    if (cache->lookup(key, accesses.size(), counts, errors)) {
+      recordResults(counts, errors);
+      return;
+    }
+  }
+
+  countAccesses(counts, errors);
+  if (cache != nullptr)
+    cache->store(key, counts, errors);
+  recordResults(counts, errors);
 }
 
 //------------------------------------------------------------------------------
-int SymbolicExecution::visitMemoryInstInLoop(Instruction *inst, Value *pointer,
-                                             std::vector<int> &resultVector,
-                                             Loop *loop) {
-  if(!loopMultiplier)
-    return visitMemoryInst(inst, pointer, resultVector);
+void SymbolicExecution::countAccesses(std::vector<int> &counts,
+                                      std::vector<int> &errors) {
+  // ScalarEvolution is not thread safe: all the work that needs it is done
+  // first, in the order of the visit.
+  for (const MemoryAccess &access : accesses)
+    subscriptAnalysis->prepareAccess(access.inst, access.pointer,
+                                     access.tripCount);
+
+  // The accesses of a block share the active masks of the warps: blocks are
+  // analyzed in parallel, the accesses of each block one after the other.
+  std::vector<std::vector<size_t>> blocks;
+  std::map<BasicBlock *, size_t> blockIndices;
+  for (size_t index = 0; index < accesses.size(); ++index) {
+    BasicBlock *block = accesses[index].inst->getParent();
+    auto iter = blockIndices.insert(std::make_pair(block, blocks.size())).first;
+    if (iter->second == blocks.size())
+      blocks.emplace_back();
+    blocks[iter->second].push_back(index);
+  }
 
-  const SCEV *tripCount = scalarEvolution->getBackedgeTakenCount(loop);
-  int transactionNumber =
-      subscriptAnalysis->getTransactionNumberInLoop(inst, pointer, tripCount);
-  resultVector.push_back(transactionNumber);
-  return transactionNumber;
+  counts.assign(accesses.size(), 0);
+  errors.assign(accesses.size(), 0);
+  threadPool->parallelFor(blocks.size(), [&](size_t block) {
+    for (size_t index : blocks[block]) {
+      counts[index] = countAccess(accesses[index]);
+      errors[index] =
+          subscriptAnalysis->getConfidenceInterval(accesses[index].inst);
+    }
+  });
 }
 
 //------------------------------------------------------------------------------
-void SymbolicExecution::visitPointer(Instruction *inst, Value *pointer,
-                                     std::vector<int> &bankConflicts,
-                                     std::vector<int> &transactions) {
-  if (const GetElementPtrInst *gep = dyn_cast<GetElementPtrInst>(pointer)) {
-    if (gep->getPointerAddressSpace() == OCLEnv::LOCAL_AS) {
-      // Local memory instruction.
-      int conflictNumber = 0;
-      if (Loop *loop = loopInfo->getLoopFor(inst->getParent())) {
-        conflictNumber =
-            visitLocalMemoryInstInLoop(inst, pointer, bankConflicts, loop);
-      } else {
-        conflictNumber = visitLocalMemoryInst(inst, pointer, bankConflicts);
-      }
-      addConflictMetadata(inst, conflictNumber);
+// Results are stored in the order of the visit, whatever the scheduling.
+void SymbolicExecution::recordResults(const std::vector<int> &counts,
+                                      const std::vector<int> &errors) {
+  for (size_t index = 0; index < accesses.size(); ++index) {
+    const MemoryAccess &access = accesses[index];
+    if (access.isLocal) {
+      auto &counters = access.isLoad ? results.loadBankConflicts
+                                     : results.storeBankConflicts;
+      auto &resultErrors = access.isLoad ? results.loadBankConflictsError
+                                         : results.storeBankConflictsError;
+      counters.push_back(counts[index]);
+      resultErrors.push_back(errors[index]);
+      addConflictMetadata(access.inst, counts[index]);
     } else {
-      // Global memory instruction.
-      int transactionNumber = 0;
-      if (Loop *loop = loopInfo->getLoopFor(inst->getParent())) {
-        transactionNumber =
-            visitMemoryInstInLoop(inst, pointer, transactions, loop);
-      } else {
-        transactionNumber = visitMemoryInst(inst, pointer, transactions);
-      }
-      addTransactionMetadata(inst, transactionNumber);
+      auto &counters = access.isLoad ? results.loadTransactions
+                                     : results.storeTransactions;
+      auto &resultErrors = access.isLoad ? results.loadTransactionsError
+                                         : results.storeTransactionsError;
+      counters.push_back(counts[index]);
+      resultErrors.push_back(errors[index]);
+      addTransactionMetadata(access.inst, counts[index]);
     }
   }
 }
 
+//------------------------------------------------------------------------------
+// One table for each hardware profile.
+void SymbolicExecution::sweep(const std::vector<int64_t> &arguments,
+                              const HardwareConfig &hwConfig) {
+  std::vector<HardwareProfile> profiles = getHardwareProfiles();
+  if (profiles.empty())
+    profiles.push_back({"", hwConfig});
+
+  for (const HardwareProfile &profile : profiles) {
+    std::vector<SweepCandidate> candidates =
+        createSweepCandidates(getSweepConfig());
+    evaluateSweep(formulas, arguments, profile.config, *threadPool,
+                  candidates);
+    std::string title = formulas.kernelName;
+    if (!profile.name.empty())
+      title += " on " + profile.name;
+    printSweepTable(title, candidates, outs());
+  }
+}
+
 //------------------------------------------------------------------------------
 void SymbolicExecution::visitStoreInst(StoreInst &storeInst) {
-  Instruction *inst = &storeInst;
-  Value *pointer = storeInst.getOperand(1);
-  visitPointer(inst, pointer, storeBankConflicts, storeTransactions);
+  visitPointer(&storeInst, storeInst.getOperand(1), false);
 }
 
 //------------------------------------------------------------------------------
 void SymbolicExecution::visitLoadInst(LoadInst &loadInst) {
-  Instruction *inst = &loadInst;
-  Value *pointer = loadInst.getOperand(0);
-  visitPointer(inst, pointer, loadBankConflicts, loadTransactions);
+  visitPointer(&loadInst, loadInst.getOperand(0), true);
 }
 
 //------------------------------------------------------------------------------
 void SymbolicExecution::dump() {
   Output yout(llvm::outs());
-  yout << *this;
+  if (!profileResults.profiles.empty())
+    yout << profileResults;
+  else if (symbolicArguments)
+    yout << formulas;
+  else
+    yout << results;
 }
 
 //------------------------------------------------------------------------------
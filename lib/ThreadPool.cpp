@@ -0,0 +1,157 @@
+#include "SymEngine/ThreadPool.h"
+
+#include <algorithm>
+
+using namespace SymEngine;
+
+// Number of ranges a loop is split into for each thread, to balance the load
+// when the iterations have different costs.
+static const size_t RANGES_PER_THREAD = 8;
+
+// Pool and queue of the worker running on the current thread.
+static thread_local const ThreadPool *currentPool = nullptr;
+static thread_local unsigned int currentQueue = 0;
+
+//------------------------------------------------------------------------------
+ThreadPool::ThreadPool(unsigned int threadNumber)
+    : queuedRanges(0), sleepingWorkers(0), stopping(false) {
+  if (threadNumber == 0)
+    threadNumber = std::max(1u, std::thread::hardware_concurrency());
+
+  for (unsigned int index = 0; index < threadNumber; ++index)
+    queues.push_back(std::unique_ptr<Queue>(new Queue()));
+
+  // The calling thread is one of the threads of the pool.
+  for (unsigned int index = 1; index < threadNumber; ++index)
+    workers.push_back(std::thread(&ThreadPool::workerLoop, this, index));
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  wakeUp.notify_all();
+  for (auto &worker : workers)
+    worker.join();
+}
+
+//------------------------------------------------------------------------------
+unsigned int ThreadPool::getThreadNumber() const { return workers.size() + 1; }
+
+//------------------------------------------------------------------------------
+unsigned int ThreadPool::getQueueIndex() const {
+  return currentPool == this ? currentQueue : 0;
+}
+
+//------------------------------------------------------------------------------
+void ThreadPool::parallelFor(size_t count,
+                             const std::function<void(size_t)> &body) {
+  if (workers.empty() || count <= 1) {
+    for (size_t index = 0; index < count; ++index)
+      body(index);
+    return;
+  }
+
+  Loop loop;
+  loop.body = &body;
+  loop.grain = std::max<size_t>(
+      1, count / (getThreadNumber() * RANGES_PER_THREAD));
+  loop.remaining = count;
+
+  unsigned int queueIndex = getQueueIndex();
+  Range range = {&loop, 0, count};
+  push(queueIndex, range);
+
+  // Help with any loop until all the iterations of this one are done.
+  while (loop.remaining != 0)
+    if (!runRange(queueIndex))
+      std::this_thread::yield();
+}
+
+//------------------------------------------------------------------------------
+void ThreadPool::push(unsigned int queueIndex, const Range &range) {
+  // Count the range before queueing it, so that a worker that sees no queued
+  // ranges really has nothing to steal.
+  ++queuedRanges;
+  {
+    Queue &queue = *queues[queueIndex];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    queue.ranges.push_back(range);
+  }
+
+  if (sleepingWorkers != 0) {
+    { std::lock_guard<std::mutex> lock(mutex); }
+    wakeUp.notify_one();
+  }
+}
+
+//------------------------------------------------------------------------------
+// The owner takes the last range queued: the smallest and the most recent.
+bool ThreadPool::pop(unsigned int queueIndex, Range &range) {
+  Queue &queue = *queues[queueIndex];
+  std::lock_guard<std::mutex> lock(queue.mutex);
+  if (queue.ranges.empty())
+    return false;
+  range = queue.ranges.back();
+  queue.ranges.pop_back();
+  --queuedRanges;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Thieves take the first range queued: the largest one.
+bool ThreadPool::steal(unsigned int queueIndex, Range &range) {
+  for (size_t offset = 1; offset < queues.size(); ++offset) {
+    Queue &queue = *queues[(queueIndex + offset) % queues.size()];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.ranges.empty())
+      continue;
+    range = queue.ranges.front();
+    queue.ranges.pop_front();
+    --queuedRanges;
+    return true;
+  }
+  return false;
+}
+
+//------------------------------------------------------------------------------
+bool ThreadPool::runRange(unsigned int queueIndex) {
+  Range range;
+  if (!pop(queueIndex, range) && !steal(queueIndex, range))
+    return false;
+
+  // Keep the first half of the range and leave the second one to the other
+  // threads, until the range is small enough.
+  Loop *loop = range.loop;
+  while (range.end - range.begin > loop->grain) {
+    size_t middle = range.begin + (range.end - range.begin) / 2;
+    Range second = {loop, middle, range.end};
+    push(queueIndex, second);
+    range.end = middle;
+  }
+
+  for (size_t index = range.begin; index < range.end; ++index)
+    (*loop->body)(index);
+  // The loop can be destroyed as soon as remaining drops to 0.
+  loop->remaining -= range.end - range.begin;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+void ThreadPool::workerLoop(unsigned int queueIndex) {
+  currentPool = this;
+  currentQueue = queueIndex;
+
+  while (true) {
+    if (runRange(queueIndex))
+      continue;
+
+    std::unique_lock<std::mutex> lock(mutex);
+    ++sleepingWorkers;
+    wakeUp.wait(lock, [this]() { return stopping || queuedRanges != 0; });
+    --sleepingWorkers;
+    if (stopping)
+      return;
+  }
+}
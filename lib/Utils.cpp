@@ -68,6 +68,24 @@ bool isOpenCLIntCast(Instruction *inst) {
   return false;
 }
 
+// -----------------------------------------------------------------------------
+bool isKernel(const Function &function) {
+  if (function.getCallingConv() == CallingConv::SPIR_KERNEL)
+    return true;
+
+  const NamedMDNode *kernels =
+      function.getParent()->getNamedMetadata("opencl.kernels");
+  if (kernels == nullptr)
+    return false;
+
+  for (const MDNode *kernel : kernels->operands())
+    if (kernel->getNumOperands() > 0 &&
+        mdconst::dyn_extract_or_null<Function>(kernel->getOperand(0)) ==
+            &function)
+      return true;
+  return false;
+}
+
 // -----------------------------------------------------------------------------
 std::string readStream(std::ifstream &fileStream) {
   std::string text;
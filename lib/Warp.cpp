@@ -2,56 +2,56 @@
 
 #include "SymEngine/OCLEnv.h"
 
-#include <iostream>
-
 using namespace SymEngine;
 
-Warp::Warp() {}
+Warp::Warp() : group{0, 0, 0}, warpIndex(0), ndrSpace(nullptr), warpSize(0) {}
 
 Warp::Warp(int groupX, int groupY, int groupZ, int warpIndex,
-           const NDRangeSpace *ndrSpace, int warpSize) {
-
-  points.reserve(warpSize);
+           const NDRangeSpace *ndrSpace, int warpSize)
+    : group{groupX, groupY, groupZ}, warpIndex(warpIndex), ndrSpace(ndrSpace),
+      warpSize(warpSize) {}
+
+int Warp::getGroupX() const { return group[0]; }
+int Warp::getGroupY() const { return group[1]; }
+int Warp::getGroupZ() const { return group[2]; }
+int Warp::getWarpIndex() const { return warpIndex; }
+int Warp::getLaneNumber() const { return warpSize; }
+
+int Warp::getShape() const {
+  // Local coordinates relative to the first lane only depend on the position
+  // of the first lane in its xy-plane of the group.
+  int localArea = ndrSpace->getLocalSizeX() * ndrSpace->getLocalSizeY();
+  return (warpIndex * warpSize) % localArea;
+}
 
+NDRangePoint Warp::getPoint(int lane) const {
   int localSizeX = ndrSpace->getLocalSizeX();
   int localSizeY = ndrSpace->getLocalSizeY();
   int localArea = localSizeX * localSizeY;
 
-  int firstThreadLocalPosition = warpIndex * warpSize;
+  int threadPosition = warpIndex * warpSize + lane;
 
-  for (int index = 0; index < warpSize; ++index) {
-    int threadPosition = firstThreadLocalPosition + index;
+  // Compute local coordinates of the thread in the group.
+  int localZ = threadPosition / localArea;
+  int tmpPosition = threadPosition % localArea;
+  int localY = tmpPosition / localSizeX;
+  int localX = tmpPosition % localSizeX;
 
-    // Compute local coordinates of the first warp in the
-    int localZ = threadPosition / localArea;
-    int tmpPosition = threadPosition % localArea;
-    int localY = tmpPosition / localSizeX;
-    int localX = tmpPosition % localSizeX;
-
-    NDRangePoint point(localX, localY, localZ, groupX, groupY, groupZ,
-                       ndrSpace);
-    points.push_back(point);
-  }
+  return NDRangePoint(localX, localY, localZ, group[0], group[1], group[2],
+                      ndrSpace);
 }
 
-Warp::iterator Warp::begin() const { return Warp::iterator(this); }
+Warp::iterator Warp::begin() const { return Warp::iterator(this, 0); }
 
-Warp::iterator Warp::end() const { return Warp::iterator::end(); }
+Warp::iterator Warp::end() const { return Warp::iterator(this, warpSize); }
 
 //-----------------------------------------------------------------------------
-Warp::iterator::iterator() { currentPoint = 0; }
-Warp::iterator::iterator(const Warp *warp) {
-  points = warp->points;
-  currentPoint = (points.size() == 0) ? -1 : 0;
-}
-Warp::iterator::iterator(const iterator &original) {
-  this->points = original.points;
-  this->currentPoint = original.currentPoint;
-}
+Warp::iterator::iterator() : warp(nullptr), lane(0) {}
+Warp::iterator::iterator(const Warp *warp, int lane) : warp(warp), lane(lane) {}
 
 // Pre-increment.
 Warp::iterator &Warp::iterator::operator++() {
-  toNext();
+  ++lane;
   return *this;
 }
 // Post-increment.
@@ -61,23 +61,14 @@ Warp::iterator Warp::iterator::operator++(int) {
   return old;
 }
 
-NDRangePoint Warp::iterator::operator*() const {
-  return points.at(currentPoint);
-}
-bool Warp::iterator::operator!=(const iterator &iter) const {
-  return iter.currentPoint != this->currentPoint;
-}
+NDRangePoint Warp::iterator::operator*() const { return warp->getPoint(lane); }
 
-void Warp::iterator::toNext() {
-  ++currentPoint;
-  if (currentPoint == points.size())
-    currentPoint = -1;
+bool Warp::iterator::operator!=(const iterator &iter) const {
+  return !(*this == iter);
 }
 
-Warp::iterator Warp::iterator::end() {
-  iterator endIterator;
-  endIterator.currentPoint = -1;
-  return endIterator;
+bool Warp::iterator::operator==(const iterator &iter) const {
+  return warp == iter.warp && lane == iter.lane;
 }
 
 //------------------------------------------------------------------------------
@@ -89,11 +80,15 @@ Warp WarpFactory::createWarp(int groupX, int groupY, int groupZ,
   return Warp(groupX, groupY, groupZ, warpIndex, ndrSpace, warpSize);
 }
 
-std::vector<Warp>
-WarpFactory::createAllWarpsInGroup(int groupX, int groupY, int groupZ) const {
+int WarpFactory::getWarpsInGroup() const {
   int groupSize = ndrSpace->getLocalSizeX() * ndrSpace->getLocalSizeY() *
                   ndrSpace->getLocalSizeZ();
-  int warpsInGroup = groupSize / warpSize;
+  return groupSize / warpSize;
+}
+
+std::vector<Warp>
+WarpFactory::createAllWarpsInGroup(int groupX, int groupY, int groupZ) const {
+  int warpsInGroup = getWarpsInGroup();
 
   std::vector<Warp> result;
   result.reserve(warpsInGroup);
@@ -0,0 +1,320 @@
+#include "SymEngine/WarpEvaluator.h"
+
+#include "SymEngine/NDRangePoint.h"
+#include "SymEngine/Warp.h"
+
+#include "llvm/ADT/SmallVector.h"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE4_1__)
+#include <smmintrin.h>
+#endif
+
+using namespace llvm;
+using namespace SymEngine;
+
+//------------------------------------------------------------------------------
+LaneCoordinates::LaneCoordinates() : laneNumber(0) {
+  std::fill(uniform, uniform + AffineForm::COORDINATE_NUMBER, true);
+  std::fill(linear, linear + AffineForm::COORDINATE_NUMBER, true);
+  std::fill(steps, steps + AffineForm::COORDINATE_NUMBER, 0);
+}
+
+LaneCoordinates::LaneCoordinates(const Warp &warp)
+    : laneNumber(warp.getLaneNumber()) {
+  assert(laneNumber <= MAX_LANE_NUMBER && "Warp is too large");
+  for (int lane = 0; lane < laneNumber; ++lane) {
+    NDRangePoint point = warp.getPoint(lane);
+    for (int direction = 0; direction < 3; ++direction) {
+      values[direction][lane] = point.getLocal(direction);
+      values[3 + direction][lane] = point.getGlobal(direction);
+      values[6 + direction][lane] = point.getGroup(direction);
+    }
+  }
+
+  for (int index = 0; index < AffineForm::COORDINATE_NUMBER; ++index) {
+    const int32_t *coordinates = values[index];
+    int32_t step = laneNumber > 1 ? coordinates[1] - coordinates[0] : 0;
+    linear[index] = true;
+    for (int lane = 1; lane < laneNumber && linear[index]; ++lane)
+      linear[index] = coordinates[lane] == coordinates[0] + step * lane;
+    uniform[index] = linear[index] && step == 0;
+    steps[index] = linear[index] ? step : 0;
+  }
+}
+
+//------------------------------------------------------------------------------
+// results[lane] += coefficient * coordinates[lane] for all the lanes.
+static void multiplyAccumulate(int64_t coefficient, const int32_t *coordinates,
+                               int laneNumber, int64_t *results) {
+  int lane = 0;
+
+#if defined(__AVX2__) || defined(__SSE4_1__)
+  // The SIMD multiplications take 32-bit signed operands.
+  bool fitsInt32 = coefficient >= std::numeric_limits<int32_t>::min() &&
+                   coefficient <= std::numeric_limits<int32_t>::max();
+  if (fitsInt32) {
+#if defined(__AVX2__)
+    __m256i factor = _mm256_set1_epi64x(coefficient);
+    for (; lane + 4 <= laneNumber; lane += 4) {
+      __m256i coordinate = _mm256_cvtepi32_epi64(_mm_loadu_si128(
+          reinterpret_cast<const __m128i *>(coordinates + lane)));
+      __m256i *result = reinterpret_cast<__m256i *>(results + lane);
+      __m256i accumulator = _mm256_loadu_si256(result);
+      accumulator = _mm256_add_epi64(accumulator,
+                                     _mm256_mul_epi32(coordinate, factor));
+      _mm256_storeu_si256(result, accumulator);
+    }
+#else
+    __m128i factor = _mm_set1_epi64x(coefficient);
+    for (; lane + 2 <= laneNumber; lane += 2) {
+      __m128i coordinate = _mm_cvtepi32_epi64(_mm_loadl_epi64(
+          reinterpret_cast<const __m128i *>(coordinates + lane)));
+      __m128i *result = reinterpret_cast<__m128i *>(results + lane);
+      __m128i accumulator = _mm_loadu_si128(result);
+      accumulator =
+          _mm_add_epi64(accumulator, _mm_mul_epi32(coordinate, factor));
+      _mm_storeu_si128(result, accumulator);
+    }
+#endif
+  }
+#endif
+
+  // Scalar fallback and remainder.
+  for (; lane < laneNumber; ++lane)
+    results[lane] += coefficient * coordinates[lane];
+}
+
+//------------------------------------------------------------------------------
+static void evaluateAffine(const AffineForm &form, const LaneCoordinates &lanes,
+                           int64_t *results) {
+  std::fill(results, results + lanes.laneNumber, form.constant);
+  for (int index = 0; index < AffineForm::COORDINATE_NUMBER; ++index) {
+    if (form.coefficients[index] == 0)
+      continue;
+    multiplyAccumulate(form.coefficients[index], lanes.values[index],
+                       lanes.laneNumber, results);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Stacks of the warp interpreter. Each thread keeps its own and reuses it for
+// all the warps it evaluates: once it has grown to fit the deepest expression
+// evaluating a warp does not allocate any more.
+namespace {
+struct EvaluationScratch {
+  std::vector<int64_t> stack;
+  std::vector<char> uniform;
+  std::vector<int64_t> operands;
+};
+}
+
+static thread_local EvaluationScratch scratch;
+
+//------------------------------------------------------------------------------
+// Interpret the expression keeping on the stack one value per lane.
+// Values that are the same for all the lanes (constants, uniform coordinates
+// and operations on them) are computed only once, in the first slot of their
+// stack entry.
+// Returns false if the operation fails for any of the lanes.
+static bool evaluatePiecewise(const CompiledExpression &expression,
+                              const LaneCoordinates &lanes, int64_t *results) {
+  const int laneNumber = lanes.laneNumber;
+  std::vector<int64_t> &stack = scratch.stack;
+  std::vector<char> &uniform = scratch.uniform;
+  std::vector<int64_t> &operands = scratch.operands;
+  stack.clear();
+  uniform.clear();
+
+  for (const CompiledExpression::Node &node : expression.getNodes()) {
+    size_t top = stack.size();
+
+    if (node.opCode == CompiledExpression::CONSTANT) {
+      stack.resize(top + laneNumber);
+      stack[top] = node.value;
+      uniform.push_back(true);
+      continue;
+    }
+
+    if (CompiledExpression::isCoordinate(node.opCode)) {
+      int index =
+          CompiledExpression::getCoordinateIndex(node.opCode, node.value);
+      const int32_t *coordinates = lanes.values[index];
+      if (lanes.uniform[index]) {
+        stack.resize(top + laneNumber);
+        stack[top] = coordinates[0];
+      } else {
+        stack.insert(stack.end(), coordinates, coordinates + laneNumber);
+      }
+      uniform.push_back(lanes.uniform[index]);
+      continue;
+    }
+
+    // Sizes must have been bound.
+    if (CompiledExpression::isSize(node.opCode))
+      return false;
+
+    int operandNumber = node.value;
+    int64_t *first = stack.data() + stack.size() - operandNumber * laneNumber;
+    char *firstUniform = uniform.data() + uniform.size() - operandNumber;
+
+    // Lane-invariant operation: compute it once.
+    if (std::all_of(firstUniform, uniform.data() + uniform.size(),
+                    [](char isUniform) { return isUniform; })) {
+      operands.clear();
+      for (int operand = 0; operand < operandNumber; ++operand)
+        operands.push_back(first[operand * laneNumber]);
+      if (!CompiledExpression::applyOperation(node.opCode, operands.data(),
+                                              operandNumber, first[0]))
+        return false;
+      stack.resize(stack.size() - (operandNumber - 1) * laneNumber);
+      uniform.resize(uniform.size() - (operandNumber - 1));
+      continue;
+    }
+
+    // Broadcast the uniform operands, the result varies across the lanes.
+    for (int operand = 0; operand < operandNumber; ++operand) {
+      if (!firstUniform[operand])
+        continue;
+      int64_t *values = first + operand * laneNumber;
+      std::fill(values + 1, values + laneNumber, values[0]);
+    }
+
+    switch (node.opCode) {
+    case CompiledExpression::ADD:
+      for (int operand = 1; operand < operandNumber; ++operand)
+        for (int lane = 0; lane < laneNumber; ++lane)
+          first[lane] += first[operand * laneNumber + lane];
+      break;
+    case CompiledExpression::MUL:
+      for (int operand = 1; operand < operandNumber; ++operand)
+        for (int lane = 0; lane < laneNumber; ++lane)
+          first[lane] *= first[operand * laneNumber + lane];
+      break;
+    case CompiledExpression::SMAX:
+      for (int operand = 1; operand < operandNumber; ++operand)
+        for (int lane = 0; lane < laneNumber; ++lane)
+          first[lane] = std::max(first[lane], first[operand * laneNumber + lane]);
+      break;
+    default:
+      // Division, remainder and unsigned max go through the scalar operation.
+      for (int lane = 0; lane < laneNumber; ++lane) {
+        operands.clear();
+        for (int operand = 0; operand < operandNumber; ++operand)
+          operands.push_back(first[operand * laneNumber + lane]);
+        if (!CompiledExpression::applyOperation(node.opCode, operands.data(),
+                                                operandNumber, first[lane]))
+          return false;
+      }
+    }
+
+    stack.resize(stack.size() - (operandNumber - 1) * laneNumber);
+    uniform.resize(uniform.size() - operandNumber);
+    uniform.push_back(false);
+  }
+
+  assert(stack.size() == static_cast<size_t>(laneNumber) &&
+         "Malformed expression");
+  if (uniform.back())
+    std::fill(results, results + laneNumber, stack[0]);
+  else
+    std::copy(stack.begin(), stack.end(), results);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Interpret the expression for a single lane.
+static bool evaluateLane(const CompiledExpression &expression,
+                         const LaneCoordinates &lanes, int lane,
+                         int64_t &result) {
+  SmallVector<int64_t, 16> stack;
+  for (const CompiledExpression::Node &node : expression.getNodes()) {
+    if (node.opCode == CompiledExpression::CONSTANT) {
+      stack.push_back(node.value);
+      continue;
+    }
+
+    if (CompiledExpression::isCoordinate(node.opCode)) {
+      int index =
+          CompiledExpression::getCoordinateIndex(node.opCode, node.value);
+      stack.push_back(lanes.values[index][lane]);
+      continue;
+    }
+
+    if (CompiledExpression::isSize(node.opCode))
+      return false;
+
+    int operandNumber = node.value;
+    int64_t value = 0;
+    if (!CompiledExpression::applyOperation(
+            node.opCode, stack.end() - operandNumber, operandNumber, value))
+      return false;
+    stack.resize(stack.size() - operandNumber);
+    stack.push_back(value);
+  }
+
+  result = stack.back();
+  return true;
+}
+
+//------------------------------------------------------------------------------
+bool SymEngine::evaluateForWarp(const CompiledExpression &expression,
+                                const LaneCoordinates &lanes, int64_t *results,
+                                bool *valid) {
+  const int laneNumber = lanes.laneNumber;
+
+  if (!expression.isComputable()) {
+    std::fill(valid, valid + laneNumber, false);
+    return false;
+  }
+
+  if (laneNumber == 0)
+    return true;
+
+  if (expression.isAffine()) {
+    evaluateAffine(expression.getAffineForm(), lanes, results);
+    std::fill(valid, valid + laneNumber, true);
+    return true;
+  }
+
+  if (evaluatePiecewise(expression, lanes, results)) {
+    std::fill(valid, valid + laneNumber, true);
+    return true;
+  }
+
+  // Some lane failed (division by zero): find out which one.
+  bool allValid = true;
+  for (int lane = 0; lane < laneNumber; ++lane) {
+    valid[lane] = evaluateLane(expression, lanes, lane, results[lane]);
+    allValid &= valid[lane];
+  }
+  return allValid;
+}
+
+//------------------------------------------------------------------------------
+bool SymEngine::getLaneStride(const CompiledExpression &expression,
+                              const LaneCoordinates &lanes, int64_t &base,
+                              int64_t &stride) {
+  if (!expression.isComputable() || !expression.isAffine())
+    return false;
+
+  const AffineForm &form = expression.getAffineForm();
+  base = form.constant;
+  stride = 0;
+  for (int index = 0; index < AffineForm::COORDINATE_NUMBER; ++index) {
+    int64_t coefficient = form.coefficients[index];
+    if (coefficient == 0)
+      continue;
+    if (!lanes.linear[index])
+      return false;
+    base += coefficient * lanes.values[index][0];
+    stride += coefficient * lanes.steps[index];
+  }
+  return true;
+}
@@ -0,0 +1,511 @@
+#include "SymEngine/WarpSimulator.h"
+
+#include "SymEngine/BlockMask.h"
+#include "SymEngine/GroupRegions.h"
+#include "SymEngine/MemoryAccessesAnalyzer.h"
+#include "SymEngine/NDRangeSpace.h"
+#include "SymEngine/OCLEnv.h"
+#include "SymEngine/ThreadPool.h"
+#include "SymEngine/WarpEvaluator.h"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <numeric>
+
+using namespace SymEngine;
+
+const WarpSimulator::AccessCounter WarpSimulator::TRANSACTIONS = {
+    computeTransactionNumbers, computeStridedTransactionNumber};
+const WarpSimulator::AccessCounter WarpSimulator::BANK_CONFLICTS = {
+    computeBankConflictNumbers, computeStridedBankConflictNumber};
+
+//------------------------------------------------------------------------------
+void WarpSimulator::ActiveMasks::reset() { masks.clear(); }
+
+void WarpSimulator::ActiveMasks::addWarp(int warpId) {
+  masks.insert(std::make_pair(warpId, Mask{0, false}));
+}
+
+//------------------------------------------------------------------------------
+// Counts of the whole NDRange are summed on 64 bits: those too large for the
+// results are clamped to the largest int.
+static int saturateCount(int64_t count) {
+  return static_cast<int>(
+      std::min<int64_t>(count, std::numeric_limits<int>::max()));
+}
+
+//------------------------------------------------------------------------------
+WarpSimulator::WarpSimulator(const NDRangeSpace *ndrSpace,
+                             const HardwareConfig &hwConfig,
+                             ThreadPool &threadPool)
+    : ndrSpace(ndrSpace), hwConfig(hwConfig),
+      warpFactory(ndrSpace, hwConfig.warpSize), threadPool(threadPool) {}
+
+//------------------------------------------------------------------------------
+int WarpSimulator::getWarpsPerGroup() const {
+  return ndrSpace->getGroupSize() / hwConfig.warpSize;
+}
+
+//------------------------------------------------------------------------------
+int WarpSimulator::getWarpId(int groupX, int groupY, int groupZ,
+                             int warpIndex) const {
+  int groupIndex = (groupZ * ndrSpace->getNumberOfGroupsY() + groupY) *
+                       ndrSpace->getNumberOfGroupsX() +
+                   groupX;
+  return groupIndex * getWarpsPerGroup() + warpIndex;
+}
+
+//------------------------------------------------------------------------------
+int WarpSimulator::countAccesses(
+    const std::vector<Warp> &warps, const CompiledExpression &subscript,
+    const std::vector<CompiledCondition> &blockConditions, ActiveMasks &masks,
+    AccessCounter counter) const {
+  // Batch consecutive warps of the same group. All the warps usually belong
+  // to the same group.
+  std::vector<size_t> batchBegins;
+  size_t warpId = 0;
+  while (warpId < warps.size()) {
+    const Warp &first = warps[warpId];
+    batchBegins.push_back(warpId);
+    int warpNumber = 0;
+    while (warpId < warps.size() && warpNumber < WARP_BATCH_SIZE &&
+           warps[warpId].getGroupX() == first.getGroupX() &&
+           warps[warpId].getGroupY() == first.getGroupY() &&
+           warps[warpId].getGroupZ() == first.getGroupZ())
+      ++warpId, ++warpNumber;
+  }
+  batchBegins.push_back(warps.size());
+  for (size_t warpId = 0; warpId < warps.size(); ++warpId)
+    masks.addWarp(warpId);
+
+  // Every batch writes its own slot, so the result does not depend on the
+  // scheduling of the batches.
+  std::vector<int> batchResults(batchBegins.size() - 1, 0);
+  threadPool.parallelFor(batchResults.size(), [&](size_t batch) {
+    // Specialize the subscript and the conditions to the group of the warps.
+    const Warp &first = warps[batchBegins[batch]];
+    GroupAccess access =
+        specializeForGroup(subscript, blockConditions, first.getGroupX(),
+                           first.getGroupY(), first.getGroupZ());
+
+    int warpIds[WARP_BATCH_SIZE];
+    int warpNumber = batchBegins[batch + 1] - batchBegins[batch];
+    std::iota(warpIds, warpIds + warpNumber, batchBegins[batch]);
+
+    WarpClasses classes(getTranslationPeriod(hwConfig));
+    int results[WARP_BATCH_SIZE];
+    countAccessesInWarps(access.subscript, access.blockConditions, &first,
+                         warpIds, warpNumber, masks, counter, classes,
+                         results);
+    batchResults[batch] = std::accumulate(results, results + warpNumber, 0);
+  });
+
+  return std::accumulate(batchResults.begin(), batchResults.end(), 0);
+}
+
+//------------------------------------------------------------------------------
+int WarpSimulator::countAccessesInNDRange(
+    const CompiledExpression &subscript,
+    const std::vector<CompiledCondition> &blockConditions, ActiveMasks &masks,
+    AccessCounter counter) const {
+  // The counts of the groups of a region repeat with its period: simulate
+  // one period of groups, each standing for all the groups at a multiple of
+  // the period from it.
+  std::vector<GroupRegion> regions =
+      findPeriodicRegions(subscript, blockConditions, *ndrSpace,
+                          getTranslationPeriod(hwConfig));
+  struct Representative {
+    int group[3];
+    long multiplicity;
+  };
+  std::vector<Representative> representatives;
+  for (const GroupRegion &region : regions) {
+    int steps[3];
+    for (int direction = 0; direction < 3; ++direction)
+      steps[direction] = std::min(region.end[direction] -
+                                      region.begin[direction],
+                                  region.period[direction]);
+
+    int offsets[3];
+    for (offsets[2] = 0; offsets[2] < steps[2]; ++offsets[2]) {
+      for (offsets[1] = 0; offsets[1] < steps[1]; ++offsets[1]) {
+        for (offsets[0] = 0; offsets[0] < steps[0]; ++offsets[0]) {
+          Representative representative;
+          for (int direction = 0; direction < 3; ++direction)
+            representative.group[direction] =
+                region.begin[direction] + offsets[direction];
+          representative.multiplicity = region.getMultiplicity(offsets);
+          representatives.push_back(representative);
+        }
+      }
+    }
+  }
+
+  for (const Representative &representative : representatives)
+    for (int warpIndex = 0; warpIndex < getWarpsPerGroup(); ++warpIndex)
+      masks.addWarp(getWarpId(representative.group[0], representative.group[1],
+                              representative.group[2], warpIndex));
+
+  // Every representative writes its own slot, so the result does not depend
+  // on the scheduling of the groups.
+  std::vector<int64_t> groupResults(representatives.size(), 0);
+  threadPool.parallelFor(representatives.size(), [&](size_t index) {
+    const Representative &representative = representatives[index];
+    int result = countAccessesInGroup(
+        subscript, blockConditions, masks, counter, representative.group[0],
+        representative.group[1], representative.group[2]);
+    groupResults[index] =
+        static_cast<int64_t>(result) * representative.multiplicity;
+  });
+
+  return saturateCount(std::accumulate(groupResults.begin(),
+                                       groupResults.end(), int64_t(0)));
+}
+
+//------------------------------------------------------------------------------
+int WarpSimulator::countAccessesInGroup(
+    const CompiledExpression &subscript,
+    const std::vector<CompiledCondition> &blockConditions, ActiveMasks &masks,
+    AccessCounter counter, int groupX, int groupY, int groupZ) const {
+  const int warpsPerGroup = getWarpsPerGroup();
+
+  GroupAccess access =
+      specializeForGroup(subscript, blockConditions, groupX, groupY, groupZ);
+  WarpClasses classes(getTranslationPeriod(hwConfig));
+  int result = 0;
+  for (int firstWarp = 0; firstWarp < warpsPerGroup;
+       firstWarp += WARP_BATCH_SIZE) {
+    Warp warps[WARP_BATCH_SIZE];
+    int warpIds[WARP_BATCH_SIZE];
+    int warpNumber = 0;
+    for (int warpIndex = firstWarp;
+         warpIndex < warpsPerGroup && warpNumber < WARP_BATCH_SIZE;
+         ++warpIndex, ++warpNumber) {
+      warps[warpNumber] =
+          warpFactory.createWarp(groupX, groupY, groupZ, warpIndex);
+      warpIds[warpNumber] = getWarpId(groupX, groupY, groupZ, warpIndex);
+    }
+
+    int results[WARP_BATCH_SIZE];
+    countAccessesInWarps(access.subscript, access.blockConditions, warps,
+                         warpIds, warpNumber, masks, counter, classes,
+                         results);
+    result += std::accumulate(results, results + warpNumber, 0);
+  }
+  return result;
+}
+
+//------------------------------------------------------------------------------
+int WarpSimulator::countSliceAccesses(const std::vector<Warp> &warps,
+                                      WarpSlice slice,
+                                      AccessCounter counter) const {
+  size_t batchNumber = (warps.size() + WARP_BATCH_SIZE - 1) / WARP_BATCH_SIZE;
+  std::vector<int> batchResults(batchNumber, 0);
+  threadPool.parallelFor(batchNumber, [&](size_t batch) {
+    size_t firstWarp = batch * WARP_BATCH_SIZE;
+    int warpNumber = std::min<size_t>(WARP_BATCH_SIZE, warps.size() - firstWarp);
+    batchResults[batch] = countSliceAccessesInWarps(&warps[firstWarp],
+                                                    warpNumber, slice, counter);
+  });
+
+  return std::accumulate(batchResults.begin(), batchResults.end(), 0);
+}
+
+//------------------------------------------------------------------------------
+int WarpSimulator::countSliceAccessesInNDRange(WarpSlice slice,
+                                               AccessCounter counter) const {
+  const int warpsPerGroup = getWarpsPerGroup();
+  const int groupsX = ndrSpace->getNumberOfGroupsX();
+  const int groupsY = ndrSpace->getNumberOfGroupsY();
+  const size_t warpNumber =
+      static_cast<size_t>(ndrSpace->getTotalNumberOfGroups()) * warpsPerGroup;
+
+  // Every batch writes its own slot, so the result does not depend on the
+  // scheduling of the batches.
+  size_t batchNumber = (warpNumber + WARP_BATCH_SIZE - 1) / WARP_BATCH_SIZE;
+  std::vector<int64_t> batchResults(batchNumber, 0);
+  threadPool.parallelFor(batchNumber, [&](size_t batch) {
+    Warp warps[WARP_BATCH_SIZE];
+    int batchWarps = 0;
+    for (size_t warpId = batch * WARP_BATCH_SIZE;
+         warpId < warpNumber && batchWarps < WARP_BATCH_SIZE;
+         ++warpId, ++batchWarps) {
+      int groupIndex = warpId / warpsPerGroup;
+      warps[batchWarps] = warpFactory.createWarp(
+          groupIndex % groupsX, groupIndex / groupsX % groupsY,
+          groupIndex / groupsX / groupsY, warpId % warpsPerGroup);
+    }
+    batchResults[batch] =
+        countSliceAccessesInWarps(warps, batchWarps, slice, counter);
+  });
+
+  return saturateCount(std::accumulate(batchResults.begin(),
+                                       batchResults.end(), int64_t(0)));
+}
+
+//------------------------------------------------------------------------------
+int WarpSimulator::countSliceAccessesInWarps(const Warp *warps,
+                                             int warpNumber, WarpSlice slice,
+                                             AccessCounter counter) const {
+  assert(warpNumber <= WARP_BATCH_SIZE && "Too many warps");
+
+  int64_t addresses[WARP_BATCH_SIZE * LaneCoordinates::MAX_LANE_NUMBER];
+  uint64_t activeMasks[WARP_BATCH_SIZE];
+  int laneNumber = 0;
+  for (int index = 0; index < warpNumber; ++index) {
+    LaneCoordinates lanes(warps[index]);
+    laneNumber = lanes.laneNumber;
+    slice(&lanes, addresses + index * laneNumber, &activeMasks[index]);
+  }
+
+  int results[WARP_BATCH_SIZE];
+  counter.countBatch(addresses, activeMasks, laneNumber, warpNumber, hwConfig,
+                     results);
+  return std::accumulate(results, results + warpNumber, 0);
+}
+
+//------------------------------------------------------------------------------
+SampledEstimate WarpSimulator::estimateAccesses(
+    const CompiledExpression &subscript,
+    const std::vector<CompiledCondition> &blockConditions, ActiveMasks &masks,
+    AccessCounter counter, const GroupSampler &sampler) const {
+  return sampler.estimateTotal(
+      [&](const std::vector<SamplingUnit> &units, std::vector<int> &values) {
+        for (const SamplingUnit &unit : units)
+          masks.addWarp(getWarpId(unit.groupX, unit.groupY, unit.groupZ,
+                                  unit.warpIndex));
+
+        size_t batchNumber =
+            (units.size() + WARP_BATCH_SIZE - 1) / WARP_BATCH_SIZE;
+        threadPool.parallelFor(batchNumber, [&](size_t batch) {
+          size_t firstUnit = batch * WARP_BATCH_SIZE;
+          Warp warps[WARP_BATCH_SIZE];
+          int warpIds[WARP_BATCH_SIZE];
+          int warpNumber = 0;
+          for (size_t index = firstUnit;
+               index < units.size() && warpNumber < WARP_BATCH_SIZE;
+               ++index, ++warpNumber) {
+            const SamplingUnit &unit = units[index];
+            warps[warpNumber] = warpFactory.createWarp(
+                unit.groupX, unit.groupY, unit.groupZ, unit.warpIndex);
+            warpIds[warpNumber] = getWarpId(unit.groupX, unit.groupY,
+                                            unit.groupZ, unit.warpIndex);
+          }
+
+          WarpClasses classes(getTranslationPeriod(hwConfig));
+          countAccessesInWarps(subscript, blockConditions, warps, warpIds,
+                               warpNumber, masks, counter, classes,
+                               &values[firstUnit]);
+        });
+      });
+}
+
+//------------------------------------------------------------------------------
+WarpSimulator::GroupAccess WarpSimulator::specializeForGroup(
+    const CompiledExpression &subscript,
+    const std::vector<CompiledCondition> &blockConditions, int groupX,
+    int groupY, int groupZ) const {
+  // Lane-invariant expressions have already been folded by bind().
+  GroupAccess access;
+  access.subscript =
+      subscript.getUniformity() == CompiledExpression::UNIFORM
+          ? subscript
+          : subscript.specialize(*ndrSpace, groupX, groupY, groupZ);
+
+  for (const CompiledCondition &condition : blockConditions) {
+    CompiledCondition specialized = condition;
+    if (condition.expression.getUniformity() != CompiledExpression::UNIFORM)
+      specialized.expression =
+          condition.expression.specialize(*ndrSpace, groupX, groupY, groupZ);
+    access.blockConditions.push_back(specialized);
+  }
+
+  return access;
+}
+
+//------------------------------------------------------------------------------
+WarpSimulator::WarpClasses::WarpClasses(int64_t period) : period(period) {}
+
+//------------------------------------------------------------------------------
+static int64_t getResidue(int64_t value, int64_t period) {
+  return (value % period + period) % period;
+}
+
+//------------------------------------------------------------------------------
+int WarpSimulator::WarpClasses::find(int shape, uint64_t activeMask,
+                                     int64_t base) const {
+  if (period <= 0)
+    return -1;
+
+  int64_t baseResidue = getResidue(base, period);
+  for (size_t index = 0; index < classes.size(); ++index) {
+    const Class &warpClass = classes[index];
+    if (warpClass.shape == shape && warpClass.activeMask == activeMask &&
+        warpClass.baseResidue == baseResidue &&
+        base + warpClass.minOffset >= 0)
+      return index;
+  }
+  return -1;
+}
+
+//------------------------------------------------------------------------------
+int WarpSimulator::WarpClasses::add(int shape, uint64_t activeMask,
+                                    int64_t base, int64_t minOffset) {
+  // Shifts do not preserve the counts of negative addresses.
+  if (period <= 0 || base + minOffset < 0)
+    return -1;
+
+  Class warpClass = {shape, activeMask, getResidue(base, period), minOffset, 0};
+  classes.push_back(warpClass);
+  return classes.size() - 1;
+}
+
+//------------------------------------------------------------------------------
+void WarpSimulator::countAccessesInWarps(
+    const CompiledExpression &subscript,
+    const std::vector<CompiledCondition> &blockConditions, const Warp *warps,
+    const int *warpIds, int warpNumber, ActiveMasks &masks,
+    AccessCounter counter, WarpClasses &classes, int *results) const {
+  assert(warpNumber <= WARP_BATCH_SIZE && "Too many warps");
+
+  // Addresses of the warps that have to be enumerated, counted in one batch.
+  int64_t addresses[WARP_BATCH_SIZE * LaneCoordinates::MAX_LANE_NUMBER];
+  uint64_t activeMasks[WARP_BATCH_SIZE];
+  int batchWarps[WARP_BATCH_SIZE];
+  int batchNumber = 0;
+  int laneNumber = 0;
+  // Class of each warp, -1 for warps not in a class.
+  int classIds[WARP_BATCH_SIZE];
+
+  for (int index = 0; index < warpNumber; ++index) {
+    results[index] = 0;
+    classIds[index] = -1;
+    auto slot = masks.masks.find(warpIds[index]);
+    assert(slot != masks.masks.end() && "Warp without an active mask slot");
+    ActiveMasks::Mask &mask = slot->second;
+
+    // Warps that do not execute the block are known without looking at them.
+    if (mask.computed && mask.lanes == 0)
+      continue;
+
+    LaneCoordinates lanes;
+    if (!mask.computed) {
+      lanes = LaneCoordinates(warps[index]);
+      mask.lanes = computeActiveMask(blockConditions, lanes);
+      mask.computed = true;
+    }
+
+    uint64_t activeMask = mask.lanes;
+    if (activeMask == 0)
+      continue;
+
+    // The base address of affine subscripts identifies the class of the warp
+    // without evaluating its lanes.
+    int shape = warps[index].getShape();
+    int64_t base = 0;
+    if (subscript.isAffine()) {
+      base = subscript.getAffineForm().evaluate(warps[index].getPoint(0));
+      classIds[index] = classes.find(shape, activeMask, base);
+      if (classIds[index] != -1)
+        continue;
+    }
+
+    if (lanes.laneNumber == 0)
+      lanes = LaneCoordinates(warps[index]);
+
+    int64_t stride = 0;
+    if (getLaneStride(subscript, lanes, base, stride)) {
+      results[index] = counter.countStrided(base, stride, lanes.laneNumber,
+                                            activeMask, hwConfig);
+      int64_t minOffset = std::numeric_limits<int64_t>::max();
+      for (int lane = 0; lane < lanes.laneNumber; ++lane)
+        if (activeMask & (static_cast<uint64_t>(1) << lane))
+          minOffset = std::min(minOffset, stride * lane);
+      classIds[index] = classes.add(shape, activeMask, base, minOffset);
+      if (classIds[index] != -1)
+        classes.classes[classIds[index]].count = results[index];
+      continue;
+    }
+
+    laneNumber = lanes.laneNumber;
+    int64_t *warpAddresses = addresses + batchNumber * laneNumber;
+    // Lanes whose address cannot be evaluated do not access memory.
+    activeMasks[batchNumber] =
+        activeMask & evaluateAddresses(subscript, lanes, warpAddresses);
+    batchWarps[batchNumber++] = index;
+
+    if (subscript.isAffine()) {
+      // The base is the address of the first lane, active or not.
+      base = warpAddresses[0];
+      int64_t minOffset = std::numeric_limits<int64_t>::max();
+      for (int lane = 0; lane < laneNumber; ++lane)
+        if (activeMask & (static_cast<uint64_t>(1) << lane))
+          minOffset = std::min(minOffset, warpAddresses[lane] - base);
+      classIds[index] = classes.add(shape, activeMask, base, minOffset);
+    }
+  }
+
+  if (batchNumber != 0) {
+    int batchResults[WARP_BATCH_SIZE];
+    counter.countBatch(addresses, activeMasks, laneNumber, batchNumber,
+                       hwConfig, batchResults);
+    for (int batch = 0; batch < batchNumber; ++batch) {
+      int index = batchWarps[batch];
+      results[index] = batchResults[batch];
+      if (classIds[index] != -1)
+        classes.classes[classIds[index]].count = results[index];
+    }
+  }
+
+  // The other warps of each class have the count of the warp analyzed.
+  for (int index = 0; index < warpNumber; ++index)
+    if (classIds[index] != -1)
+      results[index] = classes.classes[classIds[index]].count;
+}
+
+//------------------------------------------------------------------------------
+uint64_t WarpSimulator::evaluateAddresses(const CompiledExpression &subscript,
+                                          const LaneCoordinates &lanes,
+                                          int64_t *addresses) const {
+  uint64_t validMask = (lanes.laneNumber == 64)
+                           ? ~static_cast<uint64_t>(0)
+                           : (static_cast<uint64_t>(1) << lanes.laneNumber) - 1;
+  bool valid[LaneCoordinates::MAX_LANE_NUMBER];
+  if (evaluateForWarp(subscript, lanes, addresses, valid))
+    return validMask;
+
+  for (int lane = 0; lane < lanes.laneNumber; ++lane) {
+    if (!valid[lane]) {
+      addresses[lane] = OCLEnv::UNKNOWN_MEMORY_LOCATION;
+      validMask &= ~(static_cast<uint64_t>(1) << lane);
+    }
+  }
+  return validMask;
+}
+
+//------------------------------------------------------------------------------
+uint64_t WarpSimulator::computeActiveMask(
+    const std::vector<CompiledCondition> &blockConditions,
+    const LaneCoordinates &lanes) const {
+  uint64_t activeMask = (lanes.laneNumber == 64)
+                            ? ~static_cast<uint64_t>(0)
+                            : (static_cast<uint64_t>(1) << lanes.laneNumber) - 1;
+
+  int64_t values[LaneCoordinates::MAX_LANE_NUMBER];
+  bool valid[LaneCoordinates::MAX_LANE_NUMBER];
+  for (auto &condition : blockConditions) {
+    // The remaining conditions cannot enable any lane.
+    if (activeMask == 0)
+      break;
+
+    evaluateForWarp(condition.expression, lanes, values, valid);
+    // Conditions that cannot be computed are considered false.
+    for (int lane = 0; lane < lanes.laneNumber; ++lane)
+      if (!valid[lane] ||
+          !BlockCondition::getBooleanValue(values[lane], condition.predicate))
+        activeMask &= ~(static_cast<uint64_t>(1) << lane);
+  }
+
+  return activeMask;
+}
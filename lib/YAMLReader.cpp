@@ -6,18 +6,29 @@ using namespace SymEngine;
 using yaml::Input;
 
 // -----------------------------------------------------------------------------
-HardwareConfig readHardwareConfig(const std::string &fileName) {
-  HardwareConfig hwConfig;
+static HardwareConfigFile readHardwareConfigFile(const std::string &fileName) {
+  HardwareConfigFile file;
   std::string fileContent = readFile(fileName);
 
   Input yin(fileContent);
-  yin >> hwConfig;
+  yin >> file;
 
   if (yin.error()) {
     errs() << "Error reading the hardware configuration file.\n";
     exit(1);
   }
-  return hwConfig;
+  return file;
+}
+
+// -----------------------------------------------------------------------------
+HardwareConfig readHardwareConfig(const std::string &fileName) {
+  HardwareConfigFile file = readHardwareConfigFile(fileName);
+  return file.profiles.empty() ? file.config : file.profiles.front().config;
+}
+
+// -----------------------------------------------------------------------------
+std::vector<HardwareProfile> readHardwareProfiles(const std::string &fileName) {
+  return readHardwareConfigFile(fileName).profiles;
 }
 
 // -----------------------------------------------------------------------------
@@ -50,3 +61,36 @@ OpenCLConfig readOpenCLConfig(const std::string &fileName) {
 
   return openclConfig;
 }
+
+// -----------------------------------------------------------------------------
+KernelFormulas readKernelFormulas(const std::string &fileName) {
+  KernelFormulas formulas;
+  std::string fileContent = readFile(fileName);
+
+  Input yin(fileContent);
+  yin >> formulas;
+
+  if (yin.error()) {
+    errs() << "Error reading the access formulas file.\n";
+    exit(1);
+  }
+
+  return formulas;
+}
+
+// -----------------------------------------------------------------------------
+SweepConfig readSweepConfig(const std::string &fileName) {
+  // Sizes missing from the file are 0: directions not swept.
+  SweepConfig config = SweepConfig();
+  std::string fileContent = readFile(fileName);
+
+  Input yin(fileContent);
+  yin >> config;
+
+  if (yin.error()) {
+    errs() << "Error reading the sweep file.\n";
+    exit(1);
+  }
+
+  return config;
+}
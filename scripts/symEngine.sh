@@ -9,14 +9,19 @@ PROJECT_DIR=$HOME/src/SymEngine/
 OCLDEF=$PROJECT_DIR/include/opencl_spir.h
 TARGET=spir
 
-if [ $# -ne 2 ]
+if [ $# -ne 1 ] && [ $# -ne 2 ]
 then
-  echo "Must specify: input file, kernel name"
+  echo "Must specify: input file, kernel name (all the kernels if omitted)"
 exit 1;
 fi
 
 INPUT_FILE=$1
-KERNEL_NAME=$2
+if [ $# -eq 2 ]
+then
+  KERNEL_OPTIONS="-symbolic-kernel-name $2"
+else
+  KERNEL_OPTIONS="-symbolic-all-kernels"
+fi
 
 # Compile kernel.
 $CLANG -x cl \
@@ -29,5 +34,5 @@ $OPT -dot-cfg-only \
      -mem2reg \
      -inline -inline-threshold=10000 \
      -instnamer -load ${LIB_SYM_ENGINE} \
-     -symbolic-execution -symbolic-kernel-name ${KERNEL_NAME}  \
+     -symbolic-execution ${KERNEL_OPTIONS} \
      -S -o /dev/null
@@ -0,0 +1,105 @@
+#include "gtest.h"
+
+#include "SymEngine/AccessFormula.h"
+#include "SymEngine/HardwareConfig.h"
+#include "SymEngine/MemoryAccessesAnalyzer.h"
+#include "SymEngine/NDRangeSpace.h"
+#include "SymEngine/ThreadPool.h"
+#include "SymEngine/Warp.h"
+
+using namespace SymEngine;
+
+class AccessFormulaTest : public ::testing::Test {
+protected:
+  AccessFormulaTest() : ndrSpace(32, 4, 1, 4, 4, 1), threadPool(2) {
+    hwConfig = {32, 4, 32, 128};
+  }
+
+  // Transactions of all the warps of the NDRange, simulated lane by lane.
+  int countNDRange(const CompiledExpression &subscript,
+                   const std::vector<CompiledCondition> &conditions) const {
+    WarpFactory factory(&ndrSpace, hwConfig.warpSize);
+    int result = 0;
+    for (int groupY = 0; groupY < ndrSpace.getNumberOfGroupsY(); ++groupY) {
+      for (int groupX = 0; groupX < ndrSpace.getNumberOfGroupsX(); ++groupX) {
+        for (const Warp &warp :
+             factory.createAllWarpsInGroup(groupX, groupY, 0)) {
+          int64_t addresses[64];
+          int addressNumber = 0;
+          for (auto iter = warp.begin(), iterEnd = warp.end();
+               iter != iterEnd; ++iter) {
+            bool active = true;
+            for (auto &condition : conditions) {
+              int64_t value = 0;
+              condition.expression.evaluate(*iter, value);
+              active &=
+                  BlockCondition::getBooleanValue(value, condition.predicate);
+            }
+            if (active)
+              subscript.evaluate(*iter, addresses[addressNumber++]);
+          }
+          if (addressNumber > 0)
+            result += computeTransactionNumberImpl(addresses, addressNumber,
+                                                   hwConfig);
+        }
+      }
+    }
+    return result;
+  }
+
+  NDRangeSpace ndrSpace;
+  HardwareConfig hwConfig;
+  ThreadPool threadPool;
+};
+
+// 4 * (get_global_id(1) * arg0 + get_global_id(0)), guarded by
+// get_global_id(0) < arg1, in a loop running arg2 times.
+TEST_F(AccessFormulaTest, SymbolicArguments) {
+  AccessFormula formula;
+  formula.isLoad = true;
+  formula.isLocal = false;
+  formula.subscript.appendConstant(4);
+  formula.subscript.appendCoordinate(CompiledExpression::GLOBAL_ID, 1);
+  formula.subscript.appendArgument(0);
+  formula.subscript.appendOperation(CompiledExpression::MUL, 2);
+  formula.subscript.appendCoordinate(CompiledExpression::GLOBAL_ID, 0);
+  formula.subscript.appendOperation(CompiledExpression::ADD, 2);
+  formula.subscript.appendOperation(CompiledExpression::MUL, 2);
+
+  CompiledCondition condition;
+  condition.expression.appendCoordinate(CompiledExpression::GLOBAL_ID, 0);
+  condition.expression.appendArgument(1);
+  condition.expression.appendConstant(-1);
+  condition.expression.appendOperation(CompiledExpression::MUL, 2);
+  condition.expression.appendOperation(CompiledExpression::ADD, 2);
+  condition.predicate = llvm::CmpInst::ICMP_SLT;
+  formula.blockConditions.push_back(condition);
+  formula.tripCount.appendArgument(2);
+
+  // The formula is evaluated for any argument values as the bound access.
+  std::vector<std::vector<int64_t>> argumentSets = {
+      {128, 100, 1}, {133, 128, 3}, {7, 0, 2}};
+  for (const std::vector<int64_t> &arguments : argumentSets) {
+    CompiledExpression subscript =
+        formula.subscript.bindArguments(arguments).bind(ndrSpace);
+    CompiledCondition boundCondition = condition;
+    boundCondition.expression =
+        condition.expression.bindArguments(arguments).bind(ndrSpace);
+    int expected =
+        countNDRange(subscript, std::vector<CompiledCondition>(
+                                    1, boundCondition)) * arguments[2];
+    EXPECT_EQ(evaluateAccessFormula(formula, arguments, &ndrSpace, hwConfig,
+                                    threadPool),
+              expected);
+  }
+
+  // Missing arguments make the subscript unknown.
+  EXPECT_EQ(evaluateAccessFormula(formula, std::vector<int64_t>(), &ndrSpace,
+                                  hwConfig, threadPool),
+            -1);
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,341 @@
+#include "gtest.h"
+
+#include "SymEngine/CompiledExpression.h"
+#include "SymEngine/NDRangePoint.h"
+#include "SymEngine/NDRangeSpace.h"
+#include "SymEngine/Warp.h"
+#include "SymEngine/WarpEvaluator.h"
+
+using namespace SymEngine;
+
+class CompiledExpressionTest : public ::testing::Test {
+protected:
+  CompiledExpressionTest() : ndrSpace(32, 4, 1, 8, 8, 1) {}
+
+  NDRangeSpace ndrSpace;
+};
+
+// 4 * (get_global_id(1) * get_global_size(0) + get_global_id(0))
+TEST_F(CompiledExpressionTest, AffineSubscript) {
+  CompiledExpression expr;
+  expr.appendConstant(4);
+  expr.appendCoordinate(CompiledExpression::GLOBAL_ID, 1);
+  expr.appendSize(CompiledExpression::GLOBAL_SIZE, 0);
+  expr.appendOperation(CompiledExpression::MUL, 2);
+  expr.appendCoordinate(CompiledExpression::GLOBAL_ID, 0);
+  expr.appendOperation(CompiledExpression::ADD, 2);
+  expr.appendOperation(CompiledExpression::MUL, 2);
+
+  CompiledExpression bound = expr.bind(ndrSpace);
+  EXPECT_TRUE(bound.isComputable());
+  EXPECT_TRUE(bound.isAffine());
+
+  const AffineForm &form = bound.getAffineForm();
+  EXPECT_EQ(form.constant, 0);
+  EXPECT_EQ(form.coefficients[3], 4);
+  EXPECT_EQ(form.coefficients[4], 4 * 256);
+
+  NDRangePoint point(3, 2, 0, 1, 5, 0, &ndrSpace);
+  int64_t result = 0;
+  EXPECT_TRUE(bound.evaluate(point, result));
+  EXPECT_EQ(result, 4 * ((5 * 4 + 2) * 256 + 32 + 3));
+}
+
+// (get_local_id(0) % get_local_size(1)) + 7
+TEST_F(CompiledExpressionTest, PiecewiseSubscript) {
+  CompiledExpression expr;
+  expr.appendCoordinate(CompiledExpression::LOCAL_ID, 0);
+  expr.appendSize(CompiledExpression::LOCAL_SIZE, 1);
+  expr.appendOperation(CompiledExpression::UREM, 2);
+  expr.appendConstant(7);
+  expr.appendOperation(CompiledExpression::ADD, 2);
+
+  CompiledExpression bound = expr.bind(ndrSpace);
+  EXPECT_TRUE(bound.isComputable());
+  EXPECT_FALSE(bound.isAffine());
+
+  for (int localX = 0; localX < 32; ++localX) {
+    NDRangePoint point(localX, 0, 0, 0, 0, 0, &ndrSpace);
+    int64_t result = 0;
+    EXPECT_TRUE(bound.evaluate(point, result));
+    EXPECT_EQ(result, localX % 4 + 7);
+  }
+}
+
+TEST_F(CompiledExpressionTest, ConstantFolding) {
+  CompiledExpression expr;
+  expr.appendSize(CompiledExpression::LOCAL_SIZE, 0);
+  expr.appendSize(CompiledExpression::GROUPS_NUMBER, 1);
+  expr.appendOperation(CompiledExpression::UDIV, 2);
+
+  CompiledExpression bound = expr.bind(ndrSpace);
+  EXPECT_EQ(bound.getNodes().size(), 1u);
+  EXPECT_TRUE(bound.isAffine());
+  EXPECT_EQ(bound.getAffineForm().constant, 4);
+}
+
+// (get_global_id(0) - 40) / 8, as a signed and as an unsigned division.
+TEST_F(CompiledExpressionTest, SignedDivision) {
+  for (auto opCode : {CompiledExpression::SDIV, CompiledExpression::UDIV}) {
+    CompiledExpression expr;
+    expr.appendCoordinate(CompiledExpression::GLOBAL_ID, 0);
+    expr.appendConstant(-40);
+    expr.appendOperation(CompiledExpression::ADD, 2);
+    expr.appendConstant(8);
+    expr.appendOperation(opCode, 2);
+
+    CompiledExpression parsed;
+    ASSERT_TRUE(CompiledExpression::parse(expr.toString(), parsed));
+    EXPECT_EQ(parsed.toString(), expr.toString());
+
+    CompiledExpression bound = parsed.bind(ndrSpace);
+    for (int globalX = 0; globalX < 64; ++globalX) {
+      NDRangePoint point(globalX % 32, 0, 0, globalX / 32, 0, 0, &ndrSpace);
+      int64_t result = 0;
+      EXPECT_TRUE(bound.evaluate(point, result));
+      int64_t difference = globalX - 40;
+      EXPECT_EQ(result, opCode == CompiledExpression::SDIV
+                            ? difference / 8
+                            : int64_t(uint64_t(difference) / 8));
+    }
+  }
+
+  // Constants are folded with the same semantics.
+  int64_t operands[] = {-9, 2};
+  int64_t result = 0;
+  EXPECT_TRUE(CompiledExpression::applyOperation(CompiledExpression::SDIV,
+                                                 operands, 2, result));
+  EXPECT_EQ(result, -4);
+  EXPECT_TRUE(CompiledExpression::applyOperation(CompiledExpression::UDIV,
+                                                 operands, 2, result));
+  EXPECT_EQ(result, int64_t(uint64_t(-9) / 2));
+  int64_t overflow[] = {INT64_MIN, -1};
+  EXPECT_FALSE(CompiledExpression::applyOperation(CompiledExpression::SDIV,
+                                                  overflow, 2, result));
+}
+
+TEST_F(CompiledExpressionTest, Unknown) {
+  CompiledExpression expr;
+  expr.appendCoordinate(CompiledExpression::LOCAL_ID, 0);
+  expr.setUnknown();
+  expr.appendConstant(1);
+
+  CompiledExpression bound = expr.bind(ndrSpace);
+  EXPECT_FALSE(bound.isComputable());
+
+  int64_t result = 0;
+  EXPECT_FALSE(bound.evaluate(NDRangePoint(), result));
+}
+
+// 4 * (get_global_id(0) + arg1) % get_local_size(0), with the argument
+// left symbolic.
+TEST_F(CompiledExpressionTest, SymbolicArguments) {
+  CompiledExpression expr;
+  expr.appendConstant(4);
+  expr.appendCoordinate(CompiledExpression::GLOBAL_ID, 0);
+  expr.appendArgument(1);
+  expr.appendOperation(CompiledExpression::ADD, 2);
+  expr.appendOperation(CompiledExpression::MUL, 2);
+  expr.appendSize(CompiledExpression::LOCAL_SIZE, 0);
+  expr.appendOperation(CompiledExpression::UREM, 2);
+
+  // Arguments must be bound before the NDRange.
+  EXPECT_FALSE(expr.bind(ndrSpace).isComputable());
+  EXPECT_FALSE(expr.bindArguments(std::vector<int64_t>(1, 0)).isComputable());
+
+  std::string text = expr.toString();
+  EXPECT_EQ(text, "4 gid0 arg1 add2 mul2 lsz0 urem2");
+  CompiledExpression parsed;
+  ASSERT_TRUE(CompiledExpression::parse(text, parsed));
+  EXPECT_EQ(parsed.toString(), text);
+
+  std::vector<int64_t> arguments = {0, 3};
+  CompiledExpression bound = parsed.bindArguments(arguments).bind(ndrSpace);
+  for (int globalX = 0; globalX < 64; ++globalX) {
+    NDRangePoint point(globalX % 32, 0, 0, globalX / 32, 0, 0, &ndrSpace);
+    int64_t result = 0;
+    EXPECT_TRUE(bound.evaluate(point, result));
+    EXPECT_EQ(result, 4 * (globalX + 3) % 32);
+  }
+
+  EXPECT_EQ(CompiledExpression::createUnknown().toString(), "unknown");
+  ASSERT_TRUE(CompiledExpression::parse("unknown", parsed));
+  EXPECT_FALSE(parsed.isComputable());
+  EXPECT_FALSE(CompiledExpression::parse("4 add2", parsed));
+  EXPECT_FALSE(CompiledExpression::parse("4 gid0", parsed));
+  EXPECT_FALSE(CompiledExpression::parse("4 foo1", parsed));
+  EXPECT_FALSE(CompiledExpression::parse("", parsed));
+}
+
+// 3 + get_local_id(0) + 4
+TEST_F(CompiledExpressionTest, PartialFolding) {
+  CompiledExpression expr;
+  expr.appendConstant(3);
+  expr.appendCoordinate(CompiledExpression::LOCAL_ID, 0);
+  expr.appendConstant(4);
+  expr.appendOperation(CompiledExpression::ADD, 3);
+
+  CompiledExpression bound = expr.bind(ndrSpace);
+  EXPECT_EQ(bound.getNodes().size(), 3u);
+  EXPECT_EQ(bound.getNodes()[1].value, 7);
+  EXPECT_EQ(bound.getUniformity(), CompiledExpression::VARYING);
+}
+
+TEST_F(CompiledExpressionTest, GroupSpecialization) {
+  // (get_global_id(0) + 7 * get_group_id(1)) % 5 + 100 * get_global_id(1)
+  CompiledExpression varying;
+  varying.appendCoordinate(CompiledExpression::GLOBAL_ID, 0);
+  varying.appendConstant(7);
+  varying.appendCoordinate(CompiledExpression::GROUP_ID, 1);
+  varying.appendOperation(CompiledExpression::MUL, 2);
+  varying.appendOperation(CompiledExpression::ADD, 2);
+  varying.appendConstant(5);
+  varying.appendOperation(CompiledExpression::UREM, 2);
+  varying.appendConstant(100);
+  varying.appendCoordinate(CompiledExpression::GLOBAL_ID, 1);
+  varying.appendOperation(CompiledExpression::MUL, 2);
+  varying.appendOperation(CompiledExpression::ADD, 2);
+
+  // get_group_id(0) * get_num_groups(1) + get_group_id(1)
+  CompiledExpression groupUniform;
+  groupUniform.appendCoordinate(CompiledExpression::GROUP_ID, 0);
+  groupUniform.appendSize(CompiledExpression::GROUPS_NUMBER, 1);
+  groupUniform.appendOperation(CompiledExpression::MUL, 2);
+  groupUniform.appendCoordinate(CompiledExpression::GROUP_ID, 1);
+  groupUniform.appendOperation(CompiledExpression::ADD, 2);
+
+  CompiledExpression boundVarying = varying.bind(ndrSpace);
+  CompiledExpression boundUniform = groupUniform.bind(ndrSpace);
+  EXPECT_EQ(boundVarying.getUniformity(), CompiledExpression::VARYING);
+  EXPECT_EQ(boundUniform.getUniformity(), CompiledExpression::GROUP_UNIFORM);
+
+  CompiledExpression specializedVarying =
+      boundVarying.specialize(ndrSpace, 3, 2, 0);
+  CompiledExpression specializedUniform =
+      boundUniform.specialize(ndrSpace, 3, 2, 0);
+  EXPECT_EQ(specializedUniform.getUniformity(), CompiledExpression::UNIFORM);
+  EXPECT_EQ(specializedUniform.getNodes().size(), 1u);
+  for (auto node : specializedVarying.getNodes())
+    EXPECT_NE(node.opCode, CompiledExpression::GROUP_ID);
+
+  for (int localY = 0; localY < 4; ++localY) {
+    for (int localX = 0; localX < 32; ++localX) {
+      NDRangePoint point(localX, localY, 0, 3, 2, 0, &ndrSpace);
+      int64_t expected = 0, result = 0;
+      EXPECT_TRUE(boundVarying.evaluate(point, expected));
+      EXPECT_TRUE(specializedVarying.evaluate(point, result));
+      EXPECT_EQ(result, expected);
+      EXPECT_TRUE(specializedUniform.evaluate(point, result));
+      EXPECT_EQ(result, 3 * 8 + 2);
+    }
+  }
+}
+
+// Warp-wide evaluation must match the evaluation of the single lanes.
+TEST_F(CompiledExpressionTest, WarpEvaluation) {
+  // 4 * (get_local_id(1) * 1000 - 3 * get_group_id(0) + get_global_id(0))
+  CompiledExpression affine;
+  affine.appendConstant(4);
+  affine.appendCoordinate(CompiledExpression::LOCAL_ID, 1);
+  affine.appendConstant(1000);
+  affine.appendOperation(CompiledExpression::MUL, 2);
+  affine.appendConstant(-3);
+  affine.appendCoordinate(CompiledExpression::GROUP_ID, 0);
+  affine.appendOperation(CompiledExpression::MUL, 2);
+  affine.appendCoordinate(CompiledExpression::GLOBAL_ID, 0);
+  affine.appendOperation(CompiledExpression::ADD, 3);
+  affine.appendOperation(CompiledExpression::MUL, 2);
+
+  // get_global_id(0) / 3 + smax(get_local_id(0), 17)
+  CompiledExpression piecewise;
+  piecewise.appendCoordinate(CompiledExpression::GLOBAL_ID, 0);
+  piecewise.appendConstant(3);
+  piecewise.appendOperation(CompiledExpression::UDIV, 2);
+  piecewise.appendCoordinate(CompiledExpression::LOCAL_ID, 0);
+  piecewise.appendConstant(17);
+  piecewise.appendOperation(CompiledExpression::SMAX, 2);
+  piecewise.appendOperation(CompiledExpression::ADD, 2);
+
+  WarpFactory factory(&ndrSpace, 32);
+  for (int warpIndex = 0; warpIndex < 4; ++warpIndex) {
+    Warp warp = factory.createWarp(3, 2, 0, warpIndex);
+    LaneCoordinates lanes(warp);
+    EXPECT_EQ(lanes.laneNumber, 32);
+
+    for (auto &bound :
+         {affine.bind(ndrSpace), piecewise.bind(ndrSpace),
+          affine.bind(ndrSpace).specialize(ndrSpace, 3, 2, 0),
+          piecewise.bind(ndrSpace).specialize(ndrSpace, 3, 2, 0)}) {
+      int64_t results[LaneCoordinates::MAX_LANE_NUMBER];
+      bool valid[LaneCoordinates::MAX_LANE_NUMBER];
+      EXPECT_TRUE(evaluateForWarp(bound, lanes, results, valid));
+
+      int lane = 0;
+      for (auto iter = warp.begin(), iterEnd = warp.end(); iter != iterEnd;
+           ++iter, ++lane) {
+        int64_t expected = 0;
+        EXPECT_TRUE(bound.evaluate(*iter, expected));
+        EXPECT_TRUE(valid[lane]);
+        EXPECT_EQ(results[lane], expected);
+      }
+    }
+  }
+}
+
+// Affine subscripts of warps within a row are strided across the lanes.
+TEST_F(CompiledExpressionTest, LaneStride) {
+  // 4 * (get_global_id(1) * get_global_size(0) + get_global_id(0)) + 8
+  CompiledExpression expr;
+  expr.appendConstant(4);
+  expr.appendCoordinate(CompiledExpression::GLOBAL_ID, 1);
+  expr.appendSize(CompiledExpression::GLOBAL_SIZE, 0);
+  expr.appendOperation(CompiledExpression::MUL, 2);
+  expr.appendCoordinate(CompiledExpression::GLOBAL_ID, 0);
+  expr.appendOperation(CompiledExpression::ADD, 2);
+  expr.appendOperation(CompiledExpression::MUL, 2);
+  expr.appendConstant(8);
+  expr.appendOperation(CompiledExpression::ADD, 2);
+  CompiledExpression bound = expr.bind(ndrSpace);
+
+  WarpFactory factory(&ndrSpace, 32);
+  LaneCoordinates lanes(factory.createWarp(1, 2, 0, 3));
+  int64_t base = 0;
+  int64_t stride = 0;
+  EXPECT_TRUE(getLaneStride(bound, lanes, base, stride));
+  EXPECT_EQ(stride, 4);
+
+  int64_t results[LaneCoordinates::MAX_LANE_NUMBER];
+  bool valid[LaneCoordinates::MAX_LANE_NUMBER];
+  evaluateForWarp(bound, lanes, results, valid);
+  for (int lane = 0; lane < lanes.laneNumber; ++lane)
+    EXPECT_EQ(results[lane], base + stride * lane);
+
+  // Warps spanning two rows are not strided in get_global_id(1).
+  WarpFactory wideFactory(&ndrSpace, 64);
+  LaneCoordinates wideLanes(wideFactory.createWarp(1, 2, 0, 1));
+  EXPECT_FALSE(getLaneStride(bound, wideLanes, base, stride));
+}
+
+// Warps with the same shape have the same coordinates relative to lane 0.
+TEST_F(CompiledExpressionTest, WarpShapes) {
+  // 16 lanes per warp: 8 different warps in a group of 32 x 4 work-items.
+  WarpFactory factory(&ndrSpace, 16);
+  for (int warpIndex = 0; warpIndex < factory.getWarpsInGroup(); ++warpIndex) {
+    Warp warp = factory.createWarp(1, 3, 0, warpIndex);
+    EXPECT_EQ(warp.getShape(), warpIndex * 16);
+
+    Warp other = factory.createWarp(2, 0, 0, warpIndex);
+    EXPECT_EQ(other.getShape(), warp.getShape());
+    for (int lane = 0; lane < warp.getLaneNumber(); ++lane)
+      for (int direction = 0; direction < 3; ++direction)
+        EXPECT_EQ(warp.getPoint(lane).getLocal(direction) -
+                      warp.getPoint(0).getLocal(direction),
+                  other.getPoint(lane).getLocal(direction) -
+                      other.getPoint(0).getLocal(direction));
+  }
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,142 @@
+#include "gtest.h"
+
+#include "SymEngine/FormulaCache.h"
+#include "SymEngine/ModulePipeline.h"
+#include "SymEngine/Utils.h"
+
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+
+#include "llvm/Support/FileSystem.h"
+
+#include <ctime>
+#include <fstream>
+#include <thread>
+
+#include <sys/time.h>
+
+using namespace llvm;
+using namespace SymEngine;
+
+static const char MODULE_FILE[] = "formula_cache_test.ll";
+
+class FormulaCacheTest : public ::testing::Test {
+protected:
+  FormulaCacheTest() : cache(DEFAULT_INLINE_THRESHOLD) {
+    initializePipeline();
+    // A copy of nd_range_test.ll, whose modification time can be changed.
+    std::ofstream(MODULE_FILE) << readFile("nd_range_test.ll");
+  }
+  ~FormulaCacheTest() { sys::fs::remove(MODULE_FILE); }
+
+  static void setModificationTime(time_t time) {
+    timeval times[2] = {{time, 0}, {time, 0}};
+    ASSERT_EQ(utimes(MODULE_FILE, times), 0);
+  }
+
+  FormulaCache cache;
+};
+
+TEST_F(FormulaCacheTest, CompileModuleFormulas) {
+  LLVMContext context;
+  std::string error;
+  std::unique_ptr<Module> module = loadModule(MODULE_FILE, context, error);
+  ASSERT_TRUE(module != nullptr) << error;
+
+  std::vector<KernelFormulas> kernels = compileModuleFormulas(*module);
+  ASSERT_EQ(kernels.size(), 1u);
+  EXPECT_TRUE(kernels[0].kernelName == "testFunction");
+  ASSERT_EQ(kernels[0].accesses.size(), 2u);
+  EXPECT_TRUE(kernels[0].accesses[0].isLoad);
+  EXPECT_FALSE(kernels[0].accesses[1].isLoad);
+  for (const AccessFormula &formula : kernels[0].accesses) {
+    EXPECT_FALSE(formula.isLocal);
+    EXPECT_TRUE(formula.subscript.isComputable());
+  }
+
+  // The same module held in memory has the same formulas.
+  LLVMContext otherContext;
+  std::unique_ptr<Module> parsedModule =
+      parseModule(readFile(MODULE_FILE), otherContext, error);
+  ASSERT_TRUE(parsedModule != nullptr) << error;
+  std::vector<KernelFormulas> parsedKernels =
+      compileModuleFormulas(*parsedModule);
+  ASSERT_EQ(parsedKernels.size(), 1u);
+  ASSERT_EQ(parsedKernels[0].accesses.size(), 2u);
+  for (size_t index = 0; index < 2; ++index)
+    EXPECT_EQ(parsedKernels[0].accesses[index].subscript.toString(),
+              kernels[0].accesses[index].subscript.toString());
+
+  error.clear();
+  EXPECT_TRUE(parseModule("not a module", otherContext, error) == nullptr);
+  EXPECT_FALSE(error.empty());
+}
+
+TEST_F(FormulaCacheTest, CompiledOnce) {
+  std::string error;
+  std::shared_ptr<const KernelFormulas> kernel =
+      cache.getKernel(MODULE_FILE, "testFunction", error);
+  ASSERT_TRUE(kernel != nullptr) << error;
+  EXPECT_TRUE(kernel->kernelName == "testFunction");
+  EXPECT_EQ(kernel->accesses.size(), 2u);
+
+  // Hits return the same formulas.
+  EXPECT_EQ(cache.getKernel(MODULE_FILE, "testFunction", error), kernel);
+
+  // The module name can be omitted once the module is loaded.
+  EXPECT_EQ(cache.getKernel("", "testFunction", error), kernel);
+}
+
+TEST_F(FormulaCacheTest, CompiledAgainWhenModified) {
+  std::string error;
+  setModificationTime(time(nullptr) - 100);
+  std::shared_ptr<const KernelFormulas> kernel =
+      cache.getKernel(MODULE_FILE, "testFunction", error);
+  ASSERT_TRUE(kernel != nullptr) << error;
+
+  setModificationTime(time(nullptr) - 50);
+  std::shared_ptr<const KernelFormulas> modifiedKernel =
+      cache.getKernel(MODULE_FILE, "testFunction", error);
+  ASSERT_TRUE(modifiedKernel != nullptr) << error;
+  EXPECT_NE(modifiedKernel, kernel);
+  EXPECT_EQ(cache.getKernel("", "testFunction", error), modifiedKernel);
+
+  // The formulas of the previous version stay valid.
+  EXPECT_EQ(kernel->accesses.size(), modifiedKernel->accesses.size());
+}
+
+TEST_F(FormulaCacheTest, ConcurrentRequests) {
+  // All the requests wait for a single compilation.
+  std::shared_ptr<const KernelFormulas> kernels[4];
+  std::vector<std::thread> threads;
+  for (int index = 0; index < 4; ++index)
+    threads.emplace_back([this, &kernels, index]() {
+      std::string error;
+      kernels[index] = cache.getKernel(MODULE_FILE, "testFunction", error);
+    });
+  for (std::thread &thread : threads)
+    thread.join();
+
+  ASSERT_TRUE(kernels[0] != nullptr);
+  for (int index = 1; index < 4; ++index)
+    EXPECT_EQ(kernels[index], kernels[0]);
+}
+
+TEST_F(FormulaCacheTest, Errors) {
+  std::string error;
+  EXPECT_TRUE(cache.getKernel(MODULE_FILE, "missingKernel", error) == nullptr);
+  EXPECT_EQ(error, "kernel missingKernel not found");
+
+  error.clear();
+  EXPECT_TRUE(cache.getKernel("", "missingKernel", error) == nullptr);
+  EXPECT_EQ(error, "kernel missingKernel not found");
+
+  error.clear();
+  EXPECT_TRUE(cache.getKernel("missing.ll", "testFunction", error) == nullptr);
+  EXPECT_EQ(error, "cannot read module missing.ll");
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
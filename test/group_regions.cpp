@@ -0,0 +1,132 @@
+#include "gtest.h"
+
+#include "SymEngine/GroupRegions.h"
+#include "SymEngine/HardwareConfig.h"
+#include "SymEngine/MemoryAccessesAnalyzer.h"
+#include "SymEngine/NDRangeSpace.h"
+#include "SymEngine/SubscriptCompiler.h"
+#include "SymEngine/Warp.h"
+
+using namespace SymEngine;
+
+class GroupRegionsTest : public ::testing::Test {
+protected:
+  GroupRegionsTest() : ndrSpace(32, 4, 1, 16, 16, 1) {
+    hwConfig = {32, 4, 32, 128};
+  }
+
+  // Transactions of all the warps of a group, simulated lane by lane.
+  int countGroup(const CompiledExpression &subscript,
+                 const std::vector<CompiledCondition> &conditions, int groupX,
+                 int groupY) const {
+    WarpFactory factory(&ndrSpace, hwConfig.warpSize);
+    int result = 0;
+    for (const Warp &warp : factory.createAllWarpsInGroup(groupX, groupY, 0)) {
+      int64_t addresses[64];
+      int addressNumber = 0;
+      for (auto iter = warp.begin(), iterEnd = warp.end(); iter != iterEnd;
+           ++iter) {
+        bool active = true;
+        for (auto &condition : conditions) {
+          int64_t value = 0;
+          condition.expression.evaluate(*iter, value);
+          active &= BlockCondition::getBooleanValue(value, condition.predicate);
+        }
+        if (active)
+          subscript.evaluate(*iter, addresses[addressNumber++]);
+      }
+      if (addressNumber > 0)
+        result += computeTransactionNumberImpl(addresses, addressNumber,
+                                               hwConfig);
+    }
+    return result;
+  }
+
+  NDRangeSpace ndrSpace;
+  HardwareConfig hwConfig;
+};
+
+// 4 * (get_global_id(1) * get_global_size(0) + get_global_id(0)), guarded by
+// get_global_id(0) < 300.
+TEST_F(GroupRegionsTest, BoundaryGroups) {
+  CompiledExpression subscript;
+  subscript.appendConstant(4);
+  subscript.appendCoordinate(CompiledExpression::GLOBAL_ID, 1);
+  subscript.appendSize(CompiledExpression::GLOBAL_SIZE, 0);
+  subscript.appendOperation(CompiledExpression::MUL, 2);
+  subscript.appendCoordinate(CompiledExpression::GLOBAL_ID, 0);
+  subscript.appendOperation(CompiledExpression::ADD, 2);
+  subscript.appendOperation(CompiledExpression::MUL, 2);
+  CompiledExpression boundSubscript = subscript.bind(ndrSpace);
+
+  CompiledCondition condition;
+  condition.expression.appendCoordinate(CompiledExpression::GLOBAL_ID, 0);
+  condition.expression.appendConstant(-300);
+  condition.expression.appendOperation(CompiledExpression::ADD, 2);
+  condition.expression = condition.expression.bind(ndrSpace);
+  condition.predicate = llvm::CmpInst::ICMP_SLT;
+  std::vector<CompiledCondition> conditions(1, condition);
+
+  std::vector<GroupRegion> regions =
+      findPeriodicRegions(boundSubscript, conditions, ndrSpace,
+                           getTranslationPeriod(hwConfig));
+  // Far fewer regions than groups.
+  EXPECT_LT(regions.size(), 16u);
+
+  // Regions cover every group once, and the counts of their groups repeat
+  // with their period.
+  std::vector<int> covered(16 * 16, 0);
+  for (const GroupRegion &region : regions) {
+    for (int groupY = region.begin[1]; groupY < region.end[1]; ++groupY) {
+      for (int groupX = region.begin[0]; groupX < region.end[0]; ++groupX) {
+        ++covered[groupY * 16 + groupX];
+        int representativeX =
+            region.begin[0] + (groupX - region.begin[0]) % region.period[0];
+        int representativeY =
+            region.begin[1] + (groupY - region.begin[1]) % region.period[1];
+        EXPECT_EQ(countGroup(boundSubscript, conditions, groupX, groupY),
+                  countGroup(boundSubscript, conditions, representativeX,
+                             representativeY));
+      }
+    }
+  }
+  for (int count : covered)
+    EXPECT_EQ(count, 1);
+}
+
+// Subscripts that do not move by a multiple of the period repeat after a
+// few groups.
+TEST_F(GroupRegionsTest, PeriodicGroups) {
+  // get_group_id(0) * 32 + get_local_id(0) * 4
+  CompiledExpression subscript;
+  subscript.appendCoordinate(CompiledExpression::GROUP_ID, 0);
+  subscript.appendConstant(8);
+  subscript.appendOperation(CompiledExpression::MUL, 2);
+  subscript.appendCoordinate(CompiledExpression::LOCAL_ID, 0);
+  subscript.appendOperation(CompiledExpression::ADD, 2);
+  subscript.appendConstant(4);
+  subscript.appendOperation(CompiledExpression::MUL, 2);
+  CompiledExpression boundSubscript = subscript.bind(ndrSpace);
+
+  std::vector<GroupRegion> regions = findPeriodicRegions(
+      boundSubscript, std::vector<CompiledCondition>(), ndrSpace,
+      getTranslationPeriod(hwConfig));
+  // The whole grid, repeating every 128 / 32 groups along x.
+  ASSERT_EQ(regions.size(), 1u);
+  EXPECT_EQ(regions[0].getGroupNumber(), 16 * 16);
+  EXPECT_EQ(regions[0].period[0], 4);
+  EXPECT_EQ(regions[0].period[1], 1);
+  EXPECT_EQ(regions[0].getRepresentativeNumber(), 4);
+
+  long total = 0;
+  for (int offset = 0; offset < 4; ++offset) {
+    int offsets[] = {offset, 0, 0};
+    total += regions[0].getMultiplicity(offsets);
+  }
+  EXPECT_EQ(total, 16 * 16);
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
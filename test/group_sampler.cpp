@@ -0,0 +1,81 @@
+#include "gtest.h"
+
+#include "SymEngine/GroupSampler.h"
+#include "SymEngine/NDRangeSpace.h"
+
+#include <cmath>
+
+using namespace SymEngine;
+
+// Value of a warp depending on the position of its group.
+static int unitValue(const SamplingUnit &unit) {
+  return (unit.groupX == 0 ? 10 : 1) + unit.warpIndex % 3;
+}
+
+static void evaluateUnits(const std::vector<SamplingUnit> &units,
+                          std::vector<int> &values) {
+  for (size_t index = 0; index < units.size(); ++index)
+    values[index] = unitValue(units[index]);
+}
+
+TEST(GroupSamplerTest, Strata) {
+  NDRangeSpace ndrSpace(32, 32, 1, 4, 4, 1);
+  GroupSampler sampler(&ndrSpace, 32, 0.05, 0);
+
+  EXPECT_EQ(sampler.getStratumSize(GroupSampler::INTERIOR), 4 * 32);
+  EXPECT_EQ(sampler.getStratumSize(GroupSampler::EDGE), 8 * 32);
+  EXPECT_EQ(sampler.getStratumSize(GroupSampler::CORNER), 4 * 32);
+
+  EXPECT_EQ(GroupSampler::getStratum(&ndrSpace, 1, 2, 0),
+            GroupSampler::INTERIOR);
+  EXPECT_EQ(GroupSampler::getStratum(&ndrSpace, 0, 2, 0), GroupSampler::EDGE);
+  EXPECT_EQ(GroupSampler::getStratum(&ndrSpace, 3, 0, 0),
+            GroupSampler::CORNER);
+}
+
+TEST(GroupSamplerTest, OneDimensionalStrata) {
+  NDRangeSpace ndrSpace(256, 1, 1, 10, 1, 1);
+  GroupSampler sampler(&ndrSpace, 8, 0.05, 0);
+
+  EXPECT_EQ(sampler.getStratumSize(GroupSampler::INTERIOR), 8 * 8);
+  EXPECT_EQ(sampler.getStratumSize(GroupSampler::EDGE), 2 * 8);
+  EXPECT_EQ(sampler.getStratumSize(GroupSampler::CORNER), 0);
+}
+
+// A zero relative error samples the whole population, giving the exact total.
+TEST(GroupSamplerTest, ExactWhenExhausted) {
+  NDRangeSpace ndrSpace(32, 8, 1, 6, 5, 1);
+  GroupSampler sampler(&ndrSpace, 8, 0, 42);
+
+  int expected = 0;
+  for (int groupY = 0; groupY < 5; ++groupY)
+    for (int groupX = 0; groupX < 6; ++groupX)
+      for (int warpIndex = 0; warpIndex < 8; ++warpIndex)
+        expected += unitValue({groupX, groupY, 0, warpIndex});
+
+  SampledEstimate estimate = sampler.estimateTotal(evaluateUnits);
+  EXPECT_EQ(estimate.sampledUnits, 6 * 5 * 8);
+  EXPECT_EQ(estimate.populationSize, 6 * 5 * 8);
+  EXPECT_DOUBLE_EQ(estimate.total, expected);
+  EXPECT_DOUBLE_EQ(estimate.halfWidth, 0);
+}
+
+TEST(GroupSamplerTest, StopsAtRelativeError) {
+  NDRangeSpace ndrSpace(32, 32, 1, 64, 64, 1);
+  GroupSampler sampler(&ndrSpace, 32, 0.01, 7);
+
+  double expected = 0;
+  for (int groupX = 0; groupX < 64; ++groupX)
+    for (int warpIndex = 0; warpIndex < 32; ++warpIndex)
+      expected += 64 * unitValue({groupX, 0, 0, warpIndex});
+
+  SampledEstimate estimate = sampler.estimateTotal(evaluateUnits);
+  EXPECT_LT(estimate.sampledUnits, estimate.populationSize);
+  EXPECT_LE(estimate.halfWidth, 0.01 * estimate.total);
+  EXPECT_LE(std::fabs(estimate.total - expected), 3 * estimate.halfWidth);
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,115 @@
+#include "gtest.h"
+
+#include "SymEngine/HardwareConfig.h"
+#include "SymEngine/MemoryAccessesAnalyzer.h"
+#include "SymEngine/ModulePipeline.h"
+#include "SymEngine/NDRangePoint.h"
+#include "SymEngine/NDRangeSpace.h"
+#include "SymEngine/SymbolicExecution.h"
+#include "SymEngine/Warp.h"
+
+#include "llvm/IR/LegacyPassManager.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+
+#include <unistd.h>
+
+using namespace llvm;
+using namespace SymEngine;
+
+// The config files of profiles/ describe the warp of index 1 in group (1, 0,
+// 0) of a 64x2 group, with two profiles of different warp and cache line
+// sizes, and the arguments 128 and 256 of testFunction.
+class HardwareProfilesTest : public ::testing::Test {
+protected:
+  HardwareProfilesTest() : ndrSpace(64, 2, 1, 2, 2, 1) {
+    profiles = {{"fermi", {32, 4, 32, 128}}, {"gcn", {32, 4, 64, 64}}};
+    initializePipeline();
+  }
+
+  // Transactions of the configured warp, with the given byte address of the
+  // work-item at (x, y).
+  template <typename Address>
+  int countTransactions(const HardwareConfig &hwConfig,
+                        Address address) const {
+    WarpFactory factory(&ndrSpace, hwConfig.warpSize);
+    Warp warp = factory.createWarp(1, 0, 0, 1);
+    int64_t addresses[64];
+    int addressNumber = 0;
+    for (NDRangePoint point : warp)
+      addresses[addressNumber++] =
+          address(point.getGlobalX(), point.getGlobalY());
+    return computeTransactionNumberImpl(addresses, addressNumber, hwConfig);
+  }
+
+  NDRangeSpace ndrSpace;
+  std::vector<HardwareProfile> profiles;
+};
+
+// Each profile counts the accesses of its own warp, as if it were the only
+// hardware of hardware_config.yaml, instead of the whole NDRange.
+TEST_F(HardwareProfilesTest, ConfiguredWarp) {
+  LLVMContext context;
+  std::string error;
+  std::unique_ptr<Module> module =
+      loadModule("../nd_range_test.ll", context, error);
+  ASSERT_TRUE(module != nullptr) << error;
+
+  // The pass manager owns the pass: it is kept alive to read its results.
+  SymbolicExecution *symbolicExecution = new SymbolicExecution();
+  legacy::PassManager passManager;
+  passManager.add(symbolicExecution);
+  passManager.run(*module);
+
+  // No kernel name is given: the results are keyed by kernel name.
+  const ModuleResults &results = symbolicExecution->moduleResults;
+  ASSERT_EQ(results.profiles.size(), 1u);
+  EXPECT_EQ(results.profiles[0].first, "testFunction");
+  const ProfileResults &kernel = results.profiles[0].second;
+  ASSERT_EQ(kernel.profiles.size(), profiles.size());
+
+  for (size_t index = 0; index < profiles.size(); ++index) {
+    const HardwareConfig &hwConfig = profiles[index].config;
+    EXPECT_EQ(kernel.profiles[index].first, profiles[index].name);
+    const KernelResults &counts = kernel.profiles[index].second;
+    EXPECT_FALSE(counts.sampling);
+    ASSERT_EQ(counts.loadTransactions.size(), 1u);
+    ASSERT_EQ(counts.storeTransactions.size(), 1u);
+    EXPECT_EQ(counts.loadTransactions[0],
+              countTransactions(hwConfig, [](int64_t x, int64_t y) {
+                return 4 * (y * 128 + x);
+              }));
+    EXPECT_EQ(counts.storeTransactions[0],
+              countTransactions(hwConfig, [](int64_t x, int64_t y) {
+                return 4 * (x * 256 + y);
+              }));
+  }
+}
+
+// The two accesses of the kernel are compiled for the first profile, then
+// counted on the warps of each profile.
+TEST_F(HardwareProfilesTest, CompiledOnce) {
+  LLVMContext context;
+  std::string error;
+  std::unique_ptr<Module> module =
+      loadModule("../nd_range_test.ll", context, error);
+  ASSERT_TRUE(module != nullptr) << error;
+
+  SymbolicExecution *symbolicExecution = new SymbolicExecution();
+  legacy::PassManager passManager;
+  passManager.add(symbolicExecution);
+  passManager.run(*module);
+
+  ASSERT_EQ(symbolicExecution->moduleResults.profiles.size(), 1u);
+  ASSERT_EQ(symbolicExecution->profileResults.profiles.size(),
+            profiles.size());
+  EXPECT_EQ(symbolicExecution->getCompilationNumber(), 2);
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  // The config files are read from the working directory.
+  if (chdir("profiles") != 0)
+    return 1;
+  return RUN_ALL_TESTS();
+}
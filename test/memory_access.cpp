@@ -62,6 +62,124 @@ TEST_F(MemoryAccessTest, EigthTransactions) {
   EXPECT_EQ(transactions, 8);
 }
 
+TEST_F(MemoryAccessTest, ScatteredTransactions) {
+  // Cache lines too far apart for the line bitset.
+  std::vector<int> accesses = {0, 32 * 1000, 5, 32 * 1000 + 31, -1,
+                               32 * 300, 1 << 30, 32 * 300 + 1};
+  EXPECT_EQ(computeTransactionNumberImpl(accesses, hwConfig), 4);
+}
+
+TEST_F(MemoryAccessTest, BatchedTransactions) {
+  const int laneNumber = 8;
+  const int warpNumber = 3;
+  int64_t addresses[warpNumber * laneNumber] = {
+      0, 4,  8,  12, 16, 20, 24, 28,   // Coalesced.
+      0, 32, 64, 96, 128, 160, 192, 224, // One line per lane, half masked.
+      0, 4,  8,  12, 16, 20, 24, 28};  // No active lane.
+  uint64_t activeMasks[warpNumber] = {0xff, 0x0f, 0};
+  int results[warpNumber];
+  computeTransactionNumbers(addresses, activeMasks, laneNumber, warpNumber,
+                            hwConfig, results);
+  EXPECT_EQ(results[0], 1);
+  EXPECT_EQ(results[1], 4);
+  EXPECT_EQ(results[2], 0);
+}
+
+TEST_F(MemoryAccessTest, NoBankConflicts) {
+  std::vector<int> accesses = {0, 4, 8, 12, 16, 20, 24, 28};
+  EXPECT_EQ(computeBankConflictNumberImpl(accesses, hwConfig), 0);
+}
+
+TEST_F(MemoryAccessTest, BankConflicts) {
+  // Same bank, four different rows.
+  std::vector<int> accesses = {0, 128, 256, 384, 0, 128, 256, 384};
+  EXPECT_EQ(computeBankConflictNumberImpl(accesses, hwConfig), 3);
+
+  // Rows too far apart for the bank histogram: bank 0, rows 0, 1000, 70.
+  std::vector<int> sparseAccesses = {0, 128 * 1000, 0, 32, 32 + 128 * 70};
+  EXPECT_EQ(computeBankConflictNumberImpl(sparseAccesses, hwConfig), 2);
+}
+
+TEST_F(MemoryAccessTest, BatchedBankConflicts) {
+  const int laneNumber = 8;
+  const int warpNumber = 3;
+  int64_t addresses[warpNumber * laneNumber] = {
+      0, 128, 256, 384, 4, 8,  12, 16,  // Two conflicts in the first half.
+      0, 128, 256, 384, 4, 8,  12, 16,  // Same addresses, half masked.
+      -1, 0,  31,  1,   2, 32, 64, 96}; // Negative columns.
+  uint64_t activeMasks[warpNumber] = {0xff, 0xf0, 0xff};
+  int results[warpNumber];
+  computeBankConflictNumbers(addresses, activeMasks, laneNumber, warpNumber,
+                             hwConfig, results);
+
+  for (int warp = 0; warp < warpNumber; ++warp) {
+    std::vector<int> active;
+    for (int lane = 0; lane < laneNumber; ++lane)
+      if ((activeMasks[warp] >> lane) & 1)
+        active.push_back(addresses[warp * laneNumber + lane]);
+    EXPECT_EQ(results[warp], computeBankConflictNumberImpl(active, hwConfig));
+  }
+  EXPECT_EQ(results[0], 3);
+  EXPECT_EQ(results[1], 0);
+}
+
+// The strided counts must match the enumeration of the addresses.
+TEST_F(MemoryAccessTest, StridedAccesses) {
+  HardwareConfig configs[] = {hwConfig, {32, 4, 32, 128}, {16, 8, 64, 64}};
+  int64_t bases[] = {0, 3, 100, 1000, 40};
+  int64_t strides[] = {-33, -4, -1, 0, 1, 2, 3, 4, 5, 8, 12,
+                       16, 31, 32, 33, 64, 96, 128, 132, 256};
+  uint64_t masks[] = {~0ull, 0ull, 0xffull, 0xff00ull, 0x1ull,
+                      0x8000000000000000ull, 0xf0f0ull, 0x7fffffffull};
+
+  for (auto &config : configs) {
+    for (int64_t base : bases) {
+      for (int64_t stride : strides) {
+        for (uint64_t mask : masks) {
+          int laneNumber = config.warpSize;
+          int64_t addresses[64];
+          int addressNumber = 0;
+          for (int lane = 0; lane < laneNumber; ++lane)
+            if ((mask >> lane) & 1)
+              addresses[addressNumber++] = base + stride * lane;
+
+          EXPECT_EQ(computeStridedTransactionNumber(base, stride, laneNumber,
+                                                    mask, config),
+                    computeTransactionNumberImpl(addresses, addressNumber,
+                                                 config));
+          EXPECT_EQ(computeStridedBankConflictNumber(base, stride, laneNumber,
+                                                     mask, config),
+                    computeBankConflictNumberImpl(addresses, addressNumber,
+                                                  config));
+        }
+      }
+    }
+  }
+}
+
+// Shifting non negative addresses by the translation period keeps the counts.
+TEST_F(MemoryAccessTest, TranslatedAccesses) {
+  HardwareConfig configs[] = {hwConfig, {32, 4, 32, 128}, {16, 8, 64, 48}};
+  int64_t pattern[] = {0, 4, 200, 12, 16, 516, 24, 28,
+                       3, 64, 65, 66, 1000, 7, 13, 128};
+
+  for (auto &config : configs) {
+    int64_t period = getTranslationPeriod(config);
+    EXPECT_EQ(period % config.cacheLineSize, 0);
+    EXPECT_EQ(period % (config.banksNumber * config.bankWidth), 0);
+
+    int64_t shifted[16];
+    for (int64_t shift : {period, 3 * period, 1000 * period}) {
+      for (int index = 0; index < 16; ++index)
+        shifted[index] = pattern[index] + shift;
+      EXPECT_EQ(computeTransactionNumberImpl(shifted, 16, config),
+                computeTransactionNumberImpl(pattern, 16, config));
+      EXPECT_EQ(computeBankConflictNumberImpl(shifted, 16, config),
+                computeBankConflictNumberImpl(pattern, 16, config));
+    }
+  }
+}
+
 int main(int argc, char **argv) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
@@ -1,6 +1,7 @@
 #include "gtest.h"
 
 #include "SymEngine/NDRange.h"
+#include "SymEngine/Utils.h"
 
 #include "llvm/ExecutionEngine/ExecutionEngine.h"
 
@@ -65,6 +66,17 @@ TEST_F(NDRangeTest, TestGlobalIds) {
   EXPECT_EQ(globalIds2.size(), 0);
 }
 
+TEST_F(NDRangeTest, TestKernels) {
+  Function *testFunction = module->getFunction("testFunction");
+  EXPECT_NE(testFunction, nullptr);
+  EXPECT_TRUE(isKernel(*testFunction));
+
+  // Declarations of OpenCL builtins are not kernels.
+  Function *globalId = module->getFunction("get_global_id");
+  EXPECT_NE(globalId, nullptr);
+  EXPECT_FALSE(isKernel(*globalId));
+}
+
 int main(int argc, char **argv) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
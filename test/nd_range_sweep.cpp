@@ -0,0 +1,101 @@
+#include "gtest.h"
+
+#include "SymEngine/AccessFormula.h"
+#include "SymEngine/HardwareConfig.h"
+#include "SymEngine/NDRangeSweep.h"
+#include "SymEngine/ThreadPool.h"
+
+using namespace SymEngine;
+
+class NDRangeSweepTest : public ::testing::Test {
+protected:
+  NDRangeSweepTest() : threadPool(2) {
+    hwConfig = {32, 4, 32, 128};
+
+    // Local sizes 8 to 64 by 1, 2 and 4 over a global size of 128 by 8, with
+    // at most 128 work-items per group.
+    config = SweepConfig();
+    config.localSize[0].min = 8;
+    config.localSize[0].max = 64;
+    config.localSize[1].values = {1, 2, 4};
+    config.globalSize = {128, 8, 1};
+    config.maxGroupSize = 128;
+  }
+
+  HardwareConfig hwConfig;
+  ThreadPool threadPool;
+  SweepConfig config;
+};
+
+TEST_F(NDRangeSweepTest, Candidates) {
+  std::vector<SweepCandidate> candidates = createSweepCandidates(config);
+  ASSERT_EQ(candidates.size(), 11u);
+
+  EXPECT_EQ(candidates.front().ndrSpace.getLocalSizeX(), 8);
+  EXPECT_EQ(candidates.front().ndrSpace.getNumberOfGroupsX(), 16);
+  EXPECT_EQ(candidates.front().ndrSpace.getNumberOfGroupsY(), 8);
+  EXPECT_EQ(candidates.back().ndrSpace.getLocalSizeX(), 32);
+  EXPECT_EQ(candidates.back().ndrSpace.getLocalSizeY(), 4);
+  for (const SweepCandidate &candidate : candidates) {
+    EXPECT_LE(candidate.ndrSpace.getGroupSize(), 128);
+    EXPECT_EQ(candidate.ndrSpace.getGlobalSizeX(), 128);
+    EXPECT_EQ(candidate.ndrSpace.getGlobalSizeY(), 8);
+  }
+
+  // Without a global size every number of groups is combined with every
+  // local size.
+  config.globalSize.clear();
+  config.numberOfGroups[0].values = {1, 2};
+  config.numberOfGroups[1].min = 1;
+  config.numberOfGroups[1].max = 4;
+  EXPECT_EQ(createSweepCandidates(config).size(), 11u * 2 * 3);
+}
+
+// 4 * (get_global_id(1) * 128 + get_global_id(0)): groups narrower than a
+// warp split it over several rows.
+TEST_F(NDRangeSweepTest, Ranking) {
+  AccessFormula formula;
+  formula.isLoad = true;
+  formula.isLocal = false;
+  formula.subscript.appendConstant(4);
+  formula.subscript.appendCoordinate(CompiledExpression::GLOBAL_ID, 1);
+  formula.subscript.appendConstant(128);
+  formula.subscript.appendOperation(CompiledExpression::MUL, 2);
+  formula.subscript.appendCoordinate(CompiledExpression::GLOBAL_ID, 0);
+  formula.subscript.appendOperation(CompiledExpression::ADD, 2);
+  formula.subscript.appendOperation(CompiledExpression::MUL, 2);
+  formula.tripCount.appendConstant(1);
+  KernelFormulas kernel;
+  kernel.kernelName = "rows";
+  kernel.accesses.push_back(formula);
+
+  std::vector<SweepCandidate> candidates = createSweepCandidates(config);
+  evaluateSweep(kernel, std::vector<int64_t>(), hwConfig, threadPool,
+                candidates);
+
+  // Groups of 8 and 16 work-items do not fill a warp.
+  ASSERT_EQ(candidates.size(), 8u);
+  for (size_t index = 0; index < candidates.size(); ++index) {
+    const SweepCandidate &candidate = candidates[index];
+    EXPECT_EQ(candidate.unknownAccesses, 0);
+    EXPECT_EQ(candidate.transactions,
+              evaluateAccessFormula(formula, std::vector<int64_t>(),
+                                    &candidate.ndrSpace, hwConfig,
+                                    threadPool));
+    if (index > 0) {
+      EXPECT_LE(candidates[index - 1].transactions, candidate.transactions);
+    }
+  }
+
+  // One row per warp; ties keep the order of the sweep.
+  EXPECT_EQ(candidates.front().transactions, 32);
+  EXPECT_EQ(candidates.front().ndrSpace.getLocalSizeX(), 32);
+  EXPECT_EQ(candidates.front().ndrSpace.getLocalSizeY(), 1);
+  EXPECT_EQ(candidates.back().transactions, 128);
+  EXPECT_EQ(candidates.back().ndrSpace.getLocalSizeX(), 8);
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,76 @@
+#include "gtest.h"
+
+#include "SymEngine/ResultCache.h"
+
+#include "llvm/Support/FileSystem.h"
+
+#include <ctime>
+
+#include <sys/time.h>
+
+using namespace SymEngine;
+
+static const char CACHE_DIRECTORY[] = "result_cache_test";
+
+class ResultCacheTest : public ::testing::Test {
+protected:
+  ResultCacheTest() : counts({12, -1, 3}), errors({0, 0, 1}) {
+    llvm::sys::fs::remove_directories(CACHE_DIRECTORY);
+  }
+  ~ResultCacheTest() { llvm::sys::fs::remove_directories(CACHE_DIRECTORY); }
+
+  // Set the time of the last use of the entry of key.
+  static void setLastUse(const ResultCache &cache, const std::string &key,
+                         time_t time) {
+    timeval times[2] = {{time, 0}, {time, 0}};
+    ASSERT_EQ(utimes(cache.getEntryPath(key).c_str(), times), 0);
+  }
+
+  std::vector<int> counts;
+  std::vector<int> errors;
+};
+
+TEST_F(ResultCacheTest, StoreAndLookup) {
+  ResultCache cache(CACHE_DIRECTORY, 1 << 20);
+  std::vector<int> cachedCounts;
+  std::vector<int> cachedErrors;
+  EXPECT_FALSE(cache.lookup("kernel", 3, cachedCounts, cachedErrors));
+
+  cache.store("kernel", counts, errors);
+  ASSERT_TRUE(cache.lookup("kernel", 3, cachedCounts, cachedErrors));
+  EXPECT_EQ(cachedCounts, counts);
+  EXPECT_EQ(cachedErrors, errors);
+
+  // Another key or another number of accesses is a miss.
+  EXPECT_FALSE(cache.lookup("kernel2", 3, cachedCounts, cachedErrors));
+  EXPECT_FALSE(cache.lookup("kernel", 2, cachedCounts, cachedErrors));
+
+  // Entries are shared by the caches on the same directory.
+  ResultCache otherCache(CACHE_DIRECTORY, 1 << 20);
+  EXPECT_TRUE(otherCache.lookup("kernel", 3, cachedCounts, cachedErrors));
+}
+
+TEST_F(ResultCacheTest, LeastRecentlyUsedEviction) {
+  // Room for two entries of three accesses.
+  ResultCache cache(CACHE_DIRECTORY, 2 * (32 + 6 * 4));
+  time_t now = time(nullptr);
+  cache.store("first", counts, errors);
+  setLastUse(cache, "first", now - 100);
+  cache.store("second", counts, errors);
+  setLastUse(cache, "second", now - 50);
+
+  // The lookup makes the first entry more recent than the second.
+  std::vector<int> cachedCounts;
+  std::vector<int> cachedErrors;
+  EXPECT_TRUE(cache.lookup("first", 3, cachedCounts, cachedErrors));
+  cache.store("third", counts, errors);
+
+  EXPECT_TRUE(cache.lookup("first", 3, cachedCounts, cachedErrors));
+  EXPECT_FALSE(cache.lookup("second", 3, cachedCounts, cachedErrors));
+  EXPECT_TRUE(cache.lookup("third", 3, cachedCounts, cachedErrors));
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
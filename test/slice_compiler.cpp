@@ -0,0 +1,185 @@
+#include "gtest.h"
+
+#include "SymEngine/BlockMask.h"
+#include "SymEngine/ControlDependenceAnalysis.h"
+#include "SymEngine/HardwareConfig.h"
+#include "SymEngine/MemoryAccessesAnalyzer.h"
+#include "SymEngine/ModulePipeline.h"
+#include "SymEngine/NDRange.h"
+#include "SymEngine/NDRangePoint.h"
+#include "SymEngine/NDRangeSpace.h"
+#include "SymEngine/OCLEnv.h"
+#include "SymEngine/SliceCompiler.h"
+#include "SymEngine/ThreadPool.h"
+#include "SymEngine/Warp.h"
+#include "SymEngine/WarpEvaluator.h"
+#include "SymEngine/WarpSimulator.h"
+
+#include "llvm/Analysis/ScalarEvolution.h"
+
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+
+#include "llvm/Support/raw_ostream.h"
+
+using namespace llvm;
+using namespace SymEngine;
+
+// Slices of the memory accesses of a kernel, in the order of the kernel,
+// with everything they depend on.
+struct KernelSlices {
+  std::unique_ptr<const OCLEnv> ocl;
+  std::unique_ptr<BlockMask> blockMask;
+  std::unique_ptr<SliceCompiler> compiler;
+  std::vector<WarpSlice> slices;
+};
+
+// Compile the slice of every load and store of the kernel.
+class SliceCompilerPass : public FunctionPass {
+public:
+  static char ID;
+  SliceCompilerPass(const NDRangeSpace &ndrSpace,
+                    const HardwareConfig &hwConfig, KernelSlices *output)
+      : FunctionPass(ID), ndrSpace(ndrSpace), hwConfig(hwConfig),
+        output(output) {}
+
+  virtual bool runOnFunction(Function &function) {
+    output->ocl.reset(new OCLEnv(function, &getAnalysis<NDRange>(), ndrSpace,
+                                 hwConfig));
+    output->blockMask.reset(
+        new BlockMask(&function, &getAnalysis<ControlDependenceAnalysis>(),
+                      &getAnalysis<ScalarEvolution>()));
+    output->blockMask->createMasks();
+    output->compiler.reset(new SliceCompiler(*output->ocl, *output->blockMask));
+
+    for (BasicBlock &block : function) {
+      for (Instruction &inst : block) {
+        if (LoadInst *load = dyn_cast<LoadInst>(&inst))
+          output->slices.push_back(
+              output->compiler->compile(load, load->getPointerOperand()));
+        else if (StoreInst *store = dyn_cast<StoreInst>(&inst))
+          output->slices.push_back(
+              output->compiler->compile(store, store->getPointerOperand()));
+      }
+    }
+    return false;
+  }
+
+  virtual void getAnalysisUsage(AnalysisUsage &au) const {
+    au.addRequired<ScalarEvolution>();
+    au.addRequired<NDRange>();
+    au.addRequired<ControlDependenceAnalysis>();
+    au.setPreservesAll();
+  }
+
+private:
+  NDRangeSpace ndrSpace;
+  HardwareConfig hwConfig;
+  KernelSlices *output;
+};
+
+char SliceCompilerPass::ID = 0;
+
+// The accesses of slice_compiler_test.ll are executed by the work-items with
+// odd x and even y.
+static bool isActive(const NDRangePoint &point) {
+  return point.getGlobalX() % 2 == 1 && point.getGlobalY() % 2 == 0;
+}
+
+// Offset from its base pointer of the access of an active work-item.
+static int64_t getAddress(size_t access, const NDRangePoint &point) {
+  int64_t neighbour = point.getLocalX() ^ 1;
+  switch (access) {
+  case 1:
+    return 4 * neighbour;
+  case 2:
+    return 4 * (8 + neighbour);
+  default:
+    return 4 * ((point.getGlobalX() ^ point.getGlobalY()) +
+                1024 / point.getLocalX());
+  }
+}
+
+class SliceCompilerTest : public ::testing::Test {
+protected:
+  SliceCompilerTest() : ndrSpace(32, 2, 1, 2, 2, 1), threadPool(2) {
+    hwConfig = {32, 4, 32, 128};
+    initializePipeline();
+  }
+
+  std::vector<Warp> getAllWarps() const {
+    WarpFactory factory(&ndrSpace, hwConfig.warpSize);
+    std::vector<Warp> warps;
+    for (int groupY = 0; groupY < ndrSpace.getNumberOfGroupsY(); ++groupY) {
+      for (int groupX = 0; groupX < ndrSpace.getNumberOfGroupsX(); ++groupX) {
+        std::vector<Warp> groupWarps =
+            factory.createAllWarpsInGroup(groupX, groupY, 0);
+        warps.insert(warps.end(), groupWarps.begin(), groupWarps.end());
+      }
+    }
+    return warps;
+  }
+
+  NDRangeSpace ndrSpace;
+  HardwareConfig hwConfig;
+  ThreadPool threadPool;
+};
+
+// The data accesses use an xor and a division by the local id, which is 0 for
+// inactive lanes; the tile accesses index a __local array, directly and after
+// decay. The block is controlled by branches on i1 values, not comparisons,
+// one of them taken when its condition is false.
+TEST_F(SliceCompilerTest, MatchesBruteForce) {
+  LLVMContext context;
+  std::string error;
+  std::unique_ptr<Module> module =
+      loadModule("slice_compiler_test.ll", context, error);
+  ASSERT_TRUE(module != nullptr) << error;
+
+  KernelSlices kernel;
+  runPipeline(*module, new SliceCompilerPass(ndrSpace, hwConfig, &kernel));
+  ASSERT_EQ(kernel.slices.size(), 4u);
+
+  std::vector<Warp> warps = getAllWarps();
+  WarpSimulator simulator(&ndrSpace, hwConfig, threadPool);
+  for (size_t access = 0; access < kernel.slices.size(); ++access) {
+    WarpSlice slice = kernel.slices[access];
+    ASSERT_TRUE(slice != nullptr) << "access " << access;
+    bool isLocal = access == 1 || access == 2;
+
+    int expected = 0;
+    for (const Warp &warp : warps) {
+      LaneCoordinates lanes(warp);
+      int64_t addresses[LaneCoordinates::MAX_LANE_NUMBER];
+      uint64_t activeMask = 0;
+      slice(&lanes, addresses, &activeMask);
+
+      int64_t activeAddresses[LaneCoordinates::MAX_LANE_NUMBER];
+      int activeNumber = 0;
+      for (int lane = 0; lane < lanes.laneNumber; ++lane) {
+        NDRangePoint point = warp.getPoint(lane);
+        bool active = isActive(point);
+        EXPECT_EQ((activeMask >> lane) & 1, uint64_t(active));
+        if (!active)
+          continue;
+        EXPECT_EQ(addresses[lane], getAddress(access, point));
+        activeAddresses[activeNumber++] = getAddress(access, point);
+      }
+      expected += isLocal ? computeBankConflictNumberImpl(
+                                activeAddresses, activeNumber, hwConfig)
+                          : computeTransactionNumberImpl(
+                                activeAddresses, activeNumber, hwConfig);
+    }
+
+    EXPECT_EQ(simulator.countSliceAccessesInNDRange(
+                  slice, isLocal ? WarpSimulator::BANK_CONFLICTS
+                                 : WarpSimulator::TRANSACTIONS),
+              expected);
+  }
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
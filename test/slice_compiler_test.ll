@@ -0,0 +1,43 @@
+target triple = "spir"
+
+@tile = internal addrspace(3) global [64 x float] zeroinitializer, align 4
+
+define void @sliceKernel(float addrspace(1)* %data) {
+entry:
+  %x = call i32 @get_global_id(i32 0)
+  %y = call i32 @get_global_id(i32 1)
+  %lid = call i32 @get_local_id(i32 0)
+  %xBit = and i32 %x, 1
+  %xOdd = trunc i32 %xBit to i1
+  br i1 %xOdd, label %odd, label %exit
+
+odd:
+  %yBit = and i32 %y, 1
+  %yOdd = trunc i32 %yBit to i1
+  br i1 %yOdd, label %exit, label %access
+
+access:
+  %xor = xor i32 %x, %y
+  %quotient = udiv i32 1024, %lid
+  %index = add i32 %xor, %quotient
+  %address = getelementptr inbounds float addrspace(1)* %data, i32 %index
+  %value = load float addrspace(1)* %address, align 4
+  %neighbour = xor i32 %lid, 1
+  %tileAddress = getelementptr inbounds [64 x float] addrspace(3)* @tile, i32 0, i32 %neighbour
+  store float %value, float addrspace(3)* %tileAddress, align 4
+  %rowAddress = getelementptr inbounds float addrspace(3)* getelementptr inbounds ([64 x float] addrspace(3)* @tile, i32 0, i32 8), i32 %neighbour
+  %tileValue = load float addrspace(3)* %rowAddress, align 4
+  store float %tileValue, float addrspace(1)* %address, align 4
+  br label %exit
+
+exit:
+  ret void
+}
+
+declare i32 @get_global_id(i32)
+
+declare i32 @get_local_id(i32)
+
+!opencl.kernels = !{!0}
+
+!0 = !{void (float addrspace(1)*)* @sliceKernel}
@@ -0,0 +1,189 @@
+#include "gtest.h"
+
+#include "SymEngine/SymEngineC.h"
+
+#include "SymEngine/AccessFormula.h"
+#include "SymEngine/HardwareConfig.h"
+#include "SymEngine/ModulePipeline.h"
+#include "SymEngine/NDRangeSpace.h"
+#include "SymEngine/ThreadPool.h"
+#include "SymEngine/Utils.h"
+
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+
+#include <thread>
+
+using namespace SymEngine;
+
+class SymEngineCTest : public ::testing::Test {
+protected:
+  SymEngineCTest()
+      : text(readFile("nd_range_test.ll")), module(nullptr), kernel(nullptr) {
+    ndRange = {{32, 2, 1}, {4, 8, 1}};
+    hardware = {32, 4, 32, 128};
+  }
+
+  virtual void SetUp() {
+    ASSERT_EQ(SymEngineParseModule(text.data(), text.size(), 2, &module),
+              SYM_ENGINE_SUCCESS);
+    ASSERT_EQ(SymEngineGetKernel(module, "testFunction", &kernel),
+              SYM_ENGINE_SUCCESS);
+  }
+
+  virtual void TearDown() { SymEngineDisposeModule(module); }
+
+  // Counts of the kernel as computed from its formulas, in the order of the
+  // kernel: the load, then the store.
+  std::vector<int> getExpectedCounts(const SymEngineNDRange &range,
+                                     const std::vector<int64_t> &arguments) {
+    llvm::LLVMContext context;
+    std::string error;
+    std::unique_ptr<llvm::Module> llvmModule =
+        parseModule(text, context, error);
+    std::vector<KernelFormulas> formulas = compileModuleFormulas(*llvmModule);
+    NDRangeSpace ndrSpace(range.localSize[0], range.localSize[1],
+                          range.localSize[2], range.numberOfGroups[0],
+                          range.numberOfGroups[1], range.numberOfGroups[2]);
+    HardwareConfig hwConfig = {hardware.banksNumber, hardware.bankWidth,
+                               hardware.warpSize, hardware.cacheLineSize};
+    ThreadPool threadPool(1);
+    KernelResults results = evaluateKernelFormulas(
+        formulas[0], arguments, &ndrSpace, hwConfig, threadPool);
+    return {results.loadTransactions[0], results.storeTransactions[0]};
+  }
+
+  std::string text;
+  SymEngineModuleRef module;
+  SymEngineKernelRef kernel;
+  SymEngineNDRange ndRange;
+  SymEngineHardware hardware;
+};
+
+TEST_F(SymEngineCTest, Kernels) {
+  ASSERT_EQ(SymEngineGetKernelNumber(module), 1u);
+  EXPECT_EQ(SymEngineGetKernelAt(module, 0), kernel);
+  EXPECT_TRUE(SymEngineGetKernelAt(module, 1) == nullptr);
+  EXPECT_STREQ(SymEngineGetKernelName(kernel), "testFunction");
+  EXPECT_EQ(SymEngineGetAccessNumber(kernel), 2u);
+
+  SymEngineModuleRef fileModule = nullptr;
+  ASSERT_EQ(SymEngineLoadModule("nd_range_test.ll", 1, &fileModule),
+            SYM_ENGINE_SUCCESS);
+  EXPECT_EQ(SymEngineGetKernelNumber(fileModule), 1u);
+  SymEngineDisposeModule(fileModule);
+}
+
+TEST_F(SymEngineCTest, Errors) {
+  SymEngineModuleRef otherModule = nullptr;
+  EXPECT_EQ(SymEngineParseModule(nullptr, 0, 1, &otherModule),
+            SYM_ENGINE_INVALID_ARGUMENT);
+  EXPECT_EQ(SymEngineParseModule(text.data(), text.size(), 1, nullptr),
+            SYM_ENGINE_INVALID_ARGUMENT);
+  EXPECT_EQ(SymEngineLoadModule(nullptr, 1, &otherModule),
+            SYM_ENGINE_INVALID_ARGUMENT);
+  const char malformed[] = "define void @broken(";
+  EXPECT_EQ(SymEngineParseModule(malformed, sizeof(malformed) - 1, 1,
+                                 &otherModule),
+            SYM_ENGINE_INVALID_MODULE);
+  EXPECT_EQ(SymEngineLoadModule("missing.ll", 1, &otherModule),
+            SYM_ENGINE_INVALID_MODULE);
+
+  SymEngineKernelRef otherKernel = nullptr;
+  EXPECT_EQ(SymEngineGetKernel(module, "missingKernel", &otherKernel),
+            SYM_ENGINE_KERNEL_NOT_FOUND);
+  EXPECT_EQ(SymEngineGetKernel(nullptr, "testFunction", &otherKernel),
+            SYM_ENGINE_INVALID_ARGUMENT);
+  EXPECT_EQ(SymEngineGetKernel(module, nullptr, &otherKernel),
+            SYM_ENGINE_INVALID_ARGUMENT);
+
+  int64_t arguments[] = {64, 32};
+  SymEngineAccessCount counts[2];
+  EXPECT_EQ(SymEngineEvaluate(nullptr, &ndRange, arguments, 2, &hardware,
+                              counts),
+            SYM_ENGINE_INVALID_ARGUMENT);
+  EXPECT_EQ(SymEngineEvaluate(kernel, nullptr, arguments, 2, &hardware,
+                              counts),
+            SYM_ENGINE_INVALID_ARGUMENT);
+  EXPECT_EQ(SymEngineEvaluate(kernel, &ndRange, nullptr, 2, &hardware,
+                              counts),
+            SYM_ENGINE_INVALID_ARGUMENT);
+  EXPECT_EQ(SymEngineEvaluate(kernel, &ndRange, arguments, 2, nullptr,
+                              counts),
+            SYM_ENGINE_INVALID_ARGUMENT);
+  EXPECT_EQ(SymEngineEvaluate(kernel, &ndRange, arguments, 2, &hardware,
+                              nullptr),
+            SYM_ENGINE_INVALID_ARGUMENT);
+
+  SymEngineNDRange emptyRange = ndRange;
+  emptyRange.numberOfGroups[1] = 0;
+  EXPECT_EQ(SymEngineEvaluate(kernel, &emptyRange, arguments, 2, &hardware,
+                              counts),
+            SYM_ENGINE_INVALID_ARGUMENT);
+
+  SymEngineHardware wideHardware = hardware;
+  wideHardware.warpSize = 65;
+  EXPECT_EQ(SymEngineEvaluate(kernel, &ndRange, arguments, 2, &wideHardware,
+                              counts),
+            SYM_ENGINE_UNSUPPORTED_WARP_SIZE);
+
+  for (SymEngineStatus status :
+       {SYM_ENGINE_SUCCESS, SYM_ENGINE_INVALID_ARGUMENT,
+        SYM_ENGINE_INVALID_MODULE, SYM_ENGINE_KERNEL_NOT_FOUND,
+        SYM_ENGINE_UNSUPPORTED_WARP_SIZE})
+    EXPECT_TRUE(SymEngineGetStatusString(status) != nullptr);
+}
+
+TEST_F(SymEngineCTest, MatchesFormulas) {
+  int64_t arguments[] = {64, 32};
+  SymEngineAccessCount counts[2];
+  ASSERT_EQ(SymEngineEvaluate(kernel, &ndRange, arguments, 2, &hardware,
+                              counts),
+            SYM_ENGINE_SUCCESS);
+
+  std::vector<int> expected = getExpectedCounts(ndRange, {64, 32});
+  EXPECT_TRUE(counts[0].isLoad);
+  EXPECT_FALSE(counts[1].isLoad);
+  for (int index = 0; index < 2; ++index) {
+    EXPECT_FALSE(counts[index].isLocal);
+    EXPECT_EQ(counts[index].count, expected[index]);
+  }
+
+  // Without the values of the arguments the subscripts cannot be computed.
+  ASSERT_EQ(SymEngineEvaluate(kernel, &ndRange, nullptr, 0, &hardware, counts),
+            SYM_ENGINE_SUCCESS);
+  EXPECT_EQ(counts[0].count, -1);
+  EXPECT_EQ(counts[1].count, -1);
+}
+
+TEST_F(SymEngineCTest, ConcurrentEvaluations) {
+  // Each thread evaluates the same kernel handle with its own arguments.
+  const int THREAD_NUMBER = 4;
+  std::vector<std::vector<int>> expected;
+  for (int thread = 0; thread < THREAD_NUMBER; ++thread)
+    expected.push_back(getExpectedCounts(ndRange, {64 << thread, 32}));
+
+  SymEngineAccessCount counts[THREAD_NUMBER][2];
+  SymEngineStatus statuses[THREAD_NUMBER];
+  std::vector<std::thread> threads;
+  for (int thread = 0; thread < THREAD_NUMBER; ++thread)
+    threads.emplace_back([&, thread]() {
+      int64_t arguments[] = {64 << thread, 32};
+      for (int repetition = 0; repetition < 8; ++repetition)
+        statuses[thread] = SymEngineEvaluate(kernel, &ndRange, arguments, 2,
+                                             &hardware, counts[thread]);
+    });
+  for (std::thread &thread : threads)
+    thread.join();
+
+  for (int thread = 0; thread < THREAD_NUMBER; ++thread) {
+    EXPECT_EQ(statuses[thread], SYM_ENGINE_SUCCESS);
+    EXPECT_EQ(counts[thread][0].count, expected[thread][0]);
+    EXPECT_EQ(counts[thread][1].count, expected[thread][1]);
+  }
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,57 @@
+#include "gtest.h"
+
+#include "SymEngine/ThreadPool.h"
+
+#include <numeric>
+
+using namespace SymEngine;
+
+TEST(ThreadPoolTest, AllIterationsExecuted) {
+  ThreadPool threadPool(4);
+  EXPECT_EQ(threadPool.getThreadNumber(), 4u);
+
+  std::vector<int> results(1000, 0);
+  threadPool.parallelFor(results.size(),
+                         [&results](size_t index) { results[index] += index; });
+
+  for (size_t index = 0; index < results.size(); ++index)
+    EXPECT_EQ(results[index], static_cast<int>(index));
+}
+
+TEST(ThreadPoolTest, RepeatedLoops) {
+  ThreadPool threadPool(3);
+  std::vector<int> results(64, 0);
+  for (int loop = 0; loop < 100; ++loop)
+    threadPool.parallelFor(results.size(),
+                           [&results](size_t index) { ++results[index]; });
+
+  int sum = std::accumulate(results.begin(), results.end(), 0);
+  EXPECT_EQ(sum, 64 * 100);
+}
+
+TEST(ThreadPoolTest, SingleThread) {
+  ThreadPool threadPool(1);
+  int sum = 0;
+  threadPool.parallelFor(10, [&sum](size_t index) { sum += index; });
+  EXPECT_EQ(sum, 45);
+}
+
+// Loops started from the body of another loop share the same threads.
+TEST(ThreadPoolTest, NestedLoops) {
+  ThreadPool threadPool(4);
+  std::vector<std::vector<int>> results(16, std::vector<int>(100, 0));
+  threadPool.parallelFor(results.size(), [&](size_t outer) {
+    threadPool.parallelFor(results[outer].size(), [&](size_t inner) {
+      results[outer][inner] = outer * inner;
+    });
+  });
+
+  for (size_t outer = 0; outer < results.size(); ++outer)
+    for (size_t inner = 0; inner < results[outer].size(); ++inner)
+      EXPECT_EQ(results[outer][inner], static_cast<int>(outer * inner));
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,241 @@
+#include "gtest.h"
+
+#include "SymEngine/HardwareConfig.h"
+#include "SymEngine/MemoryAccessesAnalyzer.h"
+#include "SymEngine/NDRangeSpace.h"
+#include "SymEngine/ThreadPool.h"
+#include "SymEngine/Warp.h"
+#include "SymEngine/WarpSimulator.h"
+
+#include <limits>
+
+using namespace SymEngine;
+
+static const int GLOBAL_ID_X =
+    CompiledExpression::getCoordinateIndex(CompiledExpression::GLOBAL_ID, 0);
+static const int GLOBAL_ID_Y =
+    CompiledExpression::getCoordinateIndex(CompiledExpression::GLOBAL_ID, 1);
+
+// 4 * (get_global_id(1) * 128 + get_global_id(0)), guarded by
+// get_global_id(0) < 100, as emitted by SliceCompiler.
+static void affineSlice(const LaneCoordinates *lanes, int64_t *addresses,
+                        uint64_t *activeMask) {
+  *activeMask = 0;
+  for (int lane = 0; lane < lanes->laneNumber; ++lane) {
+    int64_t x = lanes->values[GLOBAL_ID_X][lane];
+    int64_t y = lanes->values[GLOBAL_ID_Y][lane];
+    addresses[lane] = 4 * (y * 128 + x);
+    if (x < 100)
+      *activeMask |= uint64_t(1) << lane;
+  }
+}
+
+// 4 * (get_global_id(0) ^ get_global_id(1)): not an expression of the
+// coordinates.
+static void xorSlice(const LaneCoordinates *lanes, int64_t *addresses,
+                     uint64_t *activeMask) {
+  *activeMask = 0;
+  for (int lane = 0; lane < lanes->laneNumber; ++lane) {
+    addresses[lane] = 4 * (lanes->values[GLOBAL_ID_X][lane] ^
+                           lanes->values[GLOBAL_ID_Y][lane]);
+    *activeMask |= uint64_t(1) << lane;
+  }
+}
+
+class WarpSimulatorTest : public ::testing::Test {
+protected:
+  WarpSimulatorTest() : ndrSpace(32, 4, 1, 128, 8, 1), threadPool(2) {
+    hwConfig = {32, 4, 32, 128};
+  }
+
+  std::vector<Warp> getAllWarps() const {
+    WarpFactory factory(&ndrSpace, hwConfig.warpSize);
+    std::vector<Warp> warps;
+    for (int groupY = 0; groupY < ndrSpace.getNumberOfGroupsY(); ++groupY) {
+      for (int groupX = 0; groupX < ndrSpace.getNumberOfGroupsX(); ++groupX) {
+        std::vector<Warp> groupWarps =
+            factory.createAllWarpsInGroup(groupX, groupY, 0);
+        warps.insert(warps.end(), groupWarps.begin(), groupWarps.end());
+      }
+    }
+    return warps;
+  }
+
+  NDRangeSpace ndrSpace;
+  HardwareConfig hwConfig;
+  ThreadPool threadPool;
+};
+
+TEST_F(WarpSimulatorTest, SliceMatchesExpression) {
+  CompiledExpression subscript;
+  subscript.appendConstant(4);
+  subscript.appendCoordinate(CompiledExpression::GLOBAL_ID, 1);
+  subscript.appendConstant(128);
+  subscript.appendOperation(CompiledExpression::MUL, 2);
+  subscript.appendCoordinate(CompiledExpression::GLOBAL_ID, 0);
+  subscript.appendOperation(CompiledExpression::ADD, 2);
+  subscript.appendOperation(CompiledExpression::MUL, 2);
+  subscript = subscript.bind(ndrSpace);
+
+  CompiledCondition condition;
+  condition.expression.appendCoordinate(CompiledExpression::GLOBAL_ID, 0);
+  condition.expression.appendConstant(-100);
+  condition.expression.appendOperation(CompiledExpression::ADD, 2);
+  condition.expression = condition.expression.bind(ndrSpace);
+  condition.predicate = llvm::CmpInst::ICMP_SLT;
+  std::vector<CompiledCondition> conditions(1, condition);
+
+  WarpSimulator simulator(&ndrSpace, hwConfig, threadPool);
+  std::vector<Warp> warps = getAllWarps();
+  WarpSimulator::ActiveMasks masks;
+
+  for (auto counter :
+       {WarpSimulator::TRANSACTIONS, WarpSimulator::BANK_CONFLICTS}) {
+    masks.reset();
+    int expected = simulator.countAccesses(warps, subscript, conditions, masks,
+                                           counter);
+    EXPECT_EQ(simulator.countSliceAccesses(warps, affineSlice, counter),
+              expected);
+    EXPECT_EQ(simulator.countSliceAccessesInNDRange(affineSlice, counter),
+              expected);
+  }
+}
+
+TEST_F(WarpSimulatorTest, NonAffineSlice) {
+  std::vector<Warp> warps = getAllWarps();
+  int expected = 0;
+  for (const Warp &warp : warps) {
+    int64_t addresses[64];
+    int addressNumber = 0;
+    for (auto iter = warp.begin(), iterEnd = warp.end(); iter != iterEnd;
+         ++iter)
+      addresses[addressNumber++] =
+          4 * ((*iter).getGlobalX() ^ (*iter).getGlobalY());
+    expected +=
+        computeTransactionNumberImpl(addresses, addressNumber, hwConfig);
+  }
+
+  WarpSimulator simulator(&ndrSpace, hwConfig, threadPool);
+  EXPECT_EQ(simulator.countSliceAccessesInNDRange(xorSlice,
+                                                  WarpSimulator::TRANSACTIONS),
+            expected);
+}
+
+// 4 * (1024 / get_local_id(0)): the first lane of every warp of the first
+// column divides by zero and does not access memory.
+TEST_F(WarpSimulatorTest, DivisionByZero) {
+  CompiledExpression subscript;
+  subscript.appendConstant(4);
+  subscript.appendConstant(1024);
+  subscript.appendCoordinate(CompiledExpression::LOCAL_ID, 0);
+  subscript.appendOperation(CompiledExpression::UDIV, 2);
+  subscript.appendOperation(CompiledExpression::MUL, 2);
+  subscript = subscript.bind(ndrSpace);
+
+  std::vector<Warp> warps = getAllWarps();
+  WarpSimulator simulator(&ndrSpace, hwConfig, threadPool);
+  WarpSimulator::ActiveMasks masks;
+  for (auto counter :
+       {WarpSimulator::TRANSACTIONS, WarpSimulator::BANK_CONFLICTS}) {
+    int expected = 0;
+    for (const Warp &warp : warps) {
+      int64_t addresses[64];
+      int addressNumber = 0;
+      for (auto iter = warp.begin(), iterEnd = warp.end(); iter != iterEnd;
+           ++iter)
+        if ((*iter).getLocalX() != 0)
+          addresses[addressNumber++] = 4 * (1024 / (*iter).getLocalX());
+      expected += counter.countBatch == computeTransactionNumbers
+                      ? computeTransactionNumberImpl(addresses, addressNumber,
+                                                     hwConfig)
+                      : computeBankConflictNumberImpl(addresses, addressNumber,
+                                                      hwConfig);
+    }
+
+    masks.reset();
+    EXPECT_EQ(simulator.countAccesses(warps, subscript,
+                                      std::vector<CompiledCondition>(), masks,
+                                      counter),
+              expected);
+    masks.reset();
+    EXPECT_EQ(simulator.countAccessesInNDRange(
+                  subscript, std::vector<CompiledCondition>(), masks, counter),
+              expected);
+  }
+}
+
+// 4 * 256 * get_global_id(0) over 2^26 groups: the counts repeat from one
+// group to the next, only the masks of one group are computed. Every warp
+// makes 32 transactions.
+TEST_F(WarpSimulatorTest, SparseActiveMasks) {
+  NDRangeSpace largeSpace(32, 1, 1, 8192, 8192, 1);
+  CompiledExpression subscript;
+  subscript.appendConstant(1024);
+  subscript.appendCoordinate(CompiledExpression::GLOBAL_ID, 0);
+  subscript.appendOperation(CompiledExpression::MUL, 2);
+  subscript = subscript.bind(largeSpace);
+
+  WarpSimulator simulator(&largeSpace, hwConfig, threadPool);
+  WarpSimulator::ActiveMasks masks;
+  simulator.countAccessesInNDRange(subscript, std::vector<CompiledCondition>(),
+                                   masks, WarpSimulator::TRANSACTIONS);
+  EXPECT_EQ(masks.masks.size(), 1u);
+}
+
+// Same as above: 2^31 transactions in total, more than an int holds.
+TEST_F(WarpSimulatorTest, SaturatedCount) {
+  NDRangeSpace largeSpace(32, 1, 1, 8192, 8192, 1);
+  CompiledExpression subscript;
+  subscript.appendConstant(1024);
+  subscript.appendCoordinate(CompiledExpression::GLOBAL_ID, 0);
+  subscript.appendOperation(CompiledExpression::MUL, 2);
+  subscript = subscript.bind(largeSpace);
+
+  WarpSimulator simulator(&largeSpace, hwConfig, threadPool);
+  WarpSimulator::ActiveMasks masks;
+  EXPECT_EQ(simulator.countAccessesInNDRange(subscript,
+                                             std::vector<CompiledCondition>(),
+                                             masks, WarpSimulator::TRANSACTIONS),
+            std::numeric_limits<int>::max());
+}
+
+// get_global_id(0) - 8 <u 16, as BlockMask compiles it:
+// umax(get_global_id(0) - 8, 16) - (get_global_id(0) - 8) != 0.
+TEST_F(WarpSimulatorTest, UnsignedCondition) {
+  CompiledExpression difference;
+  difference.appendCoordinate(CompiledExpression::GLOBAL_ID, 0);
+  difference.appendConstant(-8);
+  difference.appendOperation(CompiledExpression::ADD, 2);
+
+  CompiledCondition condition;
+  condition.expression.appendExpression(difference);
+  condition.expression.appendConstant(16);
+  condition.expression.appendOperation(CompiledExpression::UMAX, 2);
+  condition.expression.appendConstant(-1);
+  condition.expression.appendExpression(difference);
+  condition.expression.appendOperation(CompiledExpression::MUL, 2);
+  condition.expression.appendOperation(CompiledExpression::ADD, 2);
+  condition.expression = condition.expression.bind(ndrSpace);
+  condition.predicate = llvm::CmpInst::ICMP_NE;
+
+  WarpFactory factory(&ndrSpace, hwConfig.warpSize);
+  Warp warp = factory.createWarp(0, 0, 0, 0);
+  for (auto iter = warp.begin(), iterEnd = warp.end(); iter != iterEnd;
+       ++iter) {
+    int64_t value = 0;
+    ASSERT_TRUE(condition.expression.evaluate(*iter, value));
+    int64_t x = (*iter).getGlobalX();
+    EXPECT_EQ(BlockCondition::getBooleanValue(value, condition.predicate),
+              x >= 8 && x < 24);
+  }
+
+  // The difference alone only decides signed comparisons.
+  EXPECT_TRUE(BlockCondition::getBooleanValue(0, llvm::CmpInst::ICMP_SGE));
+  EXPECT_FALSE(BlockCondition::getBooleanValue(0, llvm::CmpInst::ICMP_SGT));
+  EXPECT_FALSE(BlockCondition::getBooleanValue(-1, llvm::CmpInst::ICMP_ULT));
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
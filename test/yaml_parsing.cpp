@@ -12,6 +12,24 @@ TEST(OCLEnvTest, HardwareConfigTest) {
   EXPECT_EQ(hwConfig.warpSize, 45);
 }
 
+TEST(OCLEnvTest, HardwareProfilesTest) {
+  EXPECT_TRUE(readHardwareProfiles("test_hw_config.yaml").empty());
+
+  std::vector<HardwareProfile> profiles =
+      readHardwareProfiles("test_hw_profiles.yaml");
+  ASSERT_EQ(profiles.size(), 2);
+  EXPECT_TRUE(profiles[0].name == "fermi");
+  EXPECT_EQ(profiles[0].config.warpSize, 32);
+  EXPECT_EQ(profiles[0].config.cacheLineSize, 128);
+  EXPECT_TRUE(profiles[1].name == "gcn");
+  EXPECT_EQ(profiles[1].config.warpSize, 64);
+  EXPECT_EQ(profiles[1].config.cacheLineSize, 64);
+
+  // Single configuration readers take the first profile.
+  HardwareConfig hwConfig = readHardwareConfig("test_hw_profiles.yaml");
+  EXPECT_EQ(hwConfig.warpSize, 32);
+}
+
 TEST(OCLEnvTest, KernelArgumentsTest) {
   KernelArgumentsVector argVector = readKernelArguments("test_kernel_arg.yaml");
   EXPECT_EQ(argVector.size(), 3);
@@ -54,6 +72,39 @@ TEST(OCLEnvTest, OpenCLConfig) {
   EXPECT_EQ(warp.warpIndex, 42); 
 }
 
+TEST(OCLEnvTest, KernelFormulasTest) {
+  KernelFormulas formulas = readKernelFormulas("test_kernel_formulas.yaml");
+  EXPECT_TRUE(formulas.kernelName == "testKernel");
+  ASSERT_EQ(formulas.accesses.size(), 1);
+
+  const AccessFormula &formula = formulas.accesses[0];
+  EXPECT_TRUE(formula.isLoad);
+  EXPECT_FALSE(formula.isLocal);
+  EXPECT_TRUE(formula.subscript.toString() == "4 gid0 mul2");
+  ASSERT_EQ(formula.blockConditions.size(), 2);
+  EXPECT_EQ(formula.blockConditions[0].predicate, llvm::CmpInst::ICMP_SLT);
+  EXPECT_EQ(formula.blockConditions[1].predicate, llvm::CmpInst::FCMP_TRUE);
+
+  // Predicates are written by name and read back.
+  std::string text;
+  raw_string_ostream stream(text);
+  yaml::Output yout(stream);
+  yout << formulas;
+  stream.flush();
+  EXPECT_NE(text.find(" slt\n"), std::string::npos);
+
+  KernelFormulas readFormulas;
+  yaml::Input yin(text);
+  yin >> readFormulas;
+  ASSERT_FALSE(yin.error());
+  ASSERT_EQ(readFormulas.accesses.size(), 1);
+  ASSERT_EQ(readFormulas.accesses[0].blockConditions.size(), 2);
+  EXPECT_EQ(readFormulas.accesses[0].blockConditions[0].predicate,
+            llvm::CmpInst::ICMP_SLT);
+  EXPECT_EQ(readFormulas.accesses[0].blockConditions[1].predicate,
+            llvm::CmpInst::FCMP_TRUE);
+}
+
 int main(int argc, char **argv) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
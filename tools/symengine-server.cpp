@@ -0,0 +1,262 @@
+#include "SymEngine/AccessFormula.h"
+#include "SymEngine/FormulaCache.h"
+#include "SymEngine/HardwareConfig.h"
+#include "SymEngine/ModulePipeline.h"
+#include "SymEngine/NDRangeSpace.h"
+#include "SymEngine/ThreadPool.h"
+#include "SymEngine/WarpEvaluator.h"
+#include "SymEngine/YAMLReader.h"
+
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/PrettyStackTrace.h"
+#include "llvm/Support/Signals.h"
+#include "llvm/Support/YAMLTraits.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <thread>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace llvm;
+using namespace SymEngine;
+
+static cl::opt<std::string> socketPath(cl::Positional, cl::Required,
+                                       cl::desc("<socket path>"));
+
+static cl::opt<unsigned int> inlineThreshold(
+    "symbolic-inline-threshold", cl::init(DEFAULT_INLINE_THRESHOLD),
+    cl::desc("Threshold for inlining the functions called by the kernels"));
+
+static cl::opt<unsigned int> serverThreads(
+    "server-threads", cl::init(0),
+    cl::desc("Number of threads simulating the requests (0: all cores)"));
+
+// =============================================================================
+// A request is a YAML document ended by "..." on its own line. The NDRange
+// and the hardware have the keys of opencl_config.yaml and
+// hardware_config.yaml:
+//
+// module: mt.ll
+// kernel: mt
+// ndRange:
+//   localSize: [16, 16, 1]
+//   numberOfGroups: [64, 64, 1]
+// args: [1024, 1024]
+// hardware:
+//   local_memory_bank_number: 32
+//   local_memory_bank_width: 4
+//   warp_size: 32
+//   cache_line_size: 128
+// ...
+//
+// module can be omitted for kernels of a module loaded before. The response
+// is a YAML document with either the results of the kernel, as written by
+// the pass, or an error.
+namespace SymEngine {
+
+struct ServerRequest {
+  std::string module;
+  std::string kernel;
+  NDRangeStruct ndRange;
+  std::vector<int> args;
+  HardwareConfig hardware;
+};
+
+struct ServerResponse {
+  std::string error;
+  KernelResults results;
+};
+
+}
+
+namespace llvm {
+namespace yaml {
+
+template <> struct MappingTraits<ServerRequest> {
+  static void mapping(IO &io, ServerRequest &request) {
+    io.mapOptional("module", request.module);
+    io.mapRequired("kernel", request.kernel);
+    io.mapRequired("ndRange", request.ndRange);
+    io.mapOptional("args", request.args);
+    io.mapRequired("hardware", request.hardware);
+  }
+};
+
+template <> struct MappingTraits<ServerResponse> {
+  static void mapping(IO &io, ServerResponse &response) {
+    if (response.error.empty())
+      io.mapRequired("results", response.results);
+    else
+      io.mapRequired("error", response.error);
+  }
+};
+
+}
+}
+
+//------------------------------------------------------------------------------
+// Returns the error message, empty if the kernel has been evaluated.
+static std::string evaluateRequest(const ServerRequest &request,
+                                   FormulaCache &cache, ThreadPool &threadPool,
+                                   KernelResults &results) {
+  const NDRangeStruct &ndRange = request.ndRange;
+  if (ndRange.localSize.size() != 3 || ndRange.numberOfGroups.size() != 3)
+    return "the NDRange needs 3 local sizes and 3 numbers of groups";
+  for (int direction = 0; direction < 3; ++direction)
+    if (ndRange.localSize[direction] <= 0 ||
+        ndRange.numberOfGroups[direction] <= 0)
+      return "the sizes of the NDRange must be positive";
+
+  const HardwareConfig &hwConfig = request.hardware;
+  if (hwConfig.warpSize <= 0 ||
+      hwConfig.warpSize > LaneCoordinates::MAX_LANE_NUMBER)
+    return "unsupported warp size";
+  if (hwConfig.banksNumber <= 0 || hwConfig.bankWidth <= 0 ||
+      hwConfig.cacheLineSize <= 0)
+    return "the sizes of the hardware must be positive";
+
+  std::string error;
+  std::shared_ptr<const KernelFormulas> kernel =
+      cache.getKernel(request.module, request.kernel, error);
+  if (kernel == nullptr)
+    return error;
+
+  NDRangeSpace ndrSpace(ndRange.localSize[0], ndRange.localSize[1],
+                        ndRange.localSize[2], ndRange.numberOfGroups[0],
+                        ndRange.numberOfGroups[1], ndRange.numberOfGroups[2]);
+  std::vector<int64_t> arguments(request.args.begin(), request.args.end());
+  results =
+      evaluateKernelFormulas(*kernel, arguments, &ndrSpace, hwConfig,
+                             threadPool);
+  return "";
+}
+
+//------------------------------------------------------------------------------
+static std::string handleRequest(const std::string &text, FormulaCache &cache,
+                                 ThreadPool &threadPool) {
+  ServerRequest request;
+  request.hardware = {0, 0, 0, 0};
+  ServerResponse response;
+  response.results.sampling = false;
+
+  yaml::Input yin(text);
+  yin >> request;
+  if (yin.error())
+    response.error = "malformed request";
+  else
+    response.error =
+        evaluateRequest(request, cache, threadPool, response.results);
+
+  std::string output;
+  raw_string_ostream stream(output);
+  yaml::Output yout(stream);
+  yout << response;
+  return stream.str();
+}
+
+//------------------------------------------------------------------------------
+static bool writeAll(int connection, const std::string &text) {
+  size_t written = 0;
+  while (written < text.size()) {
+    ssize_t size =
+        write(connection, text.data() + written, text.size() - written);
+    if (size < 0 && errno == EINTR)
+      continue;
+    if (size <= 0)
+      return false;
+    written += size;
+  }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Answer the requests of a client, one after the other, until it disconnects.
+static void serveConnection(int connection, FormulaCache &cache,
+                            ThreadPool &threadPool) {
+  std::string buffer;
+  char chunk[4096];
+  while (true) {
+    ssize_t size = read(connection, chunk, sizeof(chunk));
+    if (size < 0 && errno == EINTR)
+      continue;
+    if (size <= 0)
+      break;
+    buffer.append(chunk, size);
+
+    // The end marker is "..." on its own line.
+    size_t end;
+    while ((end = ("\n" + buffer).find("\n...\n")) != std::string::npos) {
+      std::string response =
+          handleRequest(buffer.substr(0, end), cache, threadPool);
+      buffer.erase(0, end + 4);
+      if (!writeAll(connection, response)) {
+        close(connection);
+        return;
+      }
+    }
+  }
+  close(connection);
+}
+
+//------------------------------------------------------------------------------
+int main(int argc, char **argv) {
+  sys::PrintStackTraceOnErrorSignal();
+  PrettyStackTraceProgram stackTrace(argc, argv);
+  llvm_shutdown_obj shutdown;
+
+  initializePipeline();
+
+  cl::ParseCommandLineOptions(argc, argv, "SymEngine analysis server\n");
+
+  sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (socketPath.size() >= sizeof(address.sun_path)) {
+    errs() << "Socket path too long: " << socketPath << "\n";
+    return 1;
+  }
+  strcpy(address.sun_path, socketPath.c_str());
+
+  unlink(socketPath.c_str());
+  int server = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (server < 0 ||
+      bind(server, reinterpret_cast<sockaddr *>(&address), sizeof(address)) !=
+          0 ||
+      listen(server, SOMAXCONN) != 0) {
+    errs() << "Cannot listen on " << socketPath << ": " << strerror(errno)
+           << "\n";
+    return 1;
+  }
+
+  // Clients disconnecting before their response is written must not stop
+  // the server.
+  signal(SIGPIPE, SIG_IGN);
+
+  // Every client has its own thread; the simulations of all the clients share
+  // the pool.
+  FormulaCache cache(inlineThreshold);
+  ThreadPool threadPool(serverThreads);
+  while (true) {
+    int connection = accept(server, nullptr, nullptr);
+    if (connection < 0) {
+      if (errno == EINTR)
+        continue;
+      errs() << "Cannot accept connections: " << strerror(errno) << "\n";
+      break;
+    }
+    std::thread(serveConnection, connection, std::ref(cache),
+                std::ref(threadPool))
+        .detach();
+  }
+
+  close(server);
+  return 1;
+}
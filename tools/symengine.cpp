@@ -0,0 +1,62 @@
+#include "SymEngine/ModulePipeline.h"
+#include "SymEngine/SymbolicExecution.h"
+
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/PrettyStackTrace.h"
+#include "llvm/Support/Signals.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <memory>
+#include <string>
+
+using namespace llvm;
+using namespace SymEngine;
+
+static cl::list<std::string>
+    inputFiles(cl::Positional, cl::OneOrMore,
+               cl::desc("<input LLVM IR or bitcode files>"));
+
+static cl::opt<unsigned int> inlineThreshold(
+    "symbolic-inline-threshold", cl::init(DEFAULT_INLINE_THRESHOLD),
+    cl::desc("Threshold for inlining the functions called by the kernels"));
+
+//------------------------------------------------------------------------------
+// Run on the module in fileName the same pipeline as scripts/symEngine.sh:
+// mem2reg, inline, instnamer and the symbolic execution. The results are
+// dumped by SymbolicExecution, one YAML document per module.
+static bool analyzeFile(const std::string &fileName) {
+  // Every module has its own context, released once it is analyzed.
+  LLVMContext context;
+  std::string error;
+  std::unique_ptr<Module> module = loadModule(fileName, context, error);
+  if (!module) {
+    errs() << error;
+    return false;
+  }
+
+  runPipeline(*module, new SymbolicExecution(), inlineThreshold);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+int main(int argc, char **argv) {
+  sys::PrintStackTraceOnErrorSignal();
+  PrettyStackTraceProgram stackTrace(argc, argv);
+  llvm_shutdown_obj shutdown;
+
+  initializePipeline();
+
+  cl::ParseCommandLineOptions(
+      argc, argv, "SymEngine: symbolic execution of OpenCL kernels\n");
+
+  // The config files are read once and shared by all the inputs.
+  int result = 0;
+  for (const std::string &fileName : inputFiles)
+    if (!analyzeFile(fileName))
+      result = 1;
+  return result;
+}